@@ -0,0 +1,240 @@
+#ifndef APU_H
+#define APU_H
+
+#include "blip_buffer.h"
+#include "utility.h"
+#include <array>
+#include <functional>
+#include <vector>
+
+/*
+
+https://www.nesdev.org/wiki/APU
+
+2A03 sound: two pulse channels, triangle, noise, DMC and the frame counter.
+
+catch up model. nothing runs per cycle, every register access carries the cpu
+cycle it happens on and the apu first brings itself up to that cycle. each
+channel steps from one timer event to the next and hands the cycles where its
+level changes to the Blip_Buffer, silent channels skip straight to the end.
+
+mixing uses the linear approximation from the wiki so every channel can feed
+the buffer on its own
+
+    pulse = 0.00752 * (pulse1 + pulse2)
+    tnd   = 0.00851 * triangle + 0.00494 * noise + 0.00335 * dmc
+
+$4000 - $4003  pulse 1         $4010 - $4013  dmc
+$4004 - $4007  pulse 2         $4015          status / channel enable
+$4008 - $400B  triangle        $4017          frame counter
+$400C - $400F  noise
+
+stems: with enable_stems () each channel also feeds a Blip_Buffer of its own
+(same weights, so the stems add up to the mix) for capturing them separately.
+that is a second add_delta per level change, so it is off unless asked for.
+
+DMC sample fetches go through the dmc read callback, the cpu stall they cause
+is not modelled here.
+
+*/
+
+namespace APU
+{
+    class RP2A03
+    {
+    public:
+
+        using dmc_read_cb = std::function <u8 (const u16)>;
+
+        enum class Channel
+        {
+            PULSE_1,
+            PULSE_2,
+            TRIANGLE,
+            NOISE,
+            DMC,
+
+            COUNT,
+        };
+
+        // NTSC, 21.477272 MHz / 12
+        static constexpr double cpu_clock = 39375000.0 / 22.0;
+
+        RP2A03 (const double sample_rate = 48000.0, dmc_read_cb dmc_read = nullptr);
+
+        void reset ();
+
+        // $4000 - $4017
+        void write (const u16 address, const u8 data, const u64 cycle);
+
+        // $4015, clears the frame interrupt
+        u8 read_status (const u64 cycle);
+
+        // runs up to cycle and makes all samples before it readable from get_output ()
+        void end_frame (const u64 cycle);
+
+        bool irq_pending (const u64 cycle);
+
+        // cycle the frame counter or the end of a dmc sample raises an interrupt next, ~0 if neither will
+        u64 get_next_irq () const;
+
+        Blip_Buffer& get_output ();
+
+        // output rate of the mix and the stems, can be nudged between frames
+        void set_sample_rate (const double sample_rate);
+
+        void enable_stems (const bool enable);
+        bool has_stems () const;
+
+        // only valid while stems are enabled, has to be read every frame like the mix
+        Blip_Buffer& get_stem (const Channel channel);
+
+        void set_dmc_read (dmc_read_cb dmc_read);
+
+    private:
+
+        // a channel's last reported level and what one step of it is worth in the mix
+        struct Output
+        {
+            int level;
+            int weight;
+            Blip_Buffer* stem; // nullptr unless stems are enabled
+
+            void update (Blip_Buffer& blip, const u32 time, const int new_level);
+        };
+
+        struct Envelope
+        {
+            bool start;
+            bool loop;
+            bool constant;
+            u8   period;
+            u8   divider;
+            u8   decay;
+
+            void clock ();
+            int  volume () const;
+        };
+
+        struct Pulse
+        {
+            Output   output;
+            Envelope envelope;
+
+            bool ones_complement; // pulse 1 negates with an extra -1
+            bool enabled;
+            bool halt;
+            u8   duty;
+            u8   length;
+            u16  timer;
+            u8   phase;
+            u32  delay;  // cycles until the next sequencer step
+
+            bool sweep_enabled;
+            bool sweep_negate;
+            bool sweep_reload;
+            u8   sweep_period;
+            u8   sweep_shift;
+            u8   sweep_divider;
+
+            int  sweep_target () const;
+            bool muted () const;
+            void clock_sweep ();
+            void clock_length ();
+            void run (Blip_Buffer& blip, const u32 start, const u32 end);
+        };
+
+        struct Triangle
+        {
+            Output output;
+
+            bool enabled;
+            bool control; // also the length counter halt
+            bool linear_reload;
+            u8   linear_period;
+            u8   linear;
+            u8   length;
+            u16  timer;
+            u8   phase;
+            u32  delay;
+
+            void clock_linear ();
+            void clock_length ();
+            void run (Blip_Buffer& blip, const u32 start, const u32 end);
+        };
+
+        struct Noise
+        {
+            Output   output;
+            Envelope envelope;
+
+            bool enabled;
+            bool halt;
+            bool mode;
+            u8   period;
+            u8   length;
+            u16  shift;
+            u32  delay;
+
+            void clock_length ();
+            void run (Blip_Buffer& blip, const u32 start, const u32 end);
+        };
+
+        struct DMC
+        {
+            Output output;
+
+            bool irq_enabled;
+            bool loop;
+            bool irq;
+            u8   rate;
+            u16  sample_address;
+            u16  sample_length;
+            u16  address;
+            u16  bytes_remaining;
+            u8   sample_buffer;
+            bool buffer_full;
+            u8   shift;
+            u8   bits_remaining;
+            bool silence;
+            u32  delay;
+
+            void restart ();
+            void fetch (const dmc_read_cb& read);
+            void run (Blip_Buffer& blip, const dmc_read_cb& read, const u32 start, const u32 end);
+        };
+
+        Blip_Buffer blip;
+        std::vector <Blip_Buffer> stems;
+        double sample_rate;
+        dmc_read_cb dmc_read;
+
+        Pulse    pulse_1;
+        Pulse    pulse_2;
+        Triangle triangle;
+        Noise    noise;
+        DMC      dmc;
+
+        u64 time;        // cycle everything has been run up to
+        u64 frame_start; // cycle of time 0 in the blip buffer
+
+        // frame counter
+        bool five_step;
+        bool irq_inhibit;
+        bool frame_irq;
+        int  frame_step;
+        u64  sequence_start;
+        u64  next_step;
+
+        std::array <Output*, static_cast <std::size_t> (Channel::COUNT)> outputs ();
+        void connect_stems ();
+
+        void run_until (const u64 cycle);
+        void run_channels (const u64 end);
+        void clock_frame_counter ();
+        void quarter_frame ();
+        void half_frame ();
+    };
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef AUDIO_CAPTURE_H
+#define AUDIO_CAPTURE_H
+
+#include "apu.h"
+#include "capture_writer.h"
+#include "utility.h"
+#include "wav_file.h"
+#include <array>
+#include <atomic>
+#include <optional>
+#include <span>
+#include <string>
+
+/*
+
+audio capture for regression diffs
+
+the emulation thread copies samples into fixed size blocks of a preallocated
+ring and returns, a writer thread (Capture_Writer) owns the files and does all
+the disk i/o, so submitting never allocates or touches the disk. the mix goes
+to path, with stems enabled each apu channel also goes to its own file next to
+it (name_pulse1.wav, ...), read straight out of the channel's Blip_Buffer into
+ring blocks.
+
+a second of mono 48 kHz is 94 KB, the writer keeps up with uncapped runs
+easily, so BLOCK (wait for a free block) is the default and a capture is
+always complete. DROP never waits and counts what it throws away instead.
+
+*/
+
+namespace APU
+{
+    class Audio_Capture
+    {
+    public:
+
+        enum class Track : u8
+        {
+            MIX,
+            PULSE_1,
+            PULSE_2,
+            TRIANGLE,
+            NOISE,
+            DMC,
+
+            COUNT,
+        };
+
+        // BLOCK: submit () waits for the writer, DROP: blocks that don't fit are counted and lost
+        using Policy = Capture_Policy;
+
+        static constexpr std::size_t block_samples = 1024;
+        static constexpr std::size_t ring_size     = 256;   // 512 KB, over 5 s of one track at 48 kHz
+
+        // throws std::runtime_error if an output can't be created
+        Audio_Capture (const std::string& path, const int sample_rate, const Wav_File::Format format = Wav_File::Format::WAV, const bool stems = false, const Policy policy = Policy::BLOCK);
+
+        // writes out whatever is still queued and patches the headers
+        ~Audio_Capture ();
+
+        Audio_Capture (const Audio_Capture&) = delete;
+        Audio_Capture& operator= (const Audio_Capture&) = delete;
+
+        // false if anything was dropped
+        bool submit (const Track track, std::span <const i16> samples);
+
+        // reads every stem the apu produced this frame, needs apu.enable_stems (true)
+        bool submit_stems (RP2A03& apu);
+
+        bool has_stems () const;
+
+        u64  get_samples_written () const;  // all tracks
+        u64  get_blocks_dropped () const;
+        bool has_failed () const;
+
+    private:
+
+        struct Block
+        {
+            std::array <i16, block_samples> samples;
+            u16   count;
+            Track track;
+        };
+
+        // only touched by the writer after construction
+        std::array <std::optional <Wav_File>, static_cast <std::size_t> (Track::COUNT)> files;
+
+        std::atomic <u64>  samples_written;
+        std::atomic <bool> failed;
+
+        Capture_Writer <Block, ring_size> writer;
+
+        bool write_block (const Block& block);
+        void close_files ();
+    };
+}
+
+#endif
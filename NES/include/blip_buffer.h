@@ -0,0 +1,76 @@
+#ifndef BLIP_BUFFER_H
+#define BLIP_BUFFER_H
+
+#include "utility.h"
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/*
+
+band limited step synthesis (the blip_buf idea)
+
+http://www.slack.net/~ant/bl-synth/
+
+the apu never generates samples at the cpu clock. channels only report the
+cycles at which their output changes and by how much, add_delta () drops a
+band limited step (an integrated windowed sinc, picked from a table of
+sub sample phases) into a buffer of derivatives at the matching output sample
+position, and read_samples () integrates it back into a waveform. a square
+wave costs one add_delta per edge instead of ~37 clocks per output sample.
+
+times are cpu cycles since the last end_frame ().
+
+*/
+
+namespace APU
+{
+    class Blip_Buffer
+    {
+    public:
+
+        static constexpr int phase_bits  = 6;   // sub sample resolution of a step
+        static constexpr int half_width  = 8;   // kernel is 16 taps
+        static constexpr int kernel_bits = 15;  // taps are fixed point, sum to 1 << kernel_bits
+        static constexpr int bass_shift  = 9;   // dc blocker, about 15 Hz at 48 kHz
+
+        Blip_Buffer (const double clock_rate, const double sample_rate, const std::size_t max_samples = 4096);
+
+        // can be changed between frames, a fractional sample_rate is fine (rate control nudges it)
+        void set_rates (const double clock_rate, const double sample_rate);
+
+        // output jumps by delta at time, deltas past the buffer capacity are dropped
+        void add_delta (const u32 time, const int delta);
+
+        // time becomes 0, everything before it can be read
+        void end_frame (const u32 time);
+
+        std::size_t samples_available () const;
+
+        // returns how many samples were written
+        std::size_t read_samples (std::span <i16> out);
+
+        void clear ();
+
+    private:
+
+        static constexpr int phase_n = 1 << phase_bits;
+        static constexpr int width   = half_width * 2;
+
+        using Kernel = std::array <std::array <i32, width>, phase_n>;
+
+        static const Kernel& get_kernel ();
+
+        const Kernel& kernel;
+
+        u64 factor; // output samples per clock, 32.32 fixed point
+        u64 offset; // fractional sample position of time 0
+        std::size_t available;
+        i32 integrator;
+
+        std::vector <i32> buffer; // capacity + width, the tail holds steps still ringing out
+    };
+}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef CAPTURE_WRITER_H
+#define CAPTURE_WRITER_H
+
+#include "spsc_ring.h"
+#include "utility.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+/*
+
+the part of a capture that is the same whatever it captures
+
+a preallocated ring of N slots between the emulation thread and a writer
+thread. the producer fills a slot in place (acquire, publish) and returns,
+the writer hands every published slot to the capture's process callback in
+order and frees it. when the ring is full acquire () either waits for the
+writer to free a slot (BLOCK) or gives up and counts the loss (DROP).
+
+both sides sleep on an atomic counter the other one bumps, there is no mutex.
+stop () lets the writer drain whatever is still queued, calls done once and
+joins. the capture has to call it in its own destructor, before anything
+process or done use goes away.
+
+*/
+
+enum class Capture_Policy
+{
+    BLOCK, // backpressure, acquire () waits for the writer
+    DROP,  // acquire () never waits, slots that don't fit are counted and lost
+};
+
+template <typename T, std::size_t N>
+class Capture_Writer
+{
+public:
+
+    // called on the writer for every slot, false if it was thrown away instead of written
+    using Process = std::function <bool (const T&)>;
+
+    // called on the writer once the ring is drained after stop ()
+    using Done = std::function <void ()>;
+
+    Capture_Writer (const Capture_Policy _policy)
+    : ring {std::make_unique <SPSC_Ring <T, N>> ()}
+    , policy {_policy}
+    , submitted {0}
+    , processed {0}
+    , dropped {0}
+    , running {false}
+    {}
+
+    ~Capture_Writer ()
+    {
+        stop ();
+    }
+
+    Capture_Writer (const Capture_Writer&) = delete;
+    Capture_Writer& operator= (const Capture_Writer&) = delete;
+
+    void start (Process _process, Done _done)
+    {
+        process = std::move (_process);
+        done = std::move (_done);
+        running = true;
+        writer = std::thread {&Capture_Writer::work, this};
+    }
+
+    // writes out whatever is still queued
+    void stop ()
+    {
+        if (!writer.joinable ())
+            return;
+
+        running = false;
+
+        // bump the counter the writer sleeps on so it wakes up and sees running
+        submitted.fetch_add (1, std::memory_order_release);
+        submitted.notify_one ();
+        writer.join ();
+    }
+
+    /* PRODUCER */
+
+    // nullptr if the slot was dropped
+    T* acquire ()
+    {
+        T* slot = ring->acquire ();
+
+        while (!slot)
+        {
+            if (policy == Capture_Policy::DROP)
+            {
+                dropped.fetch_add (1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            const u64 seen = processed.load (std::memory_order_acquire);
+            slot = ring->acquire ();
+            if (!slot)
+                processed.wait (seen, std::memory_order_acquire);
+        }
+
+        return slot;
+    }
+
+    void publish ()
+    {
+        ring->commit ();
+
+        submitted.fetch_add (1, std::memory_order_release);
+        submitted.notify_one ();
+    }
+
+    /* EITHER SIDE */
+
+    u64 get_dropped () const {return dropped.load (std::memory_order_relaxed);}
+
+private:
+
+    std::unique_ptr <SPSC_Ring <T, N>> ring;
+    Capture_Policy policy;
+
+    Process process;
+    Done done;
+
+    std::atomic <u64>  submitted;
+    std::atomic <u64>  processed; // written or given up on, frees a ring slot
+    std::atomic <u64>  dropped;
+    std::atomic <bool> running;
+
+    std::thread writer;
+
+    void work ()
+    {
+        while (true)
+        {
+            if (const T* slot = ring->front ())
+            {
+                if (!process (*slot))
+                    dropped.fetch_add (1, std::memory_order_relaxed);
+
+                ring->release ();
+                processed.fetch_add (1, std::memory_order_release);
+                processed.notify_one ();
+                continue;
+            }
+
+            // drained, only stop once nothing is left
+            if (!running.load (std::memory_order_acquire))
+                break;
+
+            const u64 seen = submitted.load (std::memory_order_acquire);
+            if (!ring->front () && running.load (std::memory_order_acquire))
+                submitted.wait (seen, std::memory_order_acquire);
+        }
+
+        done ();
+    }
+};
+
+#endif
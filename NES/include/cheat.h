@@ -0,0 +1,38 @@
+#ifndef CHEAT_H
+#define CHEAT_H
+
+#include "utility.h"
+#include <string_view>
+
+/*
+
+https://www.nesdev.org/wiki/Game_Genie
+
+cheat codes, decoded into "value at address", optionally only while the
+original byte there equals compare
+
+    Game Genie          6 letters (no compare) or 8 letters, from APZLGITYEOXUKSVN,
+                        always $8000 - $FFFF
+    Pro Action Replay   6 hex digits, 4 address + 2 value, no compare, usually ram
+
+nothing here checks a code on access. rom codes become overlay pages in the
+mapper (Mapper::set_rom_patches), anything below $8000 is a freeze the system
+writes back once per frame.
+
+*/
+
+namespace Cheat
+{
+    struct Code
+    {
+        u16  address;
+        u8   value;
+        bool has_compare;
+        u8   compare;
+    };
+
+    // throws std::runtime_error if text is neither kind of code
+    Code decode (std::string_view text);
+}
+
+#endif
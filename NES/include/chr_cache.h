@@ -0,0 +1,81 @@
+#ifndef CHR_CACHE_H
+#define CHR_CACHE_H
+
+#include "utility.h"
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/*
+
+https://www.nesdev.org/wiki/PPU_pattern_tables
+
+a tile is 16 bytes, 8 bytes of bit plane 0 followed by 8 bytes of bit plane 1
+
+    pixel (x, y) = ((plane_0[y] >> (7 - x)) & 1) | (((plane_1[y] >> (7 - x)) & 1) << 1)
+
+the cache keeps every tile of chr memory decoded into 64 pixel indices (0 - 3),
+one byte per pixel, row major, so the renderer can do straight byte loads.
+
+tiles are keyed by their physical offset in chr memory, not by pattern table
+address, so a mapper bank switch only changes which tiles a pattern table points
+at and never has to throw anything away. only writes to chr ram invalidate.
+
+*/
+
+namespace PPU
+{
+    class CHR_Cache
+    {
+    public:
+
+        static constexpr std::size_t tile_bytes = 16;
+
+        using Tile = std::array <u8, 64>;
+
+        enum Flip : u8
+        {
+            NONE       = 0,
+            HORIZONTAL = 1 << 0,
+            VERTICAL   = 1 << 1,
+            BOTH       = HORIZONTAL | VERTICAL,
+        };
+
+        // with_flips also keeps the H / V / HV variants of each tile for sprites
+        CHR_Cache (std::span <const u8> chr = {}, const bool with_flips = true);
+
+        // same size chr somewhere else (a reloaded rom), decoded tiles stay, invalidate whatever differs
+        void set_chr (std::span <const u8> chr);
+
+        // decodes the tile first if it is dirty
+        const Tile& get_tile (const std::size_t index, const Flip flip = NONE);
+
+        // chr byte at address was written
+        void invalidate (const std::size_t address);
+        void invalidate (const std::size_t begin, const std::size_t end);
+        void invalidate_all ();
+
+        // decode every dirty tile in one pass
+        void rebuild ();
+
+        std::size_t size () const;
+        bool is_dirty (const std::size_t index) const;
+
+        // bumped every time a tile is invalidated, lets viewers find what changed since they last looked
+        u32 get_generation (const std::size_t index) const;
+
+    private:
+
+        std::span <const u8> chr;
+        bool with_flips;
+
+        std::vector <Tile> tiles;
+        std::vector <u64>  dirty; // one bit per tile
+        std::vector <u32>  generation;
+
+        void decode (const std::size_t index);
+    };
+}
+
+#endif
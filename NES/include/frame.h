@@ -0,0 +1,34 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include "utility.h"
+#include <array>
+#include <cstddef>
+
+/*
+
+the ppu's output, kept as 6 bit palette indices (one byte per pixel) instead of
+rgb. that is a quarter of the memory traffic of rgba and consumers that only
+care about the indices never pay for a conversion. turning it into something
+displayable is done by PPU::Palette::convert.
+
+PPUMASK emphasis bits can change mid frame so they are stored per scanline
+
+*/
+
+namespace PPU
+{
+    static constexpr int screen_width  = 256;
+    static constexpr int screen_height = 240;
+
+    struct Frame
+    {
+        alignas (32) std::array <u8, screen_width * screen_height> pixels; // palette index, 0x00 - 0x3F
+        std::array <u8, screen_height> emphasis;                            // PPUMASK bits 5 - 7 (BGR), shifted down
+
+        const u8* get_row (const int y) const {return pixels.data() + static_cast <std::size_t> (y) * screen_width;}
+        u8* get_row (const int y) {return pixels.data() + static_cast <std::size_t> (y) * screen_width;}
+    };
+}
+
+#endif
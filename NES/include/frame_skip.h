@@ -0,0 +1,44 @@
+#ifndef FRAME_SKIP_H
+#define FRAME_SKIP_H
+
+#include "utility.h"
+
+/*
+
+frame skip / turbo
+
+decides which emulated frames are presented: every present_every-th one, the
+first one included. begin_frame () is called once per emulated frame and says
+whether that frame is shown, everything else (whether the ppu composes the
+skipped ones at all, how fast frames are produced, vsync or uncapped) is up to
+whoever drives the loop.
+
+*/
+
+namespace PPU
+{
+    class Frame_Skip
+    {
+    public:
+
+        Frame_Skip (const int present_every = 1);
+
+        // call at the start of every emulated frame, true if this one gets shown
+        bool begin_frame ();
+
+        bool is_presented () const;
+
+        void set_present_every (const int n);
+        int  get_present_every () const;
+
+        u64 get_frame_count () const;
+
+    private:
+
+        int  present_every;
+        u64  frame_count;
+        bool presented;
+    };
+}
+
+#endif
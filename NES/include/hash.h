@@ -0,0 +1,36 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include "utility.h"
+#include <array>
+#include <span>
+#include <string>
+
+/*
+
+checksums for identifying roms (the same CRC32 and SHA-1 the No-Intro and
+NesCartDB databases list for prg + chr)
+
+crc32 is the zlib / png polynomial. with PCLMULQDQ it folds 64 bytes per
+iteration with carry-less multiplies (Intel, "Fast CRC Computation for Generic
+Polynomials Using PCLMULQDQ"), the tail and machines without it use slicing
+by 8, eight table lookups per 8 bytes. can be chained: crc32 (b, crc32 (a)).
+
+sha1 is FIPS 180-4 over a contiguous buffer, on the SHA extensions when the
+cpu has them (sha1rnds4 and friends), the plain 80 round loop otherwise.
+
+*/
+
+namespace Hash
+{
+    using SHA1_Digest = std::array <u8, 20>;
+
+    u32 crc32 (std::span <const u8> data, const u32 crc = 0);
+
+    SHA1_Digest sha1 (std::span <const u8> data);
+
+    // lowercase hex, 40 characters
+    std::string to_hex (const SHA1_Digest& digest);
+}
+
+#endif
@@ -1,43 +1,330 @@
 #ifndef MAPPER_H
 #define MAPPER_H
 
+#include "cheat.h"
+#include "utility.h"
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
 
-#include <cstdint>
+/*
 
-using u8 = std::uint8_t;
-using u16 = std::uint16_t;
-using u32 = std::uint32_t;
+https://www.nesdev.org/wiki/Mapper
+
+cartridge bank switching
+
+reads never go through a virtual call. every mapper publishes where each
+window of the address space currently points
+
+    prg  4 x 8 KB windows   $8000 $A000 $C000 $E000
+    chr  8 x 1 KB windows   $0000 $0400 ... $1C00
+
+and cpu_read / ppu_read index those directly (cpu reads through a table of
+256 byte pages made from the prg windows, see cheats below). the mapper only runs code when
+the cpu writes one of its registers (cpu_write), that is when it recomputes
+the windows. bank numbers are kept alongside the pointers so set_memory ()
+can point everything at a new copy of the rom (debugger patches) without
+losing the current banking.
+
+rom cheats (Game Genie) swap single pages of that table for overlay copies
+with the code's byte written in. a code with a compare value is only applied
+if the byte currently banked in matches, which is decided when the window is
+switched, not on each read. pages without codes point at rom as always.
+
+bank numbers passed to the set_ helpers wrap modulo the bank count, negative
+ones count from the end (-1 is the last bank).
+
+prg ram ($6000 - $7FFF, 8 KB) lives here too since MMC1 and MMC3 can switch
+it off. it is the mapper's own unless set_prg_ram () points it elsewhere
+(a battery save file), writes set a dirty flag the frame loop picks up.
+
+each board class carries its iNES number (id) and is listed once in Boards at
+the end of this file. mapper.cpp registers a factory for every board in it,
+create () looks the number up there, and system.cpp builds its System <M>
+from the same list. the board classes are final so code that knows the
+concrete type (System <M>) gets direct, inlinable calls instead of virtual
+ones.
+
+*/
 
 class Mapper
 {
 public:
 
-    Mapper(const u8 _prg_banks, const u8 _chr_banks);
-    virtual ~Mapper();
+    static constexpr u32 prg_window = 0x2000;
+    static constexpr u32 chr_window = 0x0400;
+
+    enum class Mirroring : u8
+    {
+        HORIZONTAL,
+        VERTICAL,
+        SINGLE_LOW,
+        SINGLE_HIGH,
+        FOUR_SCREEN,
+    };
+
+    using Factory = std::unique_ptr <Mapper> (*) (std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram, const Mirroring mirroring);
+
+    // throws std::runtime_error if no board is registered for id
+    static std::unique_ptr <Mapper> create (const u16 id, std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram, const Mirroring mirroring);
+
+    // false if id is taken already
+    static bool add_factory (const u16 id, Factory factory);
+
+    template <class M>
+    static bool add_factory ()
+    {
+        return add_factory (M::id, [] (std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram, const Mirroring mirroring) -> std::unique_ptr <Mapper>
+        {
+            return std::make_unique <M> (prg, chr, chr_ram, mirroring);
+        });
+    }
+
+    // chr_ram is the same memory as chr when the board has chr ram, empty otherwise
+    Mapper (std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram, const Mirroring mirroring);
+    virtual ~Mapper ();
+
+    Mapper (const Mapper&) = delete;
+    Mapper& operator= (const Mapper&) = delete;
+
+    // $8000 - $FFFF
+    u8 cpu_read (const u16 address) const
+    {
+        return prg_pages[(address >> 8) & 0x7F][address & 0xFF];
+    }
+
+    // $0000 - $1FFF
+    u8 ppu_read (const u16 address) const
+    {
+        return chr_banks[(address >> 10) & 0x07][address & (chr_window - 1)];
+    }
+
+    // false for chr rom, offset is where in chr it landed (for the tile cache)
+    bool ppu_write (const u16 address, const u8 data, u32& offset)
+    {
+        if (chr_ram.empty())
+            return false;
+
+        offset = chr_offsets[(address >> 10) & 0x07] + (address & (chr_window - 1));
+        chr_ram[offset] = data;
+        return true;
+    }
+
+    // $6000 - $7FFF, false while the ram is disabled
+    bool prg_ram_read (const u16 address, u8& data) const;
+    bool prg_ram_write (const u16 address, const u8 data);
+
+    // register writes, $4020 - $FFFF
+    virtual void cpu_write (const u16 address, const u8 data) = 0;
+
+    // power on state
+    virtual void reset () = 0;
+
+    // MMC3 style counters, clocked once per rendered scanline (ppu A12 rise)
+    virtual void clock_scanline ();
+    virtual bool irq_pending () const;
 
-    virtual bool cpu_read  (const u16 address, u32& mapped_address, u8& data) = 0;
-    virtual bool cpu_write (const u16 address, u32& mapped_address, const u8 data = 0) = 0;
+    // boards that set this provide clock_scanlines (count) and scanlines_until_irq (),
+    // System <M> predicts their irq instead of clocking them
+    static constexpr bool scanline_counter = false;
+
+    Mirroring get_mirroring () const;
+
+    // where in prg a cpu address ($8000 - $FFFF) reads from with the current banking
+    u32 prg_offset (const u16 address) const;
+
+    // rom was copied (or patched) somewhere else, keeps the current banking
+    void set_memory (std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram);
+
+    std::span <u8> get_prg_ram ();
+
+    // prg_ram.size() == 0x2000, the mapper's own ram is dropped
+    void set_prg_ram (std::span <u8> prg_ram);
+
+    // true if the ram was written since the last call
+    bool take_prg_ram_dirty ();
+
+    // codes for $8000 - $FFFF, replaces the previous set. others are ignored
+    void set_rom_patches (std::span <const Cheat::Code> patches);
 
 protected:
-    
-    u8 prg_banks;
-    u8 chr_banks;
-    
+
+    std::span <const u8> prg;
+    std::span <const u8> chr;
+    std::span <u8> chr_ram;
+
+    Mirroring mirroring;
+    bool prg_ram_enabled;
+    bool prg_ram_writable;
+
+    u32 prg_bank_n () const;   // 8 KB banks
+    u32 chr_bank_n () const;   // 1 KB banks
+
+    void set_prg_8k  (const int window, const int bank);
+    void set_prg_16k (const int window, const int bank);  // window 0 = $8000, 1 = $C000
+    void set_prg_32k (const int bank);
+
+    void set_chr_1k (const int window, const int bank);
+    void set_chr_2k (const int window, const int bank);   // window in 2 KB steps
+    void set_chr_4k (const int window, const int bank);
+    void set_chr_8k (const int bank);
+
+private:
+
+    std::array <const u8*, 4> prg_banks;
+    std::array <const u8*, 8> chr_banks;
+    std::array <u32, 4> prg_offsets;
+    std::array <u32, 8> chr_offsets;
+
+    // cpu view of $8000 - $FFFF, 256 bytes a page
+    std::array <const u8*, 128> prg_pages;
+
+    std::vector <Cheat::Code> rom_patches;
+    std::vector <std::array <u8, 0x100>> overlays; // one per page, allocated with the first patch
+
+    // window's pages from its bank, with the patches that apply to it
+    void map_prg_pages (const int window);
+
+    std::span <u8> prg_ram;
+    std::vector <u8> prg_ram_owned;
+    bool prg_ram_dirty;
 };
 
 
-class Mapper_000: public Mapper
+// NROM, no banking, 16 KB prg is mirrored
+class Mapper_000 final: public Mapper
 {
 public:
 
-    Mapper_000 (u8 _prg_banks, u8 _chr_banks);
-    ~Mapper_000 ();
+    static constexpr u16 id = 0;
+
+    Mapper_000 (std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram, const Mirroring mirroring);
+
+    void cpu_write (const u16 address, const u8 data) override;
+    void reset () override;
+};
+
 
-    bool cpu_read  (const u16 address, u32& mapped_address, u8& data) override;
-    bool cpu_write (const u16 address, u32& mapped_address, const u8 data = 0) override;
+/*
+    https://www.nesdev.org/wiki/MMC1
+
+    SxROM, registers are loaded one bit at a time through a 5 bit shift
+    register, writing a value with bit 7 set resets it
+
+    $8000  control     CPPMM  chr mode, prg mode, mirroring
+    $A000  chr bank 0
+    $C000  chr bank 1
+    $E000  prg bank    RPPPP  ram disable, 16 KB bank
+
+    512 KB boards (SUROM) use chr bank bit 4 as the outer 256 KB prg bank
+*/
+class Mapper_001 final: public Mapper
+{
+public:
+
+    static constexpr u16 id = 1;
+
+    Mapper_001 (std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram, const Mirroring mirroring);
+
+    void cpu_write (const u16 address, const u8 data) override;
+    void reset () override;
+
+private:
+
+    u8 shift;
+    u8 control;
+    u8 chr_bank_0;
+    u8 chr_bank_1;
+    u8 prg_bank;
+
+    void update_banks ();
+};
+
+
+// UxROM, 16 KB switchable at $8000, last bank fixed at $C000
+class Mapper_002 final: public Mapper
+{
+public:
+
+    static constexpr u16 id = 2;
+
+    Mapper_002 (std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram, const Mirroring mirroring);
+
+    void cpu_write (const u16 address, const u8 data) override;
+    void reset () override;
+};
+
+
+// CNROM, fixed prg, 8 KB switchable chr
+class Mapper_003 final: public Mapper
+{
+public:
+
+    static constexpr u16 id = 3;
+
+    Mapper_003 (std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram, const Mirroring mirroring);
+
+    void cpu_write (const u16 address, const u8 data) override;
+    void reset () override;
+};
+
+
+/*
+    https://www.nesdev.org/wiki/MMC3
+
+    TxROM, even / odd address pairs
+
+    $8000  bank select   CP...RRR  chr a12 inversion, prg mode, register
+    $8001  bank data     R0 R1 2 KB chr, R2 - R5 1 KB chr, R6 R7 8 KB prg
+    $A000  mirroring
+    $A001  prg ram       ER......  enable, write protect
+    $C000  irq latch
+    $C001  irq reload
+    $E000  irq disable (and acknowledge)
+    $E001  irq enable
+*/
+class Mapper_004 final: public Mapper
+{
+public:
+
+    static constexpr u16 id = 4;
+    static constexpr bool scanline_counter = true;
+
+    Mapper_004 (std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram, const Mirroring mirroring);
+
+    void cpu_write (const u16 address, const u8 data) override;
+    void reset () override;
+
+    void clock_scanline () override;
+    bool irq_pending () const override;
+
+    // same as count clock_scanline () calls, without the loop
+    void clock_scanlines (u64 count);
+
+    // clocks until the irq is raised, -1 while it is disabled
+    int scanlines_until_irq () const;
 
 private:
 
+    bool four_screen;
+
+    u8 bank_select;
+    std::array <u8, 8> registers;
+
+    u8   irq_latch;
+    u8   irq_counter;
+    bool irq_reload;
+    bool irq_enabled;
+    bool irq;
+
+    void update_banks ();
 };
 
-#endif
\ No newline at end of file
+// every board there is, a new one is its class plus an entry here
+template <class... M>
+struct Board_List {};
+
+using Boards = Board_List <Mapper_000, Mapper_001, Mapper_002, Mapper_003, Mapper_004>;
+
+#endif
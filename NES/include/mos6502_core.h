@@ -0,0 +1,957 @@
+#ifndef MOS6502_CORE_H
+#define MOS6502_CORE_H
+
+#include "MOS6502.h"
+#include <array>
+
+/*
+
+a MOS6502 running against a bus known at compile time
+
+Core <Bus> calls bus.read () / bus.write () directly, no std::function in
+between, so the bus's memory map inlines into every addressing mode and
+opcode. everything is defined in this header, the owner of the bus
+(System <M>, NSF::Player) includes it in its .cpp and the core gets compiled
+there once per bus, next to it. the opcode itself is still picked through a
+table, one lookup per instruction.
+
+*/
+
+namespace CPU
+{
+    template <class Bus>
+    class Core final : public MOS6502
+    {
+    public:
+
+        explicit Core (Bus& bus);
+
+        // runs one instruction, get_current_cycles () says how long it took
+        void update (void);
+
+        // loads PC from the reset vector
+        void reset (void);
+
+        // interrupt lines, irq is ignored while I is set
+        void nmi (void);
+        void irq (void);
+
+    private:
+
+        struct Step
+        {
+            void (Core::*opcode)(void);
+            int (Core::*mode)(void);
+        };
+
+        Bus& bus;
+
+        void stack_push (const byte val);
+        byte stack_pop (void);
+        void interrupt (const word vector);
+
+        /* OPCODES */
+        void BRK (void); void ORA (void); void ASL (void); void PHP (void); void BPL (void);
+        void CLC (void); void JSR (void); void AND (void); void BIT (void); void ROL (void); 
+        void PLP (void); void BMI (void); void SEC (void); void RTI (void); void EOR (void);
+        void LSR (void); void PHA (void); void JMP (void); void BVC (void); void CLI (void);
+        void RTS (void); void PLA (void); void ADC (void); void ROR (void); void BVS (void);
+        void SEI (void); void STA (void); void STY (void); void STX (void); void DEY (void);
+        void TXA (void); void BCC (void); void TYA (void); void TXS (void); void LDY (void); 
+        void LDA (void); void LDX (void); void TAY (void); void TAX (void); void BCS (void); 
+        void CLV (void); void TSX (void); void CPY (void); void CMP (void); void DEC (void); 
+        void INY (void); void DEX (void); void BNE (void); void CLD (void); void CPX (void); 
+        void SBC (void); void INC (void); void INX (void); void NOP (void); void BEQ (void); 
+        void SED (void); void XXX (void); // XXX = illegal
+
+        /* ADDRESSING MODES */
+        int ACC (void); // accumulator 
+        int ABS (void); // absolute
+        int ABX (void); // absoulte X-indexed
+        int ABY (void); // absolute Y-indexed
+        int IMM (void); // immediate
+        int IMP (void); // implied
+        int IND (void); // indirect
+        int XIZ (void); // X-indexed indirect zeropage address
+        int YIZ (void); // Y-indexed indirect zeropage address
+        int REL (void); // relative
+        int ZPG (void); // zeropage
+        int ZPX (void); // zeropage X-indexed
+        int ZPY (void); // zeropage Y-indexed
+
+        /* LOOKUP TABLE, same layout as instruction_table */
+        using _ = Core;
+        static constexpr std::array<Step, 256> steps
+        {{
+            {&_::BRK, &_::IMP}, {&_::ORA, &_::XIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::ORA, &_::ZPG}, {&_::ASL, &_::ZPG}, {&_::XXX, &_::IMP}, {&_::PHP, &_::IMP}, {&_::ORA, &_::IMM}, {&_::ASL, &_::ACC}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::ORA, &_::ABS}, {&_::ASL, &_::ABS}, {&_::XXX, &_::IMP},
+            {&_::BPL, &_::REL}, {&_::ORA, &_::YIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::ORA, &_::ZPX}, {&_::ASL, &_::ZPX}, {&_::XXX, &_::IMP}, {&_::CLC, &_::IMP}, {&_::ORA, &_::ABY}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::ORA, &_::ABX}, {&_::ASL, &_::ABX}, {&_::XXX, &_::IMP},
+            {&_::JSR, &_::ABS}, {&_::AND, &_::XIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::BIT, &_::ZPG}, {&_::AND, &_::ZPG}, {&_::ROL, &_::ZPG}, {&_::XXX, &_::IMP}, {&_::PLP, &_::IMP}, {&_::AND, &_::IMM}, {&_::ROL, &_::ACC}, {&_::XXX, &_::IMP}, {&_::BIT, &_::ABS}, {&_::AND, &_::ABS}, {&_::ROL, &_::ABS}, {&_::XXX, &_::IMP},
+            {&_::BMI, &_::REL}, {&_::AND, &_::YIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::AND, &_::ZPX}, {&_::ROL, &_::ZPX}, {&_::XXX, &_::IMP}, {&_::SEC, &_::IMP}, {&_::AND, &_::ABY}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::AND, &_::ABX}, {&_::ROL, &_::ABX}, {&_::XXX, &_::IMP},
+            {&_::RTI, &_::IMP}, {&_::EOR, &_::XIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::EOR, &_::ZPG}, {&_::LSR, &_::ZPG}, {&_::XXX, &_::IMP}, {&_::PHA, &_::IMP}, {&_::EOR, &_::IMM}, {&_::LSR, &_::ACC}, {&_::XXX, &_::IMP}, {&_::JMP, &_::ABS}, {&_::EOR, &_::ABS}, {&_::LSR, &_::ABS}, {&_::XXX, &_::IMP},
+            {&_::BVC, &_::REL}, {&_::EOR, &_::YIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::EOR, &_::ZPX}, {&_::LSR, &_::ZPX}, {&_::XXX, &_::IMP}, {&_::CLI, &_::IMP}, {&_::EOR, &_::ABY}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::EOR, &_::ABX}, {&_::LSR, &_::ABX}, {&_::XXX, &_::IMP},
+            {&_::RTS, &_::IMP}, {&_::ADC, &_::XIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::ADC, &_::ZPG}, {&_::ROR, &_::ZPG}, {&_::XXX, &_::IMP}, {&_::PLA, &_::IMP}, {&_::ADC, &_::IMM}, {&_::ROR, &_::ACC}, {&_::XXX, &_::IMP}, {&_::JMP, &_::IND}, {&_::ADC, &_::ABS}, {&_::ROR, &_::ABS}, {&_::XXX, &_::IMP},
+            {&_::BVS, &_::REL}, {&_::ADC, &_::YIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::ADC, &_::ZPX}, {&_::ROR, &_::ZPX}, {&_::XXX, &_::IMP}, {&_::SEI, &_::IMP}, {&_::ADC, &_::ABY}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::ADC, &_::ABX}, {&_::ROR, &_::ABX}, {&_::XXX, &_::IMP},
+            {&_::XXX, &_::IMP}, {&_::STA, &_::XIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::STY, &_::ZPG}, {&_::STA, &_::ZPG}, {&_::STX, &_::ZPG}, {&_::XXX, &_::IMP}, {&_::DEY, &_::IMP}, {&_::XXX, &_::IMP}, {&_::TXA, &_::IMP}, {&_::XXX, &_::IMP}, {&_::STY, &_::ABS}, {&_::STA, &_::ABS}, {&_::STX, &_::ABS}, {&_::XXX, &_::IMP},
+            {&_::BCC, &_::REL}, {&_::STA, &_::YIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::STY, &_::ZPX}, {&_::STA, &_::ZPX}, {&_::STX, &_::ZPY}, {&_::XXX, &_::IMP}, {&_::TYA, &_::IMP}, {&_::STA, &_::ABY}, {&_::TXS, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::STA, &_::ABX}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP},
+            {&_::LDY, &_::IMM}, {&_::LDA, &_::XIZ}, {&_::LDX, &_::IMM}, {&_::XXX, &_::IMP}, {&_::LDY, &_::ZPG}, {&_::LDA, &_::ZPG}, {&_::LDX, &_::ZPG}, {&_::XXX, &_::IMP}, {&_::TAY, &_::IMP}, {&_::LDA, &_::IMM}, {&_::TAX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::LDY, &_::ABS}, {&_::LDA, &_::ABS}, {&_::LDX, &_::ABS}, {&_::XXX, &_::IMP},
+            {&_::BCS, &_::REL}, {&_::LDA, &_::YIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::LDY, &_::ZPX}, {&_::LDA, &_::ZPX}, {&_::LDX, &_::ZPY}, {&_::XXX, &_::IMP}, {&_::CLV, &_::IMP}, {&_::LDA, &_::ABY}, {&_::TSX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::LDY, &_::ABX}, {&_::LDA, &_::ABX}, {&_::LDX, &_::ABY}, {&_::XXX, &_::IMP},
+            {&_::CPY, &_::IMM}, {&_::CMP, &_::XIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::CPY, &_::ZPG}, {&_::CMP, &_::ZPG}, {&_::DEC, &_::ZPG}, {&_::XXX, &_::IMP}, {&_::INY, &_::IMP}, {&_::CMP, &_::IMM}, {&_::DEX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::CPY, &_::ABS}, {&_::CMP, &_::ABS}, {&_::DEC, &_::ABS}, {&_::XXX, &_::IMP},
+            {&_::BNE, &_::REL}, {&_::CMP, &_::YIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::CMP, &_::ZPX}, {&_::DEC, &_::ZPX}, {&_::XXX, &_::IMP}, {&_::CLD, &_::IMP}, {&_::CMP, &_::ABY}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::CMP, &_::ABX}, {&_::DEC, &_::ABX}, {&_::XXX, &_::IMP},
+            {&_::CPX, &_::IMM}, {&_::SBC, &_::XIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::CPX, &_::ZPG}, {&_::SBC, &_::ZPG}, {&_::INC, &_::ZPG}, {&_::XXX, &_::IMP}, {&_::INX, &_::IMP}, {&_::SBC, &_::IMM}, {&_::NOP, &_::IMP}, {&_::XXX, &_::IMP}, {&_::CPX, &_::ABS}, {&_::SBC, &_::ABS}, {&_::INC, &_::ABS}, {&_::XXX, &_::IMP},
+            {&_::BEQ, &_::REL}, {&_::SBC, &_::YIZ}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::SBC, &_::ZPX}, {&_::INC, &_::ZPX}, {&_::XXX, &_::IMP}, {&_::SED, &_::IMP}, {&_::SBC, &_::ABY}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::XXX, &_::IMP}, {&_::SBC, &_::ABX}, {&_::INC, &_::ABX}, {&_::XXX, &_::IMP},
+        }};
+    };
+}
+
+template <class Bus>
+CPU::Core <Bus>::Core (Bus& _bus)
+: bus {_bus}
+{}
+
+template <class Bus>
+void CPU::Core <Bus>::update (void)
+{
+    const byte opcode = bus.read (PC++);
+    const Step& step = steps[opcode];
+
+    current.ins = &instruction_table[opcode];
+    current.cycles = current.ins->cycles;
+
+    const int page_crossed = (this->*step.mode)();
+    (this->*step.opcode)();
+
+    if (page_crossed && has_page_penalty (current.ins->ins.instruction))
+        ++current.cycles;
+
+    // illegal opcodes run as 2 cycle NOPs
+    if (current.cycles == 0)
+        current.cycles = 2;
+
+    cycles += current.cycles;
+}
+
+template <class Bus>
+void CPU::Core <Bus>::reset (void)
+{
+    SP = 0xFD;
+    set_flag (Flag::I, true);
+    PC = bus.read (0xFFFC) | (bus.read (0xFFFD) << 8);
+    cycles += 7;
+}
+
+template <class Bus>
+void CPU::Core <Bus>::nmi (void)
+{
+    interrupt (0xFFFA);
+}
+
+template <class Bus>
+void CPU::Core <Bus>::irq (void)
+{
+    if (!(SR & static_cast <byte> (Flag::I)))
+        interrupt (0xFFFE);
+}
+
+template <class Bus>
+void CPU::Core <Bus>::interrupt (const word vector)
+{
+    stack_push ((PC >> 8) & 0x00FF);
+    stack_push (PC & 0x00FF);
+    stack_push ((SR & ~static_cast <byte> (Flag::B)) | static_cast <byte> (Flag::_));
+    set_flag (Flag::I, true);
+    PC = bus.read (vector) | (bus.read (vector + 1) << 8);
+    cycles += 7;
+}
+
+template <class Bus>
+void CPU::Core <Bus>::stack_push (const byte data)
+{
+    bus.write (stk_begin + SP, data);
+    --SP;
+}
+
+template <class Bus>
+byte CPU::Core <Bus>::stack_pop (void)
+{
+    ++SP;
+    return bus.read (stk_begin + SP);
+}
+
+/* 
+    ADDRESSING MODES 
+
+    some of these functions will return an extra cycle 
+    if a page boundry was crossed
+*/
+
+// accumulator
+template <class Bus>
+int CPU::Core <Bus>::ACC (void)
+{
+    current.data = AC;
+    return 0;
+}
+
+// absolute
+template <class Bus>
+int CPU::Core <Bus>::ABS (void)
+{
+    const byte low = bus.read (PC++);
+    const byte high = bus.read (PC++);
+    current.address = (high << 8) | low;
+    return 0;
+}
+
+// absolute X
+template <class Bus>
+int CPU::Core <Bus>::ABX (void)
+{
+    const byte low = bus.read (PC++);
+    const byte high = bus.read (PC++);
+    current.address = ((high << 8) | low) + X;
+    return (current.address & 0xFF00) != (high << 8) ? 1 : 0;
+}
+
+// absolute Y
+template <class Bus>
+int CPU::Core <Bus>::ABY (void)
+{
+    const byte low = bus.read (PC++);
+    const byte high = bus.read (PC++);
+    current.address = ((high << 8) | low) + Y;
+    return (current.address & 0xFF00) != (high << 8) ? 1 : 0;
+}
+
+// # / immediate 
+template <class Bus>
+int CPU::Core <Bus>::IMM (void)
+{
+    current.address = PC++;
+    return 0;
+}
+
+// implied
+template <class Bus>
+int CPU::Core <Bus>::IMP (void)
+{
+    // does nothing?
+    return 0;
+}
+
+// indirect
+template <class Bus>
+int CPU::Core <Bus>::IND (void)
+{
+    const byte low = bus.read (PC++);
+    const byte high = bus.read (PC++);
+    const word pointer = (high << 8) | low;
+
+    // the high byte is fetched without carrying into the page ($xxFF wraps to $xx00)
+    const word pointer_high = (pointer & 0xFF00) | ((pointer + 1) & 0x00FF);
+    current.address = bus.read (pointer) | (bus.read (pointer_high) << 8);
+    return 0;
+}
+
+// X-indexed indirect zeropage address
+// operand is zeropage address; effective address is word in (LL + X, LL + X + 1), inc. without carry: C.w($00LL + X)
+template <class Bus>
+int CPU::Core <Bus>::XIZ (void)
+{
+    const byte temp = bus.read (PC++);
+    const byte low = bus.read ((temp + X) & 0x00FF);
+    const byte high = bus.read ((temp + X + 1) & 0x00FF);
+    current.address = (high << 8) | low;
+    return 0;
+}
+
+
+// Y-indexed indirect zeropage address
+// operand is zeropage address; effective address is word in (LL, LL + 1) incremented by Y with carry: C.w($00LL) + Y
+template <class Bus>
+int CPU::Core <Bus>::YIZ (void)
+{
+    const byte temp = bus.read (PC++);
+    const byte low = bus.read (temp);
+    const byte high = bus.read ((temp + 1) & 0x00FF);
+    current.address = ((high << 8) | low) + Y;
+    return (current.address & 0xFF00) != (high << 8) ? 1 : 0;
+}
+
+// relative
+// branch target is PC + signed offset BB 
+template <class Bus>
+int CPU::Core <Bus>::REL (void)
+{
+    current.address = bus.read (PC++);
+    current.address |= current.address & 0x80 ? 0xFF00 : 0x0000;
+    return 0;
+}
+
+// zeropage
+template <class Bus>
+int CPU::Core <Bus>::ZPG (void)
+{
+    current.address = bus.read (PC++);
+    return 0;
+}
+
+// zeropage X-indexed
+template <class Bus>
+int CPU::Core <Bus>::ZPX (void)
+{
+    current.address = (bus.read (PC++) + X) & 0x00FF;
+    return 0;
+}
+
+// zeropage Y-indexed
+template <class Bus>
+int CPU::Core <Bus>::ZPY (void)
+{
+    current.address = (bus.read (PC++) + Y) & 0x00FF;
+    return 0;
+}
+
+/* OPCODES */
+
+// break
+template <class Bus>
+void CPU::Core <Bus>::BRK (void)
+{
+    ++PC;
+
+    stack_push ((PC >> 8) & 0x00FF);
+    stack_push (PC & 0x00FF);
+
+    stack_push (SR | static_cast <byte> (Flag::B) | static_cast <byte> (Flag::_));
+
+    set_flag (Flag::I, true);
+
+    PC = bus.read (0xFFFE) | (bus.read (0xFFFF) << 8);
+}
+
+// bitwise OR
+template <class Bus>
+void CPU::Core <Bus>::ORA (void)
+{
+    AC |= bus.read (current.address);
+    set_flag (Flag::Z, AC == 0x00);
+    set_flag (Flag::N, AC & 0x80);
+}
+
+// arithmetic shift left
+template <class Bus>
+void CPU::Core <Bus>::ASL (void)
+{
+    current.data = current.ins->ins.mode == _6502::Mode::ACC ? AC : bus.read (current.address);
+    set_flag (Flag::C, current.data & 0x80);
+    current.data <<= 1;
+    set_flag (Flag::Z, current.data == 0x00);
+    set_flag (Flag::N, current.data & 0x80);
+    if (current.ins->ins.mode == _6502::Mode::ACC)
+        AC = current.data;
+    else
+        bus.write (current.address, current.data);
+}
+
+// push processor status
+template <class Bus>
+void CPU::Core <Bus>::PHP (void)
+{
+    stack_push (SR | static_cast <byte> (Flag::B) | static_cast <byte> (Flag::_));
+}
+
+// branch if plus
+template <class Bus>
+void CPU::Core <Bus>::BPL (void)
+{
+    if (!(static_cast <byte> (Flag::N) & SR))
+    {
+        // branch taken so add a cycle
+        ++current.cycles;
+
+        current.address += PC;
+
+        // page boundry crossed
+        if ((current.address & 0xFF00) != (PC & 0xFF00 ))
+            ++current.cycles;
+            
+        PC = current.address;
+    }
+}
+
+// clear carry
+template <class Bus>
+void CPU::Core <Bus>::CLC (void)
+{
+    SR &= ~static_cast <byte> (Flag::C);
+}
+
+// jump to subroutine
+template <class Bus>
+void CPU::Core <Bus>::JSR (void)
+{
+    --PC;
+    stack_push ((PC >> 8) & 0x00FF);
+    stack_push (PC & 0x00FF);
+    PC = current.address;
+}
+
+// bitwise AND
+template <class Bus>
+void CPU::Core <Bus>::AND (void)
+{
+    AC &= bus.read (current.address);
+    set_flag (Flag::Z, AC == 0x00);
+    set_flag (Flag::N, AC & 0x80);
+}
+
+// bit test
+template <class Bus>
+void CPU::Core <Bus>::BIT (void)
+{
+    current.data = bus.read (current.address);
+
+    set_flag (Flag::Z, (AC & current.data) == 0x00);
+    set_flag (Flag::V, current.data & 0x40);
+    set_flag (Flag::N, current.data & 0x80);
+}
+
+// rotate left
+template <class Bus>
+void CPU::Core <Bus>::ROL (void)
+{
+    current.data = current.ins->ins.mode == _6502::Mode::ACC ? AC : bus.read (current.address);
+
+    const byte carry = SR & static_cast <byte> (Flag::C);
+    set_flag (Flag::C, current.data & 0x80);
+    
+    current.data <<= 1;
+    current.data |= carry;
+    
+    set_flag (Flag::Z, current.data == 0x00);
+    set_flag (Flag::N, current.data & 0x80);
+    
+    if (current.ins->ins.mode == _6502::Mode::ACC)
+        AC = current.data;
+    else
+        bus.write (current.address, current.data);
+}
+
+// pull processor status
+template <class Bus>
+void CPU::Core <Bus>::PLP (void)
+{
+    SR = (stack_pop() & ~static_cast <byte> (Flag::B)) | static_cast <byte> (Flag::_);
+}
+
+// branch if minus
+template <class Bus>
+void CPU::Core <Bus>::BMI (void)
+{
+    if (static_cast <byte> (Flag::N) & SR)
+    {
+        // branch taken so add cycle
+        ++current.cycles;
+
+        current.address += PC;
+
+        // page boundry crossed
+        if ((current.address & 0xFF00) != (PC & 0xFF00))
+            ++current.cycles;
+
+        PC = current.address;
+    }
+}
+
+// set carry
+template <class Bus>
+void CPU::Core <Bus>::SEC (void)
+{
+    set_flag(Flag::C, true);
+}
+
+// return from interrupt
+template <class Bus>
+void CPU::Core <Bus>::RTI (void)
+{
+    SR = stack_pop();
+
+    // these two flags are ignored when returning from the stack
+    SR &= ~static_cast <byte> (Flag::B);
+    SR |= static_cast <byte> (Flag::_);
+
+    PC = stack_pop();
+    PC |= stack_pop() << 8;
+}
+
+// bitwise exclusive OR
+template <class Bus>
+void CPU::Core <Bus>::EOR (void)
+{
+    AC ^= bus.read (current.address);
+    set_flag (Flag::Z, AC == 0x0);
+    set_flag (Flag::N, AC & 0x80);
+}
+
+// logical shift right
+template <class Bus>
+void CPU::Core <Bus>::LSR (void)
+{
+    current.data = current.ins->ins.mode == _6502::Mode::ACC ? AC : bus.read (current.address);
+    set_flag (Flag::C, current.data & 0x01);
+    current.data >>= 1;
+    set_flag (Flag::Z, current.data == 0x00);
+    set_flag (Flag::N, current.data & 0x80);
+    if (current.ins->ins.mode == _6502::Mode::ACC)
+        AC = current.data;
+    else
+        bus.write (current.address, current.data);
+}
+
+// push accumulator
+template <class Bus>
+void CPU::Core <Bus>::PHA (void)
+{
+    stack_push (AC);
+}
+
+// jump
+template <class Bus>
+void CPU::Core <Bus>::JMP (void)
+{
+    PC = current.address;
+}
+
+// branch if overflow clear
+template <class Bus>
+void CPU::Core <Bus>::BVC (void)
+{
+    if (!(static_cast <byte> (Flag::V) & SR))
+    {
+        // branching requires an additional cycle
+        ++current.cycles;
+
+        current.address += PC;
+
+        // page boundry check
+        if ((current.address & 0xFF00) != (PC & 0xFF00))
+            ++current.cycles;
+
+        PC = current.address;
+    }
+}
+
+// clear interrupt disable
+template <class Bus>
+void CPU::Core <Bus>::CLI (void)
+{
+    set_flag (Flag::I, false);
+}
+
+// return from subroutinef
+template <class Bus>
+void CPU::Core <Bus>::RTS (void)
+{
+    const byte low = stack_pop();
+    const byte high = stack_pop();
+    PC = (high << 8) | low;
+    ++PC;
+}
+
+// pull accumulator
+template <class Bus>
+void CPU::Core <Bus>::PLA (void)
+{
+    AC = stack_pop();
+    set_flag (Flag::Z, AC == 0x00);
+    set_flag (Flag::N, AC & 0x80);
+}
+
+// add with carry
+template <class Bus>
+void CPU::Core <Bus>::ADC (void)
+{
+    current.data = bus.read (current.address);
+
+    const word result = AC + current.data + (static_cast <byte> (Flag::C) & SR);
+    
+    set_flag (Flag::C, (result & 0xFF00) != 0);
+    set_flag (Flag::Z, (result & 0x00FF) == 0);
+    set_flag (Flag::V, ~(AC ^ current.data) & (AC ^ result) & 0x0080);
+    set_flag (Flag::N, result & 0x0080);
+    
+    AC = result & 0x00FF;
+}
+
+// rotate right
+template <class Bus>
+void CPU::Core <Bus>::ROR (void)
+{
+    current.data = current.ins->ins.mode == _6502::Mode::ACC ? AC : bus.read (current.address);
+
+    const byte carry = SR & static_cast <byte> (Flag::C);
+    set_flag (Flag::C, current.data & 0x01);
+    
+    current.data >>= 1;
+    current.data |= carry << 7;
+    
+    set_flag (Flag::Z, current.data == 0x00);
+    set_flag (Flag::N, current.data & 0x80);
+
+    if (current.ins->ins.mode == _6502::Mode::ACC)
+        AC = current.data;
+    else
+        bus.write (current.address, current.data);
+}
+
+// branch if overflow set
+template <class Bus>
+void CPU::Core <Bus>::BVS (void)
+{
+    if (SR & static_cast <byte> (Flag::V))
+    {
+        // branch taken cycles added
+        ++current.cycles;
+        
+        current.address += PC;
+
+        // page boundry crossed
+        if ((current.address & 0xFF00) != (PC & 0xFF00))
+            ++current.cycles;
+
+        PC = current.address;
+    }
+}
+
+// set interrupt disable
+template <class Bus>
+void CPU::Core <Bus>::SEI (void)
+{
+    set_flag (Flag::I, true);
+}
+
+template <class Bus>
+void CPU::Core <Bus>::STA (void)
+{
+    bus.write (current.address, AC);
+}
+
+// store Y
+template <class Bus>
+void CPU::Core <Bus>::STY (void)
+{
+    bus.write (current.address, Y);
+}
+
+// store X
+template <class Bus>
+void CPU::Core <Bus>::STX (void)
+{
+    bus.write (current.address, X);
+}
+
+// decrement Y
+template <class Bus>
+void CPU::Core <Bus>::DEY (void)
+{
+    --Y;
+    set_flag (Flag::Z, Y == 0x00);
+    set_flag (Flag::N, Y & 0x80);
+}
+
+// transfer X to accumulator
+template <class Bus>
+void CPU::Core <Bus>::TXA (void)
+{
+    AC = X;
+    set_flag (Flag::Z, AC == 0x00);
+    set_flag (Flag::N, AC & 0x80);
+}
+
+// branch if carry clear
+template <class Bus>
+void CPU::Core <Bus>::BCC (void)
+{
+    if (!(SR & static_cast <byte> (Flag::C)))
+    {
+        // branch taken
+        ++current.cycles;
+
+        current.address += PC;
+
+        // page boundry crossed
+        if ((current.address & 0xFF00) != (PC & 0xFF00))
+            ++current.cycles;
+
+        PC = current.address;
+    }
+}
+
+// transfer Y to accumulator
+template <class Bus>
+void CPU::Core <Bus>::TYA (void)
+{
+    AC = Y;
+    set_flag (Flag::Z, AC == 0x00);
+    set_flag (Flag::N, AC & 0x80);
+}
+
+// transfer X to stack pointer
+template <class Bus>
+void CPU::Core <Bus>::TXS (void)
+{
+    SP = X;
+}
+
+// load Y
+template <class Bus>
+void CPU::Core <Bus>::LDY (void)
+{
+    Y = bus.read (current.address);
+    set_flag (Flag::Z, Y == 0x00);
+    set_flag (Flag::N, Y & 0x80);
+}
+
+// load accumulator
+template <class Bus>
+void CPU::Core <Bus>::LDA (void)
+{
+    AC = bus.read (current.address);
+    set_flag (Flag::Z, AC == 0x00);
+    set_flag (Flag::N, AC & 0x80);
+}
+
+// load X
+template <class Bus>
+void CPU::Core <Bus>::LDX (void)
+{
+    X = bus.read (current.address);
+    set_flag (Flag::Z, X == 0x00);
+    set_flag (Flag::N, X & 0x80);
+}
+
+// transfer accumulator to Y
+template <class Bus>
+void CPU::Core <Bus>::TAY (void)
+{
+    Y = AC;
+    set_flag (Flag::Z, Y == 0x00);
+    set_flag (Flag::N, Y & 0x80);
+}
+
+// transfer accumulator to X
+template <class Bus>
+void CPU::Core <Bus>::TAX (void)
+{
+    X = AC;
+    set_flag (Flag::Z, X == 0x00);
+    set_flag (Flag::N, X & 0x80);
+}
+
+// branch if carry set
+template <class Bus>
+void CPU::Core <Bus>::BCS (void)
+{
+    if (SR & static_cast <byte> (Flag::C))
+    {
+        // branch taken cycles added
+        ++current.cycles;
+        
+        current.address += PC;
+
+        // page boundry crossed
+        if ((current.address & 0xFF00) != (PC & 0xFF00))
+            ++current.cycles;
+
+        PC = current.address;
+    }
+}
+
+// clear overflow
+template <class Bus>
+void CPU::Core <Bus>::CLV (void)
+{
+    set_flag (Flag::V, false);
+}
+
+// transfer stack pointer to X
+template <class Bus>
+void CPU::Core <Bus>::TSX (void)
+{
+    X = SP;
+    set_flag (Flag::Z, X == 0x00);
+    set_flag (Flag::N, X & 0x80);
+}
+
+// compare Y
+template <class Bus>
+void CPU::Core <Bus>::CPY (void)
+{
+    current.data = bus.read (current.address);
+
+    set_flag (Flag::C, Y >= current.data);
+    set_flag (Flag::Z, Y == current.data);
+    set_flag (Flag::N, (Y - current.data) & 0x80);
+}
+
+// compare accumulator
+template <class Bus>
+void CPU::Core <Bus>::CMP (void)
+{
+    current.data = bus.read (current.address);
+
+    set_flag (Flag::C, AC >= current.data);
+    set_flag (Flag::Z, AC == current.data);
+    set_flag (Flag::N, (AC - current.data) & 0x80);
+}
+
+// decrement memory
+template <class Bus>
+void CPU::Core <Bus>::DEC (void)
+{
+    current.data = bus.read (current.address);
+    
+    --current.data;
+
+    set_flag (Flag::Z, current.data == 0x00);
+    set_flag (Flag::N, current.data & 0x80);
+
+    bus.write (current.address, current.data);
+}
+
+// increment Y
+template <class Bus>
+void CPU::Core <Bus>::INY (void)
+{
+    ++Y;
+    
+    set_flag (Flag::Z, Y == 0x0);
+    set_flag (Flag::N, Y & 0x80);
+}
+
+// decrement X
+template <class Bus>
+void CPU::Core <Bus>::DEX (void)
+{
+    --X;
+    
+    set_flag (Flag::Z, X == 0x0);
+    set_flag (Flag::N, X & 0x80);
+}
+
+// branch if not equal
+template <class Bus>
+void CPU::Core <Bus>::BNE (void)
+{
+    if (!(SR & static_cast <byte> (Flag::Z)))
+    {
+        // branch taken cycles added
+        ++current.cycles;
+        
+        current.address += PC;
+
+        // page boundry crossed
+        if ((current.address & 0xFF00) != (PC & 0xFF00))
+            ++current.cycles;
+
+        PC = current.address;
+    }
+}
+
+// clear decimal
+template <class Bus>
+void CPU::Core <Bus>::CLD (void)
+{
+    set_flag(Flag::D, false);
+}
+
+// compare X
+template <class Bus>
+void CPU::Core <Bus>::CPX (void)
+{
+    current.data = bus.read (current.address);
+
+    set_flag (Flag::C, X >= current.data);
+    set_flag (Flag::Z, X == current.data);
+    set_flag (Flag::N, (X - current.data) & 0x80);
+}
+
+// subtract with carry
+// A - M - (1 - C) is A + ~M + C, carry out means no borrow
+template <class Bus>
+void CPU::Core <Bus>::SBC (void)
+{
+    current.data = bus.read (current.address);
+
+    const byte inverted = ~current.data;
+    const word result = AC + inverted + (static_cast <byte> (Flag::C) & SR);
+
+    set_flag (Flag::C, (result & 0xFF00) != 0);
+    set_flag (Flag::Z, (result & 0x00FF) == 0x00);
+    set_flag (Flag::V, (result ^ AC) & (result ^ inverted) & 0x80);
+    set_flag (Flag::N, result & 0x80);
+
+    AC = result & 0x00FF;
+}
+
+// increment memory
+template <class Bus>
+void CPU::Core <Bus>::INC (void)
+{
+    current.data = bus.read (current.address);
+    
+    ++current.data;
+   
+    set_flag (Flag::Z, current.data == 0x00);
+    set_flag (Flag::N, current.data & 0x80);
+
+    bus.write (current.address, current.data);
+}
+
+// increment X
+template <class Bus>
+void CPU::Core <Bus>::INX (void)
+{
+    ++X;
+    
+    set_flag (Flag::Z, X == 0x00);
+    set_flag (Flag::N, X & 0x80);
+}
+
+template <class Bus>
+void CPU::Core <Bus>::NOP (void)
+{}
+
+template <class Bus>
+void CPU::Core <Bus>::BEQ (void)
+{
+    if (SR & static_cast <byte> (Flag::Z))
+    {
+        // branch taken cycles added
+        ++current.cycles;
+        
+        current.address += PC;
+
+        // page boundry crossed
+        if ((current.address & 0xFF00) != (PC & 0xFF00))
+            ++current.cycles;
+
+        PC = current.address;
+    }
+}
+
+// set decimal
+template <class Bus>
+void CPU::Core <Bus>::SED (void)
+{
+    set_flag (Flag::D, true);
+}
+
+// empty instruction (illegal)
+template <class Bus>
+void CPU::Core <Bus>::XXX (void)
+{
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef NSF_H
+#define NSF_H
+
+#include "apu.h"
+#include "mos6502_core.h"
+#include "scheduler.h"
+#include "utility.h"
+#include <array>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+
+https://www.nesdev.org/wiki/NSF
+
+NSF music files, played on the cpu and apu alone. there is no ppu in the
+player, which is why it renders far faster than real time.
+
+header (0x80 bytes, little endian)
+    0x00  "NESM" 0x1A
+    0x05  version
+    0x06  total songs
+    0x07  starting song (1 based)
+    0x08  load address
+    0x0A  init address
+    0x0C  play address
+    0x0E  name, artist, copyright (32 bytes each)
+    0x6E  ntsc play period in microseconds
+    0x70  initial banks for $8000 - $FFFF, all 0 means no bankswitching
+    0x78  pal play period
+    0x7A  pal / ntsc bits
+    0x7B  expansion chips
+
+memory map
+    $0000 - $07FF  ram (mirrored to $1FFF)
+    $4000 - $4017  apu
+    $5FF8 - $5FFF  4 KB bank select for $8000 - $FFFF
+    $6000 - $7FFF  ram
+    $8000 - $FFFF  rom
+
+init and play are called as subroutines. the player points their return
+address at an address the program can't reach and stops running the cpu once
+the rts lands there, idle time until the next play call is skipped over. play
+calls come from the scheduler on the period in the header.
+
+expansion audio (VRC6, FDS, N163, ...) is not emulated, those tracks play their
+2A03 parts only.
+
+*/
+
+namespace NSF
+{
+    struct File
+    {
+        // throws std::runtime_error if it isn't a readable NSF
+        explicit File (const std::string& path);
+
+        std::string path;
+
+        u8  version;
+        u8  track_n;
+        u8  start_track;     // 0 based
+        u16 load_address;
+        u16 init_address;
+        u16 play_address;
+        u16 play_period_us;  // ntsc
+        u8  chips;
+
+        std::string name;
+        std::string artist;
+        std::string copyright;
+
+        bool banked;
+        std::array <u8, 8> initial_banks;
+
+        std::vector <u8> data; // everything after the header
+    };
+
+    class Player
+    {
+    public:
+
+        Player (std::shared_ptr <const File> file, const double sample_rate = 48000.0);
+
+        // the cpu and the apu's callback point back at this
+        Player (const Player&) = delete;
+        Player& operator= (const Player&) = delete;
+
+        // 0 based, resets the machine and runs init
+        void start_track (const int track);
+
+        // emulates one frame worth of cycles, returns how many samples were written to out (~800 at 48 kHz)
+        std::size_t run_frame (std::span <i16> out);
+
+        const File& get_file () const;
+        APU::RP2A03& get_apu ();
+        u64 get_cycles () const;
+
+    private:
+
+        // pc value that means the called routine has returned
+        static constexpr u16 return_address = 0x3FF0;
+
+        std::shared_ptr <const File> file;
+
+        std::array <u8, 0x0800> ram;
+        std::array <u8, 0x2000> work_ram;
+        std::vector <u8> rom;               // data padded to whole 4 KB banks
+        std::array <u32, 8> bank_offsets;   // offset into rom of each 4 KB window
+
+        CPU::Core <Player> cpu;
+        APU::RP2A03  apu;
+        Scheduler    scheduler;
+
+        u64  cycle;        // cpu cycles since the track started
+        u64  play_period;  // in 1/256 cycles, the periods are not whole cycles
+        u64  play_time;    // next play call, same units
+        bool idle;
+        bool play_pending;
+
+        // the cpu's bus
+        friend class CPU::Core <Player>;
+        u8   read (const u16 address);
+        void write (const u16 address, const u8 data);
+
+        void set_bank (const int window, const u8 bank);
+        void call (const u16 address);
+    };
+}
+
+#endif
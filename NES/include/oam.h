@@ -0,0 +1,84 @@
+#ifndef OAM_H
+#define OAM_H
+
+#include "utility.h"
+#include <array>
+#include <span>
+
+/*
+
+https://www.nesdev.org/wiki/PPU_OAM
+https://www.nesdev.org/wiki/PPU_sprite_evaluation
+
+64 sprites, 4 bytes each
+
+Byte 0  Y position of top of sprite (sprite is drawn one line lower)
+Byte 1  Tile index number
+Byte 2  Attributes
+Byte 3  X position of left side of sprite
+
+a sprite is in range for scanline s when 0 <= s - Y < height (8 or 16), the
+first 8 in range are copied to secondary oam and drawn on the next line. a
+9th one sets the sprite overflow flag.
+
+instead of walking all 64 entries every scanline the lists for all 240 lines
+are built in one go, and only again after oam or the sprite height changed.
+
+*/
+
+namespace PPU
+{
+    class OAM
+    {
+    public:
+
+        static constexpr int sprite_n         = 64;
+        static constexpr int scanline_n       = 240;
+        static constexpr int sprites_per_line = 8;
+
+        struct Sprite
+        {
+            u8 y;
+            u8 tile;
+            u8 attributes;
+            u8 x;
+        };
+
+        // secondary oam for one scanline
+        struct Line
+        {
+            std::array <u8, sprites_per_line> sprites; // oam indices, in priority order
+            u8   count;
+            bool overflow;    // more than 8 sprites were in range
+            bool sprite_zero; // sprites[0] is sprite 0 (for sprite 0 hit)
+        };
+
+        OAM ();
+
+        u8   read  (const u8 address) const;
+        void write (const u8 address, const u8 data); // $2004
+        void dma   (std::span <const u8, 256> page);  // $4014
+
+        // PPUCTRL bit 5, 8x8 or 8x16 sprites
+        void set_sprite_height (const int height);
+
+        const Line&   get_line   (const int scanline);
+        const Sprite& get_sprite (const int index) const;
+
+    private:
+
+        alignas (32) std::array <u8, 256> memory;
+
+        // copy of every sprite's Y so evaluation can compare them 16 / 32 at a time
+        alignas (32) std::array <u8, sprite_n> y_positions;
+
+        std::array <Line, scanline_n> lines;
+
+        int  sprite_height;
+        bool dirty;
+
+        void evaluate ();
+    };
+}
+
+#endif
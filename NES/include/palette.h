@@ -0,0 +1,75 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include "frame.h"
+#include "utility.h"
+#include <array>
+#include <cstddef>
+
+/*
+
+https://www.nesdev.org/wiki/PPU_palettes
+
+64 colors, each of the 8 PPUMASK emphasis combinations gets its own copy of the
+table so a conversion is a single lookup per pixel.
+
+emphasis (PPUMASK >> 5)
+    bit 0: red
+    bit 1: green
+    bit 2: blue
+an emphasized channel stays as is, the other two are dimmed.
+
+*/
+
+namespace PPU
+{
+    enum class Pixel_Format
+    {
+        RGBA8888, // bytes R, G, B, A (SDL_PIXELFORMAT_RGBA32, GL_RGBA / GL_UNSIGNED_BYTE)
+        RGB565,   // native endian u16 (SDL_PIXELFORMAT_RGB565, GL_RGB / GL_UNSIGNED_SHORT_5_6_5)
+        GRAY8,    // luma only
+    };
+
+    class Palette
+    {
+    public:
+
+        static constexpr int color_n    = 64;
+        static constexpr int emphasis_n = 8;
+
+        Palette ();
+
+        // RGBA8888 value for a single index
+        u32 get_color (const u8 index, const u8 emphasis = 0) const;
+
+        /*
+            converts a whole frame into dst, pitch is the length of one row in bytes.
+            dst can be a caller buffer or a locked SDL texture / mapped GL buffer
+        */
+        void convert (const Frame& frame, const Pixel_Format format, void* dst, const std::size_t pitch) const;
+
+        // one row of any width (multiple of 32) to RGBA8888, for filters that scale before converting
+        void convert_row (const u8* src, u32* dst, const int width, const u8 emphasis) const;
+
+        static constexpr std::size_t bytes_per_pixel (const Pixel_Format format)
+        {
+            switch (format)
+            {
+                case Pixel_Format::RGBA8888: return 4;
+                case Pixel_Format::RGB565:   return 2;
+                case Pixel_Format::GRAY8:    return 1;
+            }
+            return 0;
+        }
+
+    private:
+
+        // [emphasis][index], byte tables are 64 wide so the simd path can pshufb them 16 at a time
+        alignas (32) std::array <std::array <u32, color_n>, emphasis_n> rgba;
+        alignas (32) std::array <std::array <u8,  color_n>, emphasis_n> rgb565_lo;
+        alignas (32) std::array <std::array <u8,  color_n>, emphasis_n> rgb565_hi;
+        alignas (32) std::array <std::array <u8,  color_n>, emphasis_n> gray;
+    };
+}
+
+#endif
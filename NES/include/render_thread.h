@@ -0,0 +1,96 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "spsc_ring.h"
+#include "utility.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+/*
+
+pipelined ppu rendering
+
+the cpu thread does not touch the ppu, it only logs every write that affects
+what ends up on screen, stamped with the cpu cycle it happened on. a render
+thread replays the log into the ppu and produces the pixels up to
+max_frames_behind frames later, so emulation and rendering run on two cores.
+
+reads the cpu needs an answer for right away ($2002 vblank / sprite 0 hit,
+$2007) have to be predicted on the cpu side. whenever that is not possible the
+core switches to synchronous mode, which drains the log and from then on
+replays every write on the calling thread.
+
+*/
+
+namespace PPU
+{
+    struct Log_Entry
+    {
+        enum class Target : u8
+        {
+            REGISTER,  // $2000 - $2007, address is the register number
+            VRAM,      // $0000 - $3FFF through the ppu address bus
+            OAM,       // $2004 / $4014 dma, one entry per byte
+            CHR_BANK,  // mapper chr bank switch, address = bank slot, data = bank
+            FRAME_END, // end of the emulated frame
+        };
+
+        u64    cycle;
+        u16    address;
+        u8     data;
+        Target target;
+    };
+
+    class Render_Thread
+    {
+    public:
+
+        using replay_cb = std::function <void(const Log_Entry&)>;
+
+        static constexpr std::size_t log_size = 1 << 16;
+
+        Render_Thread (replay_cb replay, const int max_frames_behind = 1);
+        ~Render_Thread ();
+
+        Render_Thread (const Render_Thread&) = delete;
+        Render_Thread& operator= (const Render_Thread&) = delete;
+
+        /* CPU THREAD */
+
+        void log (const Log_Entry& entry);
+
+        // blocks if the render thread is more than max_frames_behind frames behind
+        void end_frame (const u64 cycle);
+
+        // waits until everything logged so far has been replayed
+        void sync ();
+
+        void set_synchronous (const bool enabled);
+        bool is_synchronous () const;
+
+        u64 get_frames_rendered () const;
+
+    private:
+
+        replay_cb replay;
+        int max_frames_behind;
+        bool synchronous;
+
+        std::unique_ptr <SPSC_Ring <Log_Entry, log_size>> ring;
+
+        std::atomic <u64>  frames_logged;
+        std::atomic <u64>  frames_rendered;
+        std::atomic <u64>  entries_logged;
+        std::atomic <u64>  entries_replayed;
+        std::atomic <bool> running;
+
+        std::thread worker;
+
+        void push (const Log_Entry& entry);
+        void work ();
+    };
+}
+
+#endif
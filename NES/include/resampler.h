@@ -0,0 +1,76 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "utility.h"
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/*
+
+polyphase fir resampler, apu rate -> whatever rate the audio device opened at
+
+the rate ratio is reduced to up / down (48000 -> 44100 is 147 / 160). every
+output sample sits at a fraction phase / up between two input samples, and
+each of the up phases gets its own precomputed 32 tap kernel (kaiser windowed
+sinc, cut off below the lower of the two nyquists), so an output sample is one
+dot product with no interpolation of coefficients. ratios with more than
+max_phases phases (odd device rates) use the nearest of max_phases kernels.
+
+the debugger's rate control calls set_rates () with an output rate that moves by
+a fraction of a percent, that keeps the kernels built for the previous ratio as
+long as they have at least as many phases and their cut off is within 1%, the
+position in the stream carries over either way.
+
+process () takes a whole block (one emulated frame) at a time, converts it
+once and runs the dot products with avx2 / sse, the history between blocks is
+carried over internally.
+
+*/
+
+namespace APU
+{
+    class Resampler
+    {
+    public:
+
+        static constexpr int taps       = 32;
+        static constexpr int max_phases = 1024;
+
+        Resampler (const int input_rate, const int output_rate);
+
+        // keeps the history, rebuilds the kernels only when the ratio changed by more than rate control's nudges
+        void set_rates (const int input_rate, const int output_rate);
+
+        // upper bound of what process () writes for n input samples
+        std::size_t max_output (const std::size_t n) const;
+
+        // consumes all of in, returns how many samples went into out
+        std::size_t process (std::span <const i16> in, std::span <i16> out);
+
+        void reset ();
+
+        // same rate in and out, process () only copies
+        bool is_passthrough () const;
+
+    private:
+
+        int input_rate;
+        int output_rate;
+        u32 up;
+        u32 down;
+        u32 phase_n;
+        double cutoff;               // what the kernels were built for, cycles per input sample
+
+        std::vector <float> kernels; // phase_n * taps
+
+        std::vector <float> buffer;  // carried over history followed by the current block
+        std::size_t history;         // how many samples at the front of buffer are history
+        std::size_t skip;            // input samples to drop before the next output
+        u32 phase;                   // position between input samples, 0 - up-1
+
+        void build_kernels ();
+    };
+}
+
+#endif
@@ -1,11 +1,43 @@
 #ifndef ROM_H
 #define ROM_H
 
+#include <array>
 #include <cstring>
+#include <span>
+#include <string>
 #include <vector>
 #include <memory>
 #include "mapper.h"
+#include "chr_cache.h"
+#include "rom_image.h"
+#include "save_ram.h"
 
+/*
+
+prg and chr rom are spans straight into a ROM_Image mapping, every NES_ROM of
+the same file in the process shares it. the only copies made are chr ram
+(boards without chr rom) and the trainer. compressed or patched roms can't be
+shared that way, ROM_Stream decodes those into the owned buffers instead.
+
+the debugger's hex editor patches rom, get_writable_prg / chr copy that part
+out of the shared mapping the first time they are called, so the edits stay
+in this instance.
+
+banking and prg ram belong to the Mapper, cpu_read / ppu_read go straight to
+its published bank pointers.
+
+battery carts (flags 6 bit 1) get their prg ram from a Save_RAM, the .sav
+next to the rom. flush_save () is meant for frame boundaries, it only costs
+anything when the game wrote to the ram.
+
+reload () reads the file (and patch) again after it changed on disk, see
+ROM_Watcher. with the same header prg / chr are swapped in place, the mapper
+keeps its banking and prg ram, the system its state. crcs of every 1 KB chunk
+taken at load time say which chunks differ, writable copies only get those
+copied in and the chr cache only drops their tiles. the returned flags are
+for whatever else caches decoded rom (disassembly and so on).
+
+*/
 
 class NES_ROM
 {
@@ -13,31 +45,101 @@ class NES_ROM
 
 public:
 
-    NES_ROM(const char* file_name);
+    // one flag per Reload::chunk bytes of prg / chr, chr is empty for chr ram
+    struct Reload
+    {
+        static constexpr std::size_t chunk = 0x400;
+
+        // nothing was reloaded, the rom has to be opened again
+        bool header_changed;
+        std::vector<bool> prg;
+        std::vector<bool> chr;
+
+        bool any () const;
+    };
+
+    // file_name may be an iNES rom, or one in a .gz / .zip. patch_name is an .ips / .bps
+    // applied while loading. throws std::runtime_error if either can't be read or is invalid
+    NES_ROM(const char* file_name, const char* patch_name = nullptr);
 
     std::uint32_t size() {return prg_memory.size();}
 
-    bool cpu_read (u16 address, u8& data);
+    bool cpu_read  (u16 address, u8& data);
+    bool cpu_write (u16 address, u8 data);
+    bool ppu_read  (u16 address, u8& data);
+    bool ppu_write (u16 address, u8 data);
 
     u8 get_prg_bank_n () const;
     u8 get_chr_bank_n () const;
+    u8 get_mapper_id () const;
+    bool has_battery () const;
+
+    // see above. throws std::runtime_error (and changes nothing) if the file can't be read
+    Reload reload ();
 
-    std::vector<u8>& get_prg_memory ();
-    std::vector<u8>& get_chr_memory ();
+    const std::string& get_path () const;
+
+    // starts writing prg ram back to the .sav if it changed since the last call
+    void flush_save ();
+
+    std::span<const u8> get_prg_memory () const;
+    std::span<const u8> get_chr_memory () const;
+
+    // copy on first call, see above
+    std::span<u8> get_writable_prg ();
+    std::span<u8> get_writable_chr ();
+
+    // 512 bytes for $7000 - $71FF, empty if the rom has none
+    std::span<const u8> get_trainer () const;
+
+    PPU::CHR_Cache& get_chr_cache ();
+    Mapper& get_mapper ();
 
 
 private:
 
+    // what a file decodes to, prg / chr point into image or the owned buffers
+    struct Contents
+    {
+        std::array<u8, 16> header;
+        std::shared_ptr <const ROM_Image> image;
+        std::vector<u8> trainer;
+        std::vector<u8> prg_owned;
+        std::vector<u8> chr_owned;
+        std::span<const u8> prg;
+        std::span<const u8> chr;
+    };
+
+    static Contents load (const std::string& file_name, const std::string& patch_name);
+    static std::vector<u32> chunk_crcs (std::span<const u8> memory);
+
+    std::string path;
+    std::string patch_path;  // empty without one
+    std::array<u8, 16> header_bytes;
+
     u8 prg_bank_n;
     u8 chr_bank_n;
     u8 mapper_id;
+    bool battery;
 
+    // before mapper, which points into it
+    std::unique_ptr <Save_RAM> save;
     std::shared_ptr <Mapper> mapper;
 
-    int mirror;
+    std::shared_ptr <const ROM_Image> image;
+
+    std::span<const u8> prg_memory;
+    std::span<const u8> chr_memory;
+
+    // owned copies, chr_owned is also chr ram
+    std::vector<u8> prg_owned;
+    std::vector<u8> chr_owned;
+    std::vector<u8> trainer;
+
+    PPU::CHR_Cache chr_cache;
 
-    std::vector<u8> prg_memory;
-    std::vector<u8> chr_memory;
+    std::vector<u32> prg_crcs;
+    std::vector<u32> chr_crcs;
 
 };
 
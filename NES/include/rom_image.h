@@ -0,0 +1,54 @@
+#ifndef ROM_IMAGE_H
+#define ROM_IMAGE_H
+
+#include "utility.h"
+#include <memory>
+#include <span>
+#include <string>
+
+/*
+
+read only memory map of a rom file, shared by everything in the process that
+opens the same file
+
+open () keys a process wide registry on the file's device and inode (so
+different spellings of one path still share) and hands out shared_ptrs to a
+single mapping, the mapping goes away with the last one. nothing is read up
+front, pages come in from the page cache as they are touched, so opening a
+rom a thousand times costs one mapping and no copies. a file that was
+rewritten in place (same inode, new size or modification time) gets a new
+mapping instead of the stale one.
+
+the mapping is PROT_READ, writing through data () faults. anything that wants
+to patch rom has to copy the part it changes.
+
+*/
+
+class ROM_Image
+{
+public:
+
+    // throws std::runtime_error if the file can't be opened or mapped
+    static std::shared_ptr <const ROM_Image> open (const std::string& path);
+
+    ~ROM_Image ();
+
+    ROM_Image (const ROM_Image&) = delete;
+    ROM_Image& operator= (const ROM_Image&) = delete;
+
+    std::span <const u8> data () const;
+    const std::string& get_path () const;
+
+private:
+
+    ROM_Image (const std::string& path, const int fd, const std::size_t size, const u64 device, const u64 inode, const u64 modified);
+
+    std::string path;
+    u64 device;  // registry key
+    u64 inode;
+    u64 modified;  // st_mtim in ns
+    const u8* mapping;
+    std::size_t size;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef ROM_LIBRARY_H
+#define ROM_LIBRARY_H
+
+#include "hash.h"
+#include "utility.h"
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+
+index of a rom directory: header info, mapper and the CRC32 / SHA-1 of prg + chr
+for every .nes file under it
+
+scan () only opens files that are new or whose size or modification time
+changed since the index was written, everything else comes straight from the
+index. the files that do need hashing are spread over worker threads, each
+maps its file (ROM_Image) and hashes it in place, so a rescan of an unchanged
+library of tens of thousands of roms is a directory walk and a stat per file.
+
+index file (host byte order, written to a temporary and renamed over the old one)
+
+    header   "NESLIB\0\0", u32 version, u32 entry count, u64 string table size
+    records  entry count * Record (fixed size)
+    strings  paths, referenced by offset + length from the records
+
+it is read back through mmap, the records are copied out without parsing
+anything. a missing, truncated, older version or other endian index is simply
+ignored and everything gets rehashed.
+
+*/
+
+class ROM_Library
+{
+public:
+
+    enum class Format : u8
+    {
+        INVALID, // not an iNES file, or truncated
+        INES,
+        NES2,
+    };
+
+    struct Entry
+    {
+        std::string path;
+        i64 mtime;  // file_time_type ticks
+        u64 size;
+
+        Format format;
+        u16 mapper;
+        u8  submapper;
+        bool battery;
+        bool trainer;
+        u8  mirroring;  // flags 6 bit 0, bit 3 for four screen
+        u32 prg_size;   // bytes
+        u32 chr_size;   // bytes, 0 for chr ram
+
+        u32 crc32;      // of prg + chr, header and trainer excluded
+        Hash::SHA1_Digest sha1;
+    };
+
+    struct Scan_Stats
+    {
+        std::size_t files;
+        std::size_t hashed;   // new or changed
+        std::size_t reused;   // straight from the index
+        std::size_t failed;   // couldn't be read
+        u64 bytes_hashed;
+    };
+
+    // loads index_path if it exists and is usable
+    explicit ROM_Library (const std::string& index_path);
+
+    // walks the directories recursively, threads 0 means one per core. the index ends up
+    // holding exactly the roms found, entries for files that are gone are dropped
+    Scan_Stats scan (std::span <const std::string> directories, unsigned threads = 0);
+
+    // throws std::runtime_error if the index can't be written
+    void save () const;
+
+    std::span <const Entry> get_entries () const;
+
+    const Entry* find (const std::string_view path) const;
+    const Entry* find_crc32 (const u32 crc32) const;
+
+private:
+
+    std::string index_path;
+    std::vector <Entry> entries;
+
+    // into entries
+    std::unordered_map <std::string_view, std::size_t> by_path;
+    std::unordered_map <u32, std::size_t> by_crc32;
+
+    void load ();
+    void rebuild_lookup ();
+
+    // false if the file couldn't be read at all
+    static bool identify (Entry& entry);
+};
+
+#endif
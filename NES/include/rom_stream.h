@@ -0,0 +1,62 @@
+#ifndef ROM_STREAM_H
+#define ROM_STREAM_H
+
+#include "utility.h"
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+
+roms that can't be mapped as they are: compressed (.gz, .zip) and / or soft
+patched (.ips, .bps)
+
+decode () rebuilds the iNES file straight into the buffers NES_ROM keeps.
+the container is inflated from its (mapped) file in one pass, the header comes
+out first and sizes trainer / prg / chr, then zlib writes the rest directly
+into them. nothing is extracted to disk and there is no whole decompressed
+copy next to the final buffers. the gzip / zip crc is checked on the way.
+
+    IPS  records are written over the decoded buffers once they are complete,
+         the ones touching the header first so the sizes come out right.
+    BPS  needs random access to the whole source, so a compressed source is
+         the one case that is inflated into a buffer of its own (a plain one
+         is used from the mapping). the target is built by the patch actions
+         directly into the final buffers, its crc is updated action by action
+         and checked together with the source and patch crcs.
+
+zip archives use the first .nes entry (or the first file if none is named
+that way), stored or deflated.
+
+*/
+
+namespace ROM_Stream
+{
+    // the pieces of an iNES file, in file order
+    struct Buffers
+    {
+        std::array <u8, 16> header;
+        std::vector <u8> trainer;
+        std::vector <u8> prg;
+        std::vector <u8> chr;
+        std::vector <u8> tail;  // whatever follows chr (PlayChoice data), only kept while patching
+
+        // sizes trainer / prg / chr from header, throws std::runtime_error if it isn't iNES
+        void allocate ();
+
+        // header + trainer + prg + chr + tail
+        u64 size () const;
+
+        // contiguous bytes from offset to the end of the piece it falls in, empty past the end
+        std::span <u8> span_at (const u64 offset);
+    };
+
+    bool is_ines (std::span <const u8> file);
+
+    // name is only used for messages. patch is the contents of an .ips / .bps file, or empty.
+    // throws std::runtime_error on anything malformed, truncated or failing a crc
+    Buffers decode (std::span <const u8> file, const std::string& name, std::span <const u8> patch = {});
+}
+
+#endif
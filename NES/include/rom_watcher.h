@@ -0,0 +1,43 @@
+#ifndef ROM_WATCHER_H
+#define ROM_WATCHER_H
+
+#include <string>
+
+/*
+
+tells when a rom file changed on disk, so the debugger can NES_ROM::reload ()
+it without a restart
+
+inotify watches the file's directory rather than the file: assemblers and
+editors tend to write a new file and rename it over the old one, which a
+watch on the old inode never sees. only IN_CLOSE_WRITE and IN_MOVED_TO with
+the file's name count, both mean the contents are complete, so there is no
+half written rom to read and nothing to debounce.
+
+the descriptor is non-blocking, poll () is meant to be called once a frame and
+costs one read () that fails with EAGAIN when nothing happened. a save that
+produces several events still reports one change.
+
+*/
+
+class ROM_Watcher
+{
+public:
+
+    // throws std::runtime_error if inotify can't be set up for the file's directory
+    explicit ROM_Watcher (const std::string& path);
+    ~ROM_Watcher ();
+
+    ROM_Watcher (const ROM_Watcher&) = delete;
+    ROM_Watcher& operator= (const ROM_Watcher&) = delete;
+
+    // true if the file was written or replaced since the last call
+    bool poll ();
+
+private:
+
+    std::string name;
+    int fd;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SAVE_RAM_H
+#define SAVE_RAM_H
+
+#include "utility.h"
+#include <span>
+#include <string>
+
+/*
+
+battery backed prg ram, kept in a .sav file next to the rom
+
+the file is mapped MAP_SHARED and the mapper's $6000 - $7FFF window points
+straight at the mapping, a game writing its save is a plain store with no
+i/o behind it. the pages are the kernel's from the first write on, so even a
+crash of the emulator loses nothing, only the machine going down before
+writeback does. flush () narrows that window: it is called at frame
+boundaries and starts an asynchronous msync when the game wrote anything
+since the last one. the destructor (clean shutdown) msyncs synchronously.
+
+a shorter or missing file is extended with zeros, a longer one is left alone
+and only its start is mapped.
+
+*/
+
+class Save_RAM
+{
+public:
+
+    static constexpr std::size_t size = 0x2000;
+
+    // throws std::runtime_error if the file can't be created or mapped
+    explicit Save_RAM (const std::string& path);
+    ~Save_RAM ();
+
+    Save_RAM (const Save_RAM&) = delete;
+    Save_RAM& operator= (const Save_RAM&) = delete;
+
+    std::span <u8> data ();
+    const std::string& get_path () const;
+
+    // MS_ASYNC, call it only when the ram was written
+    void flush ();
+
+private:
+
+    std::string path;
+    u8* mapping;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "utility.h"
+#include <array>
+
+/*
+
+cpu cycle event scheduler
+
+instead of every component being ticked and asked "anything to do?" each
+cycle, each one says when it next needs attention (end of frame, a predicted
+irq, the next nsf play call) and the run loop executes cpu instructions
+straight up to the earliest of those cycles. there are only a handful of event
+kinds, each can be pending at most once, so a flat array with the minimum
+cached is all it takes.
+
+*/
+
+class Scheduler
+{
+public:
+
+    enum class Event : u8
+    {
+        FRAME,       // end of the emulated frame
+        APU_IRQ,     // apu frame counter or dmc interrupt
+        MAPPER_IRQ,  // scanline / cycle counter on the cartridge
+        NSF_PLAY,    // nsf play routine timer
+
+        COUNT,
+    };
+
+    static constexpr u64 never = ~u64 {0};
+
+    Scheduler ();
+
+    // replaces the event's previous time if it was already pending
+    void schedule (const Event event, const u64 cycle);
+    void cancel (const Event event);
+
+    // never if it isn't pending
+    u64 get (const Event event) const;
+
+    // cycle of the earliest pending event
+    u64 next_cycle () const;
+
+    // takes the earliest event that is due by cycle out of the queue
+    bool pop_due (const u64 cycle, Event& event);
+
+private:
+
+    std::array <u64, static_cast <std::size_t> (Event::COUNT)> when;
+    u64 next;
+
+    void update_next ();
+};
+
+#endif
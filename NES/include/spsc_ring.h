@@ -0,0 +1,133 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+/*
+
+lock-free single producer / single consumer ring
+
+one thread pushes, one thread pops, no locks. head is only written by the
+producer and tail only by the consumer, each side reads the other with acquire
+so the slot contents are visible before the index that publishes them.
+the indices run freely and are masked on access, so N has to be a power of 2
+and all N slots are usable.
+
+*/
+
+template <typename T, std::size_t N>
+class SPSC_Ring
+{
+    static_assert (N != 0 && (N & (N - 1)) == 0, "ring size has to be a power of 2");
+
+public:
+
+    SPSC_Ring ()
+    : head {0}
+    , tail {0}
+    , buffer {}
+    {}
+
+    /* PRODUCER */
+
+    bool push (const T& value)
+    {
+        const std::size_t h = head.load (std::memory_order_relaxed);
+        if (h - tail.load (std::memory_order_acquire) == N)
+            return false;
+
+        buffer[h & (N - 1)] = value;
+        head.store (h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // pushes as many as fit, returns how many did
+    std::size_t push (std::span <const T> values)
+    {
+        const std::size_t h = head.load (std::memory_order_relaxed);
+        const std::size_t n = std::min (values.size(), N - (h - tail.load (std::memory_order_acquire)));
+
+        for (std::size_t i = 0; i < n; ++i)
+            buffer[(h + i) & (N - 1)] = values[i];
+
+        head.store (h + n, std::memory_order_release);
+        return n;
+    }
+
+    // slot for in place writing, publish it with commit ()
+    T* acquire ()
+    {
+        const std::size_t h = head.load (std::memory_order_relaxed);
+        if (h - tail.load (std::memory_order_acquire) == N)
+            return nullptr;
+        return &buffer[h & (N - 1)];
+    }
+
+    void commit ()
+    {
+        head.store (head.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /* CONSUMER */
+
+    bool pop (T& value)
+    {
+        const std::size_t t = tail.load (std::memory_order_relaxed);
+        if (t == head.load (std::memory_order_acquire))
+            return false;
+
+        value = buffer[t & (N - 1)];
+        tail.store (t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // pops as many as are available (up to values.size ()), returns how many did
+    std::size_t pop (std::span <T> values)
+    {
+        const std::size_t t = tail.load (std::memory_order_relaxed);
+        const std::size_t n = std::min (values.size(), head.load (std::memory_order_acquire) - t);
+
+        for (std::size_t i = 0; i < n; ++i)
+            values[i] = buffer[(t + i) & (N - 1)];
+
+        tail.store (t + n, std::memory_order_release);
+        return n;
+    }
+
+    // oldest slot for in place reading, free it with release ()
+    T* front ()
+    {
+        const std::size_t t = tail.load (std::memory_order_relaxed);
+        if (t == head.load (std::memory_order_acquire))
+            return nullptr;
+        return &buffer[t & (N - 1)];
+    }
+
+    void release ()
+    {
+        tail.store (tail.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /* EITHER SIDE */
+
+    // only a snapshot when called while the other side is running
+    std::size_t size () const
+    {
+        return head.load (std::memory_order_acquire) - tail.load (std::memory_order_acquire);
+    }
+
+    static constexpr std::size_t capacity () {return N;}
+
+private:
+
+    // producer and consumer indices on their own cache lines
+    alignas (64) std::atomic <std::size_t> head;
+    alignas (64) std::atomic <std::size_t> tail;
+    alignas (64) std::array <T, N> buffer;
+};
+
+#endif
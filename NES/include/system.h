@@ -0,0 +1,138 @@
+#ifndef SYSTEM_H
+#define SYSTEM_H
+
+#include "apu.h"
+#include "cheat.h"
+#include "mapper.h"
+#include "mos6502_core.h"
+#include "rom.h"
+#include "scheduler.h"
+#include "utility.h"
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+/*
+
+the whole console around one cartridge
+
+System <M> is compiled once per board type, the bus knows the concrete mapper
+so bank switching writes, irq polls and the bank pointer reads are direct
+calls the compiler can inline instead of going through Mapper's vtable on
+every access. the one runtime decision is made by NES_System::create () right
+after NES_ROM has parsed the mapper number, from then on everything above
+run_frame () stays inside one specialization.
+
+the cpu is a CPU::Core <System <M>>, its reads and writes are direct calls
+into the bus below, so the whole path from an instruction fetch to the bank
+pointer can inline into one specialization.
+
+the factories are a registry keyed by mapper number. system.cpp registers a
+System <M> for every board in Boards (mapper.h), which is also what
+instantiates System <M> and its cpu core. the same list registers the boards
+with Mapper, so a new board is one entry there.
+
+there is no ppu yet, $2000 - $3FFF read as 0. the bus keeps PPUCTRL and
+PPUMASK though, they are all the MMC3 irq needs. its counter is clocked by
+ppu A12 rising, which with rendering on happens once per visible and pre-render
+line at a dot fixed by which pattern table the sprites and background use
+(260 for sprites at $1000, 324 for background at $1000). instead of watching
+A12 every dot, the system works out from the counter and that dot on which
+cycle the counter will reach 0 and schedules one MAPPER_IRQ for it. the
+counter itself is brought up to date in one step (clock_scanlines) only when
+something could change the answer: a write to the mapper or to $2000 / $2001,
+or the event firing. the ppu timeline is 262 x 341 dots from reset, the odd
+frame short line is ignored.
+
+cheats cost nothing per access. rom codes go to the mapper's page overlays,
+ram codes ($0000 - $1FFF, $6000 - $7FFF) are written back at the start of
+every frame.
+
+*/
+
+class NES_System
+{
+public:
+
+    using Factory = std::unique_ptr <NES_System> (*) (NES_ROM& rom, const double sample_rate);
+
+    // throws std::runtime_error if no System is registered for the rom's mapper
+    static std::unique_ptr <NES_System> create (NES_ROM& rom, const double sample_rate = 48000.0);
+
+    // false if mapper_id is taken already
+    static bool add_factory (const u16 mapper_id, Factory factory);
+
+    virtual ~NES_System ();
+
+    // power on, cpu from the reset vector
+    virtual void reset () = 0;
+
+    // emulates one frame worth of cycles, returns how many samples were written to out
+    virtual std::size_t run_frame (std::span <i16> out) = 0;
+
+    // replaces the active codes, an empty span turns cheats off
+    virtual void set_cheats (std::span <const Cheat::Code> codes) = 0;
+
+    virtual CPU::MOS6502& get_cpu () = 0;
+    virtual APU::RP2A03& get_apu () = 0;
+    virtual u64 get_cycles () const = 0;
+};
+
+template <class M>
+class System final: public NES_System
+{
+public:
+
+    // throws std::runtime_error if the rom's mapper isn't an M
+    System (NES_ROM& rom, const double sample_rate);
+
+    // the cpu and the apu's callback point back at this
+    System (const System&) = delete;
+    System& operator= (const System&) = delete;
+
+    void reset () override;
+    std::size_t run_frame (std::span <i16> out) override;
+
+    void set_cheats (std::span <const Cheat::Code> codes) override;
+
+    CPU::MOS6502& get_cpu () override;
+    APU::RP2A03& get_apu () override;
+    u64 get_cycles () const override;
+
+private:
+
+    NES_ROM& rom;
+    M& mapper;
+
+    std::array <u8, 0x0800> ram;
+
+    CPU::Core <System> cpu;
+    APU::RP2A03  apu;
+    Scheduler    scheduler;
+
+    u64  cycle;
+    bool irq_line; // some source raised its irq, polled after every instruction until it drops
+
+    // $2000 / $2001 as last written
+    u8  ppu_ctrl;
+    u8  ppu_mask;
+    u64 counter_dot; // ppu dot the scanline counter has been clocked up to
+
+    std::vector <Cheat::Code> freezes; // ram codes
+
+    void apply_freezes ();
+
+    // the cpu's bus
+    friend class CPU::Core <System>;
+    u8   read (const u16 address);
+    void write (const u16 address, const u8 data);
+
+    void schedule_apu_irq ();
+
+    // only do something for boards with a scanline counter
+    void sync_scanline_counter ();
+    void schedule_mapper_irq ();
+};
+
+#endif
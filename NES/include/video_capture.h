@@ -0,0 +1,107 @@
+#ifndef VIDEO_CAPTURE_H
+#define VIDEO_CAPTURE_H
+
+#include "capture_writer.h"
+#include "frame.h"
+#include "palette.h"
+#include "utility.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+
+frame capture for regression evidence / bug reports
+
+submit () copies the palette index frame (61 KB, a quarter of rgba) into a
+bounded ring and returns, a writer thread (Capture_Writer) does the conversion,
+encoding and all disk i/o, so the emulation loop never blocks on the disk.
+when the disk can't keep up it either waits for a free slot (BLOCK) or throws
+the frame away and counts it (DROP).
+
+    Y4M      one .y4m stream, 4:4:4 BT.601, 8:7 pixel aspect, 60.0988 fps
+    RAW_RGB  one file of packed 24 bit frames, back to back
+    PNG      one numbered .png per frame (path_000000.png, ...)
+
+conversions are table lookups per (emphasis, index), the frame never goes
+through rgba first. the stream formats are written through a large aligned
+buffer, optionally with O_DIRECT to keep captures out of the page cache.
+
+*/
+
+namespace PPU
+{
+    class Video_Capture
+    {
+    public:
+
+        enum class Format
+        {
+            Y4M,
+            RAW_RGB,
+            PNG,
+        };
+
+        // BLOCK: submit () waits for the writer, DROP: frames that don't fit are counted and lost
+        using Policy = Capture_Policy;
+
+        static constexpr std::size_t ring_size = 16;
+
+        // throws std::runtime_error if the output can't be opened
+        Video_Capture (const std::string& path, const Format format, const Palette& palette, const Policy policy = Policy::BLOCK, const bool direct_io = false);
+
+        // writes out whatever is still queued
+        ~Video_Capture ();
+
+        Video_Capture (const Video_Capture&) = delete;
+        Video_Capture& operator= (const Video_Capture&) = delete;
+
+        // false if the frame was dropped
+        bool submit (const Frame& frame);
+
+        u64  get_frames_written () const;
+        u64  get_frames_dropped () const;
+        bool has_failed () const;
+
+    private:
+
+        std::string path;
+        Format format;
+
+        // per [emphasis][index]
+        std::array <std::array <std::array <u8, 3>, Palette::color_n>, Palette::emphasis_n> rgb;
+        std::array <std::array <std::array <u8, 3>, Palette::color_n>, Palette::emphasis_n> yuv;
+
+        // stream output (Y4M / RAW_RGB), PNG builds each file in buffer
+        int  fd;
+        bool direct_io;
+        std::unique_ptr <u8, void (*)(void*)> buffer;
+        std::size_t buffer_used;
+
+        // per frame encode scratch
+        std::vector <u8> raw;
+        std::vector <u8> compressed;
+
+        // only touched by the writer, numbers the png files
+        u64 frame_number;
+
+        std::atomic <u64>  frames_written;
+        std::atomic <bool> failed;
+
+        Capture_Writer <Frame, ring_size> writer;
+
+        bool write_frame (const Frame& frame);
+
+        void encode_y4m (const Frame& frame);
+        void encode_rgb (const Frame& frame);
+        void encode_png (const Frame& frame, const u64 number);
+
+        void append (const void* data, const std::size_t size);
+        void flush (const bool final);
+        bool write_all (const int file, const u8* data, std::size_t size);
+    };
+}
+
+#endif
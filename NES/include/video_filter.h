@@ -0,0 +1,101 @@
+#ifndef VIDEO_FILTER_H
+#define VIDEO_FILTER_H
+
+#include "frame.h"
+#include "palette.h"
+#include "utility.h"
+#include <atomic>
+#include <barrier>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/*
+
+post processing for display and captures, works from the palette index Frame
+and writes RGBA8888 into a buffer the caller owns.
+
+    NEAREST  integer scale 1 - 4
+    SCALE2X  AdvMAME2x / Scale2x, edge directed 2x
+    SCALE3X  AdvMAME3x / Scale3x, edge directed 3x
+    NTSC     composite signal of the 2C02 generated per scanline and decoded
+             back to rgb through a 12 sample YIQ window, 512 x 240 out
+
+the scale2x / scale3x edge tests compare palette indices, not rgb, so they are
+exact and vectorize as plain byte compares.
+
+the frame is cut into bands of rows, one per worker. the calling thread works
+on the first band itself. everything (threads, row scratch) is set up in the
+constructor, apply () does no allocation.
+
+https://www.scale2x.it/algorithm
+https://www.nesdev.org/wiki/NTSC_video
+
+*/
+
+namespace PPU
+{
+    class Video_Filter
+    {
+    public:
+
+        enum class Mode
+        {
+            NEAREST,
+            SCALE2X,
+            SCALE3X,
+            NTSC,
+        };
+
+        Video_Filter (const Palette& palette, const Mode mode, const int scale = 2, const int thread_n = 0);
+        ~Video_Filter ();
+
+        Video_Filter (const Video_Filter&) = delete;
+        Video_Filter& operator= (const Video_Filter&) = delete;
+
+        // output size in pixels, dst for apply () has to hold get_height () rows of pitch bytes
+        int get_width  () const;
+        int get_height () const;
+
+        void apply (const Frame& frame, u32* dst, const std::size_t pitch);
+
+    private:
+
+        // per worker row buffers
+        struct Scratch
+        {
+            std::vector <u8>    indices; // padded source row / scaled index rows
+            std::vector <u32>   row;     // converted source row for NEAREST
+            std::vector <float> signal;  // NTSC samples of one scanline and their running YIQ sums
+        };
+
+        const Palette& palette;
+        Mode mode;
+        int  scale;
+        int  width;
+        int  height;
+
+        std::vector <Scratch> scratch;
+
+        // current job, only touched between the two barriers
+        const Frame* frame;
+        u32*         dst;
+        std::size_t  pitch;
+        u32          frame_n;
+
+        std::atomic <bool>  stopping;
+        std::barrier <>     start;
+        std::barrier <>     done;
+        std::vector <std::thread> workers;
+
+        void work (const int band);
+        void run_band (const int band);
+
+        void nearest (const int y, Scratch& scratch);
+        void scale_2x (const int y, Scratch& scratch);
+        void scale_3x (const int y, Scratch& scratch);
+        void ntsc (const int y, Scratch& scratch);
+    };
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include "utility.h"
+#include <fstream>
+#include <span>
+#include <string>
+
+/*
+
+16 bit pcm output, either a .wav (RIFF header up front, sizes patched when the
+file is closed) or headerless raw little endian samples.
+
+*/
+
+namespace APU
+{
+    class Wav_File
+    {
+    public:
+
+        enum class Format
+        {
+            WAV,
+            RAW,
+        };
+
+        // throws std::runtime_error if the file can't be created
+        Wav_File (const std::string& path, const int sample_rate, const int channels = 1, const Format format = Format::WAV);
+
+        // closes if still open
+        ~Wav_File ();
+
+        Wav_File (const Wav_File&) = delete;
+        Wav_File& operator= (const Wav_File&) = delete;
+
+        // interleaved when channels > 1
+        void write (std::span <const i16> samples);
+
+        // fills in the header sizes, throws if anything failed to write
+        void close ();
+
+        u64 get_samples_written () const;
+
+        // false once a write has failed
+        bool good () const;
+
+    private:
+
+        std::ofstream file;
+        std::string path;
+        int sample_rate;
+        int channels;
+        Format format;
+        u64 samples_written;
+
+        void write_header ();
+    };
+}
+
+#endif
@@ -0,0 +1,635 @@
+#include "apu.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr std::array <u8, 32> length_table
+    {
+        10, 254, 20,  2, 40,  4, 80,  6, 160,  8, 60, 10, 14, 12, 26, 14,
+        12,  16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30,
+    };
+
+    constexpr std::array <std::array <u8, 8>, 4> duty_table
+    {{
+        {0, 1, 0, 0, 0, 0, 0, 0},
+        {0, 1, 1, 0, 0, 0, 0, 0},
+        {0, 1, 1, 1, 1, 0, 0, 0},
+        {1, 0, 0, 1, 1, 1, 1, 1},
+    }};
+
+    constexpr std::array <u8, 32> triangle_table
+    {
+        15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0,
+         0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+    };
+
+    // NTSC, in cpu cycles
+    constexpr std::array <u16, 16> noise_periods {4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068};
+    constexpr std::array <u16, 16> dmc_rates {428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54};
+
+    // cycles of each frame counter step after the sequence starts, the 5 step mode's empty 4th step is left out
+    constexpr std::array <u32, 4> four_step_cycles {7457, 14913, 22371, 29829};
+    constexpr std::array <u32, 4> five_step_cycles {7457, 14913, 22371, 37281};
+    constexpr u32 four_step_period = 29830;
+    constexpr u32 five_step_period = 37282;
+
+    // the wiki's linear mix, scaled so a full mix stays clear of i16 clipping
+    constexpr int pulse_weight    = 226;
+    constexpr int triangle_weight = 255;
+    constexpr int noise_weight    = 148;
+    constexpr int dmc_weight      = 101;
+
+    // skips whole timer periods when a channel has nothing to output
+    u32 skip (u32 t, const u32 end, const u32 period)
+    {
+        if (t < end)
+            t += ((end - t - 1) / period + 1) * period;
+        return t;
+    }
+}
+
+void APU::RP2A03::Output::update (Blip_Buffer& blip, const u32 time, const int new_level)
+{
+    if (new_level == level)
+        return;
+
+    const int delta = (new_level - level) * weight;
+    blip.add_delta (time, delta);
+    if (stem)
+        stem->add_delta (time, delta);
+    level = new_level;
+}
+
+void APU::RP2A03::Envelope::clock ()
+{
+    if (start)
+    {
+        start = false;
+        decay = 15;
+        divider = period;
+        return;
+    }
+
+    if (divider > 0)
+    {
+        --divider;
+        return;
+    }
+
+    divider = period;
+    if (decay > 0)
+        --decay;
+    else if (loop)
+        decay = 15;
+}
+
+int APU::RP2A03::Envelope::volume () const
+{
+    return constant ? period : decay;
+}
+
+int APU::RP2A03::Pulse::sweep_target () const
+{
+    const int change = timer >> sweep_shift;
+
+    if (sweep_negate)
+        return timer - change - (ones_complement ? 1 : 0);
+    return timer + change;
+}
+
+bool APU::RP2A03::Pulse::muted () const
+{
+    return timer < 8 || sweep_target () > 0x7FF;
+}
+
+void APU::RP2A03::Pulse::clock_sweep ()
+{
+    if (sweep_divider == 0 && sweep_enabled && sweep_shift > 0 && !muted ())
+        timer = static_cast <u16> (std::max (sweep_target (), 0));
+
+    if (sweep_divider == 0 || sweep_reload)
+    {
+        sweep_divider = sweep_period;
+        sweep_reload = false;
+    }
+    else
+        --sweep_divider;
+}
+
+void APU::RP2A03::Pulse::clock_length ()
+{
+    if (!halt && length > 0)
+        --length;
+}
+
+void APU::RP2A03::Pulse::run (Blip_Buffer& blip, const u32 start, const u32 end)
+{
+    // the timer is clocked every other cpu cycle
+    const u32 period = (timer + 1u) * 2;
+    const int volume = (length == 0 || muted ()) ? 0 : envelope.volume ();
+
+    output.update (blip, start, duty_table[duty][phase] ? volume : 0);
+
+    u32 t = start + delay;
+
+    if (volume == 0)
+    {
+        const u32 next = skip (t, end, period);
+        phase = static_cast <u8> ((phase - (next - t) / period) & 7);
+        t = next;
+    }
+    else
+    {
+        for (; t < end; t += period)
+        {
+            phase = (phase - 1) & 7;
+            output.update (blip, t, duty_table[duty][phase] ? volume : 0);
+        }
+    }
+
+    delay = t - end;
+}
+
+void APU::RP2A03::Triangle::clock_linear ()
+{
+    if (linear_reload)
+        linear = linear_period;
+    else if (linear > 0)
+        --linear;
+
+    if (!control)
+        linear_reload = false;
+}
+
+void APU::RP2A03::Triangle::clock_length ()
+{
+    if (!control && length > 0)
+        --length;
+}
+
+void APU::RP2A03::Triangle::run (Blip_Buffer& blip, const u32 start, const u32 end)
+{
+    const u32 period = timer + 1u;
+
+    output.update (blip, start, triangle_table[phase]);
+
+    u32 t = start + delay;
+
+    // halted or ultrasonic (games use timer 0 / 1 as a mute), the level just holds
+    if (length == 0 || linear == 0 || timer < 2)
+        t = skip (t, end, period);
+    else
+    {
+        for (; t < end; t += period)
+        {
+            phase = (phase + 1) & 31;
+            output.update (blip, t, triangle_table[phase]);
+        }
+    }
+
+    delay = t - end;
+}
+
+void APU::RP2A03::Noise::clock_length ()
+{
+    if (!halt && length > 0)
+        --length;
+}
+
+void APU::RP2A03::Noise::run (Blip_Buffer& blip, const u32 start, const u32 end)
+{
+    const u32 period = noise_periods[this->period];
+    const int volume = length == 0 ? 0 : envelope.volume ();
+    const int tap    = mode ? 6 : 1;
+
+    output.update (blip, start, (shift & 1) ? 0 : volume);
+
+    u32 t = start + delay;
+
+    // the shift register keeps running while silent, the sequence position is audible later
+    for (; t < end; t += period)
+    {
+        const u16 feedback = (shift ^ (shift >> tap)) & 1;
+        shift = static_cast <u16> ((shift >> 1) | (feedback << 14));
+
+        if (volume)
+            output.update (blip, t, (shift & 1) ? 0 : volume);
+    }
+
+    delay = t - end;
+}
+
+void APU::RP2A03::DMC::restart ()
+{
+    address = sample_address;
+    bytes_remaining = sample_length;
+}
+
+void APU::RP2A03::DMC::fetch (const dmc_read_cb& read)
+{
+    if (buffer_full || bytes_remaining == 0)
+        return;
+
+    sample_buffer = read ? read (address) : 0;
+    buffer_full = true;
+    address = address == 0xFFFF ? 0x8000 : address + 1;
+
+    if (--bytes_remaining == 0)
+    {
+        if (loop)
+            restart ();
+        else if (irq_enabled)
+            irq = true;
+    }
+}
+
+void APU::RP2A03::DMC::run (Blip_Buffer& blip, const dmc_read_cb& read, const u32 start, const u32 end)
+{
+    const u32 period = dmc_rates[rate];
+
+    u32 t = start + delay;
+
+    for (; t < end; t += period)
+    {
+        if (!silence)
+        {
+            int level = output.level;
+            if (shift & 1)
+            {
+                if (level <= 125)
+                    level += 2;
+            }
+            else if (level >= 2)
+                level -= 2;
+
+            output.update (blip, t, level);
+        }
+
+        shift >>= 1;
+
+        if (--bits_remaining == 0)
+        {
+            bits_remaining = 8;
+            silence = !buffer_full;
+
+            if (buffer_full)
+            {
+                shift = sample_buffer;
+                buffer_full = false;
+                fetch (read);
+            }
+        }
+    }
+
+    delay = t - end;
+}
+
+APU::RP2A03::RP2A03 (const double _sample_rate, dmc_read_cb _dmc_read)
+: blip {cpu_clock, _sample_rate}
+, sample_rate {_sample_rate}
+, dmc_read {_dmc_read}
+{
+    reset ();
+}
+
+void APU::RP2A03::reset ()
+{
+    pulse_1  = {};
+    pulse_2  = {};
+    triangle = {};
+    noise    = {};
+    dmc      = {};
+
+    pulse_1.ones_complement = true;
+    pulse_1.output.weight  = pulse_weight;
+    pulse_2.output.weight  = pulse_weight;
+    triangle.output.weight = triangle_weight;
+    noise.output.weight    = noise_weight;
+    dmc.output.weight      = dmc_weight;
+
+    noise.shift = 1;
+    dmc.bits_remaining = 8;
+    dmc.silence = true;
+
+    blip.clear ();
+    for (auto& stem : stems)
+        stem.clear ();
+    connect_stems ();
+
+    time = 0;
+    frame_start = 0;
+
+    five_step = false;
+    irq_inhibit = false;
+    frame_irq = false;
+    frame_step = 0;
+    sequence_start = 0;
+    next_step = four_step_cycles[0];
+}
+
+void APU::RP2A03::write (const u16 address, const u8 data, const u64 cycle)
+{
+    run_until (cycle);
+
+    const auto write_pulse = [&data] (Pulse& pulse, const u16 reg)
+    {
+        switch (reg)
+        {
+            case 0:
+                pulse.duty = data >> 6;
+                pulse.halt = pulse.envelope.loop = (data >> 5) & 1;
+                pulse.envelope.constant = (data >> 4) & 1;
+                pulse.envelope.period = data & 0x0F;
+            break;
+            case 1:
+                pulse.sweep_enabled = data >> 7;
+                pulse.sweep_period = (data >> 4) & 0x07;
+                pulse.sweep_negate = (data >> 3) & 1;
+                pulse.sweep_shift = data & 0x07;
+                pulse.sweep_reload = true;
+            break;
+            case 2:
+                pulse.timer = (pulse.timer & 0x0700) | data;
+            break;
+            case 3:
+                pulse.timer = static_cast <u16> ((pulse.timer & 0x00FF) | ((data & 0x07) << 8));
+                if (pulse.enabled)
+                    pulse.length = length_table[data >> 3];
+                pulse.phase = 0;
+                pulse.envelope.start = true;
+            break;
+        }
+    };
+
+    switch (address)
+    {
+        case 0x4000: case 0x4001: case 0x4002: case 0x4003:
+            write_pulse (pulse_1, address & 3);
+        break;
+        case 0x4004: case 0x4005: case 0x4006: case 0x4007:
+            write_pulse (pulse_2, address & 3);
+        break;
+
+        case 0x4008:
+            triangle.control = data >> 7;
+            triangle.linear_period = data & 0x7F;
+        break;
+        case 0x400A:
+            triangle.timer = (triangle.timer & 0x0700) | data;
+        break;
+        case 0x400B:
+            triangle.timer = static_cast <u16> ((triangle.timer & 0x00FF) | ((data & 0x07) << 8));
+            if (triangle.enabled)
+                triangle.length = length_table[data >> 3];
+            triangle.linear_reload = true;
+        break;
+
+        case 0x400C:
+            noise.halt = noise.envelope.loop = (data >> 5) & 1;
+            noise.envelope.constant = (data >> 4) & 1;
+            noise.envelope.period = data & 0x0F;
+        break;
+        case 0x400E:
+            noise.mode = data >> 7;
+            noise.period = data & 0x0F;
+        break;
+        case 0x400F:
+            if (noise.enabled)
+                noise.length = length_table[data >> 3];
+            noise.envelope.start = true;
+        break;
+
+        case 0x4010:
+            dmc.irq_enabled = data >> 7;
+            dmc.loop = (data >> 6) & 1;
+            dmc.rate = data & 0x0F;
+            if (!dmc.irq_enabled)
+                dmc.irq = false;
+        break;
+        case 0x4011:
+            // direct load, the step goes out at this cycle
+            dmc.output.update (blip, static_cast <u32> (cycle - frame_start), data & 0x7F);
+        break;
+        case 0x4012:
+            dmc.sample_address = static_cast <u16> (0xC000 | (data << 6));
+        break;
+        case 0x4013:
+            dmc.sample_length = static_cast <u16> ((data << 4) | 1);
+        break;
+
+        case 0x4015:
+            pulse_1.enabled  = data & 0x01;
+            pulse_2.enabled  = data & 0x02;
+            triangle.enabled = data & 0x04;
+            noise.enabled    = data & 0x08;
+
+            if (!pulse_1.enabled)  pulse_1.length = 0;
+            if (!pulse_2.enabled)  pulse_2.length = 0;
+            if (!triangle.enabled) triangle.length = 0;
+            if (!noise.enabled)    noise.length = 0;
+
+            dmc.irq = false;
+            if (!(data & 0x10))
+                dmc.bytes_remaining = 0;
+            else if (dmc.bytes_remaining == 0)
+            {
+                dmc.restart ();
+                dmc.fetch (dmc_read);
+            }
+        break;
+
+        case 0x4017:
+            five_step = data >> 7;
+            irq_inhibit = (data >> 6) & 1;
+            if (irq_inhibit)
+                frame_irq = false;
+
+            sequence_start = cycle;
+            frame_step = 0;
+            next_step = cycle + (five_step ? five_step_cycles : four_step_cycles)[0];
+
+            if (five_step)
+            {
+                quarter_frame ();
+                half_frame ();
+            }
+        break;
+    }
+}
+
+u8 APU::RP2A03::read_status (const u64 cycle)
+{
+    run_until (cycle);
+
+    const u8 status = (pulse_1.length  > 0 ? 0x01 : 0)
+                    | (pulse_2.length  > 0 ? 0x02 : 0)
+                    | (triangle.length > 0 ? 0x04 : 0)
+                    | (noise.length    > 0 ? 0x08 : 0)
+                    | (dmc.bytes_remaining > 0 ? 0x10 : 0)
+                    | (frame_irq ? 0x40 : 0)
+                    | (dmc.irq   ? 0x80 : 0);
+
+    frame_irq = false;
+    return status;
+}
+
+void APU::RP2A03::end_frame (const u64 cycle)
+{
+    run_until (cycle);
+    blip.end_frame (static_cast <u32> (cycle - frame_start));
+    for (auto& stem : stems)
+        stem.end_frame (static_cast <u32> (cycle - frame_start));
+    frame_start = cycle;
+}
+
+bool APU::RP2A03::irq_pending (const u64 cycle)
+{
+    run_until (cycle);
+    return frame_irq || dmc.irq;
+}
+
+u64 APU::RP2A03::get_next_irq () const
+{
+    u64 next = five_step || irq_inhibit ? ~u64 {0} : sequence_start + four_step_cycles[3];
+
+    // the last byte is fetched as the shift register reloads, the current byte has bits_remaining
+    // output clocks left and every byte after it 8 more, the first clock is delay cycles after time
+    if (dmc.irq_enabled && !dmc.loop && dmc.buffer_full && dmc.bytes_remaining)
+    {
+        const u64 clocks = dmc.bits_remaining + 8 * (dmc.bytes_remaining - 1u);
+
+        // + 1, the channels only run up to but not including the cycle they are asked for
+        next = std::min (next, time + dmc.delay + (clocks - 1) * dmc_rates[dmc.rate] + 1);
+    }
+
+    return next;
+}
+
+APU::Blip_Buffer& APU::RP2A03::get_output ()
+{
+    return blip;
+}
+
+void APU::RP2A03::set_sample_rate (const double _sample_rate)
+{
+    sample_rate = _sample_rate;
+
+    blip.set_rates (cpu_clock, sample_rate);
+    for (auto& stem : stems)
+        stem.set_rates (cpu_clock, sample_rate);
+}
+
+void APU::RP2A03::enable_stems (const bool enable)
+{
+    if (enable == has_stems ())
+        return;
+
+    stems.clear ();
+
+    if (enable)
+    {
+        stems.reserve (static_cast <std::size_t> (Channel::COUNT));
+        for (std::size_t i = 0; i < static_cast <std::size_t> (Channel::COUNT); ++i)
+            stems.emplace_back (cpu_clock, sample_rate);
+    }
+
+    connect_stems ();
+
+    // the stems start mid frame, give them the level each channel is already at
+    const u32 now = static_cast <u32> (time - frame_start);
+    for (Output* output : outputs ())
+    {
+        if (output->stem)
+            output->stem->add_delta (now, output->level * output->weight);
+    }
+}
+
+bool APU::RP2A03::has_stems () const
+{
+    return !stems.empty();
+}
+
+APU::Blip_Buffer& APU::RP2A03::get_stem (const Channel channel)
+{
+    return stems[static_cast <std::size_t> (channel)];
+}
+
+std::array <APU::RP2A03::Output*, static_cast <std::size_t> (APU::RP2A03::Channel::COUNT)> APU::RP2A03::outputs ()
+{
+    return {&pulse_1.output, &pulse_2.output, &triangle.output, &noise.output, &dmc.output};
+}
+
+void APU::RP2A03::connect_stems ()
+{
+    const auto all = outputs ();
+    for (std::size_t i = 0; i < all.size(); ++i)
+        all[i]->stem = has_stems () ? &stems[i] : nullptr;
+}
+
+void APU::RP2A03::set_dmc_read (dmc_read_cb _dmc_read)
+{
+    dmc_read = _dmc_read;
+}
+
+void APU::RP2A03::run_until (const u64 cycle)
+{
+    // channels only run between frame counter steps, envelopes and lengths can't change in between
+    while (time < cycle)
+    {
+        const u64 end = std::min (cycle, next_step);
+        run_channels (end);
+        time = end;
+
+        if (time == next_step)
+            clock_frame_counter ();
+    }
+}
+
+void APU::RP2A03::run_channels (const u64 end)
+{
+    const u32 from = static_cast <u32> (time - frame_start);
+    const u32 to   = static_cast <u32> (end - frame_start);
+
+    pulse_1.run (blip, from, to);
+    pulse_2.run (blip, from, to);
+    triangle.run (blip, from, to);
+    noise.run (blip, from, to);
+    dmc.run (blip, dmc_read, from, to);
+}
+
+void APU::RP2A03::clock_frame_counter ()
+{
+    quarter_frame ();
+
+    if (frame_step == 1 || frame_step == 3)
+        half_frame ();
+
+    if (frame_step == 3 && !five_step && !irq_inhibit)
+        frame_irq = true;
+
+    if (++frame_step == 4)
+    {
+        frame_step = 0;
+        sequence_start += five_step ? five_step_period : four_step_period;
+    }
+
+    next_step = sequence_start + (five_step ? five_step_cycles : four_step_cycles)[frame_step];
+}
+
+void APU::RP2A03::quarter_frame ()
+{
+    pulse_1.envelope.clock ();
+    pulse_2.envelope.clock ();
+    noise.envelope.clock ();
+    triangle.clock_linear ();
+}
+
+void APU::RP2A03::half_frame ()
+{
+    pulse_1.clock_length ();
+    pulse_2.clock_length ();
+    triangle.clock_length ();
+    noise.clock_length ();
+    pulse_1.clock_sweep ();
+    pulse_2.clock_sweep ();
+}
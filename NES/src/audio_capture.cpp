@@ -0,0 +1,152 @@
+#include "audio_capture.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+namespace
+{
+    constexpr std::array <const char*, static_cast <std::size_t> (APU::Audio_Capture::Track::COUNT)> track_suffix
+    {
+        "",
+        "_pulse1",
+        "_pulse2",
+        "_triangle",
+        "_noise",
+        "_dmc",
+    };
+
+    std::string track_path (const std::string& path, const std::size_t track)
+    {
+        if (track == 0)
+            return path;
+
+        const std::filesystem::path base {path};
+        return (base.parent_path () / (base.stem().string() + track_suffix[track] + base.extension().string())).string();
+    }
+}
+
+APU::Audio_Capture::Audio_Capture (const std::string& path, const int sample_rate, const Wav_File::Format format, const bool stems, const Policy _policy)
+: samples_written {0}
+, failed {false}
+, writer {_policy}
+{
+    const std::size_t track_n = stems ? files.size() : 1;
+
+    // opened here so a bad path throws to the caller instead of failing on the writer
+    for (std::size_t track = 0; track < track_n; ++track)
+        files[track].emplace (track_path (path, track), sample_rate, 1, format);
+
+    writer.start ([this] (const Block& block) { return write_block (block); }, [this] { close_files (); });
+}
+
+APU::Audio_Capture::~Audio_Capture ()
+{
+    writer.stop ();
+}
+
+bool APU::Audio_Capture::submit (const Track track, std::span <const i16> samples)
+{
+    bool complete = true;
+
+    while (!samples.empty())
+    {
+        const std::size_t n = std::min (samples.size(), block_samples);
+
+        if (Block* block = writer.acquire ())
+        {
+            std::copy_n (samples.begin(), n, block->samples.begin());
+            block->count = static_cast <u16> (n);
+            block->track = track;
+            writer.publish ();
+        }
+        else
+            complete = false;
+
+        samples = samples.subspan (n);
+    }
+
+    return complete;
+}
+
+bool APU::Audio_Capture::submit_stems (RP2A03& apu)
+{
+    if (!has_stems () || !apu.has_stems ())
+        return false;
+
+    bool complete = true;
+
+    for (std::size_t channel = 0; channel < static_cast <std::size_t> (RP2A03::Channel::COUNT); ++channel)
+    {
+        auto& stem = apu.get_stem (static_cast <RP2A03::Channel> (channel));
+
+        // read straight into ring blocks, no staging copy
+        while (stem.samples_available ())
+        {
+            Block* block = writer.acquire ();
+
+            if (!block)
+            {
+                // dropped, but the stem still has to be drained or it overflows next frame
+                std::array <i16, block_samples> discard;
+                stem.read_samples (discard);
+                complete = false;
+                continue;
+            }
+
+            block->count = static_cast <u16> (stem.read_samples (block->samples));
+            block->track = static_cast <Track> (channel + 1);
+            writer.publish ();
+        }
+    }
+
+    return complete;
+}
+
+bool APU::Audio_Capture::has_stems () const
+{
+    return files[1].has_value ();
+}
+
+u64 APU::Audio_Capture::get_samples_written () const {return samples_written.load (std::memory_order_relaxed);}
+u64 APU::Audio_Capture::get_blocks_dropped () const {return writer.get_dropped ();}
+bool APU::Audio_Capture::has_failed () const {return failed.load (std::memory_order_relaxed);}
+
+bool APU::Audio_Capture::write_block (const Block& block)
+{
+    auto& file = files[static_cast <std::size_t> (block.track)];
+
+    // after a write error everything left is thrown away so submit () never hangs
+    if (failed.load (std::memory_order_relaxed) || !file)
+        return false;
+
+    file->write ({block.samples.data(), block.count});
+
+    if (file->good ())
+        samples_written.fetch_add (block.count, std::memory_order_relaxed);
+    else
+    {
+        std::cerr << "audio capture: write failed" << std::endl;
+        failed = true;
+    }
+
+    return true;
+}
+
+void APU::Audio_Capture::close_files ()
+{
+    for (auto& file : files)
+    {
+        if (!file)
+            continue;
+
+        try
+        {
+            file->close ();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "audio capture: " << e.what() << std::endl;
+            failed = true;
+        }
+    }
+}
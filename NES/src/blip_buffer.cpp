@@ -0,0 +1,156 @@
+#include "blip_buffer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+namespace
+{
+    constexpr int frac_bits = 32;
+
+    // blackman windowed sinc, cut off a bit below nyquist so the transition band stays out of the audible range
+    double impulse (const double x)
+    {
+        static constexpr double cutoff = 0.90;
+        static constexpr double half   = APU::Blip_Buffer::half_width;
+
+        if (std::abs (x) >= half)
+            return 0.0;
+
+        const double pi_x   = std::numbers::pi * x * cutoff;
+        const double sinc   = x == 0.0 ? 1.0 : std::sin (pi_x) / pi_x;
+        const double w      = std::numbers::pi * (x / half + 1.0);
+        const double window = 0.42 - 0.5 * std::cos (w) + 0.08 * std::cos (2.0 * w);
+        return sinc * cutoff * window;
+    }
+
+    // integral of the impulse over [a, b], simpson
+    double area (const double a, const double b)
+    {
+        static constexpr int steps = 64;
+        const double h = (b - a) / steps;
+        double sum = impulse (a) + impulse (b);
+
+        for (int i = 1; i < steps; ++i)
+            sum += impulse (a + i * h) * (i % 2 ? 4.0 : 2.0);
+
+        return sum * h / 3.0;
+    }
+}
+
+const APU::Blip_Buffer::Kernel& APU::Blip_Buffer::get_kernel ()
+{
+    /*
+        tap k of phase p is how much of the step lands in output sample k when
+        the step sits p / phase_n of a sample into the kernel. the taps of a
+        phase are rounded so they sum to exactly 1 << kernel_bits, otherwise the
+        integrator would drift a little on every edge
+    */
+    static const Kernel kernel = [] ()
+    {
+        Kernel result {};
+
+        for (int phase = 0; phase < phase_n; ++phase)
+        {
+            const double frac = static_cast <double> (phase) / phase_n;
+
+            std::array <double, width> taps;
+            double total = 0.0;
+
+            for (int k = 0; k < width; ++k)
+            {
+                const double x = k - (half_width - 1) - frac;
+                taps[k] = area (x - 1.0, x);
+                total += taps[k];
+            }
+
+            i32 sum = 0;
+            for (int k = 0; k < width; ++k)
+            {
+                result[phase][k] = static_cast <i32> (std::lround (taps[k] / total * (1 << kernel_bits)));
+                sum += result[phase][k];
+            }
+            result[phase][half_width - 1] += (1 << kernel_bits) - sum;
+        }
+
+        return result;
+    } ();
+
+    return kernel;
+}
+
+APU::Blip_Buffer::Blip_Buffer (const double clock_rate, const double sample_rate, const std::size_t max_samples)
+: kernel {get_kernel ()}
+, factor {0}
+, offset {0}
+, available {0}
+, integrator {0}
+, buffer (max_samples + width, 0)
+{
+    set_rates (clock_rate, sample_rate);
+}
+
+void APU::Blip_Buffer::set_rates (const double clock_rate, const double sample_rate)
+{
+    factor = static_cast <u64> (std::llround (sample_rate / clock_rate * static_cast <double> (u64 {1} << frac_bits)));
+}
+
+void APU::Blip_Buffer::add_delta (const u32 time, const int delta)
+{
+    const u64 fixed = time * factor + offset;
+    const std::size_t index = available + static_cast <std::size_t> (fixed >> frac_bits);
+    const int phase = static_cast <int> (fixed >> (frac_bits - phase_bits)) & (phase_n - 1);
+
+    // nobody read the samples, better to lose the edge than to write past the buffer
+    if (index + width > buffer.size())
+        return;
+
+    i32* out = buffer.data() + index;
+    const auto& taps = kernel[phase];
+
+    for (int k = 0; k < width; ++k)
+        out[k] += taps[k] * delta;
+}
+
+void APU::Blip_Buffer::end_frame (const u32 time)
+{
+    const u64 fixed = time * factor + offset;
+    available = std::min (available + static_cast <std::size_t> (fixed >> frac_bits), buffer.size() - width);
+    offset = fixed & ((u64 {1} << frac_bits) - 1);
+}
+
+std::size_t APU::Blip_Buffer::samples_available () const
+{
+    return available;
+}
+
+std::size_t APU::Blip_Buffer::read_samples (std::span <i16> out)
+{
+    const std::size_t n = std::min (out.size(), available);
+
+    i32 sum = integrator;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const i32 sample = std::clamp (sum >> kernel_bits, i32 {-32768}, i32 {32767});
+        out[i] = static_cast <i16> (sample);
+        sum += buffer[i];
+        sum -= sample << (kernel_bits - bass_shift);
+    }
+    integrator = sum;
+
+    // slide what is left, including the ringing tail, to the front
+    const std::size_t remaining = available - n + width;
+    std::memmove (buffer.data(), buffer.data() + n, remaining * sizeof(i32));
+    std::fill (buffer.begin() + remaining, buffer.begin() + remaining + n, 0);
+    available -= n;
+
+    return n;
+}
+
+void APU::Blip_Buffer::clear ()
+{
+    std::fill (buffer.begin(), buffer.end(), 0);
+    offset = 0;
+    available = 0;
+    integrator = 0;
+}
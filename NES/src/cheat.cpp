@@ -0,0 +1,79 @@
+#include "cheat.h"
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    constexpr std::string_view genie_letters = "APZLGITYEOXUKSVN";
+
+    int genie_digit (const char c)
+    {
+        const auto position = genie_letters.find (static_cast <char> (std::toupper (static_cast <unsigned char> (c))));
+        return position == std::string_view::npos ? -1 : static_cast <int> (position);
+    }
+
+    int hex_digit (const char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // each letter is 4 bits, scattered over address, value and compare (n5.3 is the
+    // value's bit 3 in 6 letter codes, the compare's in 8 letter ones)
+    Cheat::Code decode_genie (const int n[8], const bool long_code)
+    {
+        Cheat::Code code {};
+
+        code.address = static_cast <u16> (0x8000
+                     | ((n[3] & 7) << 12)
+                     | ((n[5] & 7) << 8) | ((n[4] & 8) << 8)
+                     | ((n[2] & 7) << 4) | ((n[1] & 8) << 4)
+                     |  (n[4] & 7)       |  (n[3] & 8));
+
+        code.value = static_cast <u8> (((n[1] & 7) << 4) | ((n[0] & 8) << 4) | (n[0] & 7) | ((long_code ? n[7] : n[5]) & 8));
+
+        if (long_code)
+        {
+            code.has_compare = true;
+            code.compare = static_cast <u8> (((n[7] & 7) << 4) | ((n[6] & 8) << 4) | (n[6] & 7) | (n[5] & 8));
+        }
+
+        return code;
+    }
+}
+
+Cheat::Code Cheat::decode (std::string_view text)
+{
+    // codes are often written in groups, "SXIO-PO"
+    std::string compact;
+    std::copy_if (text.begin(), text.end(), std::back_inserter (compact), [] (const char c) { return c != '-' && c != ' '; });
+
+    int digits[8] {};
+
+    if ((compact.size() == 6 || compact.size() == 8)
+        && std::all_of (compact.begin(), compact.end(), [] (const char c) { return genie_digit (c) >= 0; }))
+    {
+        for (std::size_t i = 0; i < compact.size(); ++i)
+            digits[i] = genie_digit (compact[i]);
+
+        return decode_genie (digits, compact.size() == 8);
+    }
+
+    if (compact.size() == 6 && std::all_of (compact.begin(), compact.end(), [] (const char c) { return hex_digit (c) >= 0; }))
+    {
+        for (std::size_t i = 0; i < compact.size(); ++i)
+            digits[i] = hex_digit (compact[i]);
+
+        Code code {};
+        code.address = static_cast <u16> ((digits[0] << 12) | (digits[1] << 8) | (digits[2] << 4) | digits[3]);
+        code.value   = static_cast <u8> ((digits[4] << 4) | digits[5]);
+        return code;
+    }
+
+    throw std::runtime_error ("cheat: " + std::string {text} + " is not a Game Genie or Pro Action Replay code");
+}
@@ -0,0 +1,214 @@
+#include "chr_cache.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    /*
+        bit plane interleaving
+
+        every row is two bytes (lo plane, hi plane) that have to be spread out
+        into 8 pixel bytes, msb first. the simd paths broadcast each plane byte
+        across 8 lanes with pshufb, test one bit per lane against a mask and
+        turn the result into 0 / 1 (lo) and 0 / 2 (hi).
+    */
+
+#if defined(__AVX2__)
+
+    // 4 rows per iteration
+    void decode_tile (const u8* src, u8* dst)
+    {
+        const __m256i tile = _mm256_broadcastsi128_si256 (_mm_loadu_si128 (reinterpret_cast <const __m128i*> (src)));
+        const __m256i bits = _mm256_set1_epi64x (0x0102040810204080);
+        const __m256i one  = _mm256_set1_epi8 (1);
+        const __m256i two  = _mm256_set1_epi8 (2);
+
+        for (int row = 0; row < 8; row += 4)
+        {
+            const char r = static_cast <char> (row);
+            const __m256i lo_index = _mm256_setr_epi8 (
+                r+0, r+0, r+0, r+0, r+0, r+0, r+0, r+0, r+1, r+1, r+1, r+1, r+1, r+1, r+1, r+1,
+                r+2, r+2, r+2, r+2, r+2, r+2, r+2, r+2, r+3, r+3, r+3, r+3, r+3, r+3, r+3, r+3);
+            const __m256i hi_index = _mm256_add_epi8 (lo_index, _mm256_set1_epi8 (8));
+
+            const __m256i lo = _mm256_shuffle_epi8 (tile, lo_index);
+            const __m256i hi = _mm256_shuffle_epi8 (tile, hi_index);
+
+            const __m256i lo_set = _mm256_cmpeq_epi8 (_mm256_and_si256 (lo, bits), bits);
+            const __m256i hi_set = _mm256_cmpeq_epi8 (_mm256_and_si256 (hi, bits), bits);
+
+            const __m256i pixels = _mm256_or_si256 (_mm256_and_si256 (lo_set, one), _mm256_and_si256 (hi_set, two));
+            _mm256_storeu_si256 (reinterpret_cast <__m256i*> (dst + row * 8), pixels);
+        }
+    }
+
+#elif defined(__SSSE3__)
+
+    // 2 rows per iteration
+    void decode_tile (const u8* src, u8* dst)
+    {
+        const __m128i tile = _mm_loadu_si128 (reinterpret_cast <const __m128i*> (src));
+        const __m128i bits = _mm_set1_epi64x (0x0102040810204080);
+        const __m128i one  = _mm_set1_epi8 (1);
+        const __m128i two  = _mm_set1_epi8 (2);
+
+        for (int row = 0; row < 8; row += 2)
+        {
+            const char r = static_cast <char> (row);
+            const __m128i lo_index = _mm_setr_epi8 (r+0, r+0, r+0, r+0, r+0, r+0, r+0, r+0, r+1, r+1, r+1, r+1, r+1, r+1, r+1, r+1);
+            const __m128i hi_index = _mm_add_epi8 (lo_index, _mm_set1_epi8 (8));
+
+            const __m128i lo = _mm_shuffle_epi8 (tile, lo_index);
+            const __m128i hi = _mm_shuffle_epi8 (tile, hi_index);
+
+            const __m128i lo_set = _mm_cmpeq_epi8 (_mm_and_si128 (lo, bits), bits);
+            const __m128i hi_set = _mm_cmpeq_epi8 (_mm_and_si128 (hi, bits), bits);
+
+            const __m128i pixels = _mm_or_si128 (_mm_and_si128 (lo_set, one), _mm_and_si128 (hi_set, two));
+            _mm_storeu_si128 (reinterpret_cast <__m128i*> (dst + row * 8), pixels);
+        }
+    }
+
+#else
+
+    /*
+        portable version, spreads the 8 bits of a byte into the low bit of 8 bytes
+        with one multiply. the shifted copies (x << 9k) never overlap so there are
+        no carries and bit 7 of byte k ends up holding bit (7 - k) of x
+    */
+    constexpr u64 spread (const u8 x)
+    {
+        return ((x * 0x8040201008040201) >> 7) & 0x0101010101010101;
+    }
+
+    void decode_tile (const u8* src, u8* dst)
+    {
+        for (int row = 0; row < 8; ++row)
+        {
+            const u64 pixels = spread (src[row]) | (spread (src[row + 8]) << 1);
+            std::memcpy (dst + row * 8, &pixels, sizeof(pixels));
+        }
+    }
+
+#endif
+
+    void flip_horizontal (const u8* src, u8* dst)
+    {
+        for (int row = 0; row < 8; ++row)
+        {
+            u64 pixels;
+            std::memcpy (&pixels, src + row * 8, sizeof(pixels));
+            pixels = std::byteswap (pixels);
+            std::memcpy (dst + row * 8, &pixels, sizeof(pixels));
+        }
+    }
+
+    void flip_vertical (const u8* src, u8* dst)
+    {
+        for (int row = 0; row < 8; ++row)
+            std::memcpy (dst + row * 8, src + (7 - row) * 8, 8);
+    }
+}
+
+PPU::CHR_Cache::CHR_Cache (std::span <const u8> _chr, const bool _with_flips)
+: chr {_chr}
+, with_flips {_with_flips}
+, tiles (chr.size() / tile_bytes * (_with_flips ? 4 : 1))
+, dirty ((chr.size() / tile_bytes + 63) / 64, ~u64 {0})
+, generation (chr.size() / tile_bytes, 0)
+{}
+
+void PPU::CHR_Cache::set_chr (std::span <const u8> _chr)
+{
+    chr = _chr;
+}
+
+const PPU::CHR_Cache::Tile& PPU::CHR_Cache::get_tile (const std::size_t index, const Flip flip)
+{
+    if (is_dirty (index))
+        decode (index);
+
+    return with_flips ? tiles[index * 4 + flip] : tiles[index];
+}
+
+void PPU::CHR_Cache::invalidate (const std::size_t address)
+{
+    const std::size_t index = address / tile_bytes;
+    dirty[index / 64] |= u64 {1} << (index % 64);
+    ++generation[index];
+}
+
+void PPU::CHR_Cache::invalidate (const std::size_t begin, const std::size_t end)
+{
+    for (std::size_t index = begin / tile_bytes; index * tile_bytes < end; ++index)
+    {
+        dirty[index / 64] |= u64 {1} << (index % 64);
+        ++generation[index];
+    }
+}
+
+void PPU::CHR_Cache::invalidate_all ()
+{
+    std::fill (dirty.begin(), dirty.end(), ~u64 {0});
+
+    for (auto& g : generation)
+        ++g;
+}
+
+void PPU::CHR_Cache::rebuild ()
+{
+    const std::size_t tile_n = size();
+
+    for (std::size_t i = 0; i < dirty.size(); ++i)
+    {
+        // walk the set bits only, clean words cost one compare
+        while (dirty[i])
+        {
+            const std::size_t index = i * 64 + std::countr_zero (dirty[i]);
+            if (index >= tile_n)
+            {
+                dirty[i] = 0;
+                break;
+            }
+            decode (index);
+        }
+    }
+}
+
+std::size_t PPU::CHR_Cache::size () const
+{
+    return chr.size() / tile_bytes;
+}
+
+bool PPU::CHR_Cache::is_dirty (const std::size_t index) const
+{
+    return (dirty[index / 64] >> (index % 64)) & 1;
+}
+
+u32 PPU::CHR_Cache::get_generation (const std::size_t index) const
+{
+    return generation[index];
+}
+
+void PPU::CHR_Cache::decode (const std::size_t index)
+{
+    const u8* src = chr.data() + index * tile_bytes;
+
+    if (with_flips)
+    {
+        Tile* variants = &tiles[index * 4];
+        decode_tile (src, variants[NONE].data());
+        flip_horizontal (variants[NONE].data(), variants[HORIZONTAL].data());
+        flip_vertical (variants[NONE].data(), variants[VERTICAL].data());
+        flip_vertical (variants[HORIZONTAL].data(), variants[BOTH].data());
+    }
+    else
+        decode_tile (src, tiles[index].data());
+
+    dirty[index / 64] &= ~(u64 {1} << (index % 64));
+}
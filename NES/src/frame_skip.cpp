@@ -0,0 +1,35 @@
+#include "frame_skip.h"
+#include <algorithm>
+
+PPU::Frame_Skip::Frame_Skip (const int _present_every)
+: present_every {std::max (_present_every, 1)}
+, frame_count {}
+, presented {true}
+{}
+
+bool PPU::Frame_Skip::begin_frame ()
+{
+    presented = frame_count % present_every == 0;
+    ++frame_count;
+    return presented;
+}
+
+bool PPU::Frame_Skip::is_presented () const
+{
+    return presented;
+}
+
+void PPU::Frame_Skip::set_present_every (const int n)
+{
+    present_every = std::max (n, 1);
+}
+
+int PPU::Frame_Skip::get_present_every () const
+{
+    return present_every;
+}
+
+u64 PPU::Frame_Skip::get_frame_count () const
+{
+    return frame_count;
+}
@@ -0,0 +1,320 @@
+#include "hash.h"
+#include <bit>
+#include <cstring>
+
+#if (defined(__PCLMUL__) && defined(__SSE4_1__)) || defined(__SHA__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    constexpr u32 crc_polynomial = 0xEDB88320; // reflected 0x04C11DB7
+
+    // table[k][b] is the crc of byte b followed by k zero bytes
+    constexpr auto crc_tables = []
+    {
+        std::array <std::array <u32, 256>, 8> table {};
+
+        for (u32 b = 0; b < 256; ++b)
+        {
+            u32 crc = b;
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc >> 1) ^ (crc & 1 ? crc_polynomial : 0);
+            table[0][b] = crc;
+        }
+
+        for (u32 b = 0; b < 256; ++b)
+            for (int k = 1; k < 8; ++k)
+                table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+
+        return table;
+    } ();
+
+    // works on the inverted crc
+    u32 crc32_slice8 (const u8* data, std::size_t size, u32 crc)
+    {
+        const auto& t = crc_tables;
+
+        while (size >= 8)
+        {
+            u32 lo;
+            u32 hi;
+            std::memcpy (&lo, data, 4);
+            std::memcpy (&hi, data + 4, 4);
+
+            if constexpr (std::endian::native == std::endian::big)
+            {
+                lo = std::byteswap (lo);
+                hi = std::byteswap (hi);
+            }
+
+            lo ^= crc;
+
+            crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+                ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+
+            data += 8;
+            size -= 8;
+        }
+
+        while (size--)
+            crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+
+        return crc;
+    }
+
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+    /*
+        folding constants for the reflected polynomial, x^(4*128+32) mod P and
+        x^(4*128-32) mod P for the 4 way fold, the same for 128 bits, then the
+        64 -> 32 bit reduction and the barrett constants (mu, P)
+    */
+    alignas (16) constexpr u64 k1k2[2] {0x0154442BD4, 0x01C6E41596};
+    alignas (16) constexpr u64 k3k4[2] {0x01751997D0, 0x00CCAA009E};
+    alignas (16) constexpr u64 k5k0[2] {0x0163CD6124, 0x0000000000};
+    alignas (16) constexpr u64 poly[2] {0x01DB710641, 0x01F7011641};
+
+    // size is >= 64 and a multiple of 16, works on the inverted crc
+    u32 crc32_fold (const u8* data, std::size_t size, const u32 crc)
+    {
+        const auto load = [] (const u8* p) { return _mm_loadu_si128 (reinterpret_cast <const __m128i*> (p)); };
+
+        // the full product of a lane with k, both halves xored together
+        const auto fold = [] (const __m128i x, const __m128i k, const __m128i next)
+        {
+            const __m128i lo = _mm_clmulepi64_si128 (x, k, 0x00);
+            const __m128i hi = _mm_clmulepi64_si128 (x, k, 0x11);
+            return _mm_xor_si128 (_mm_xor_si128 (lo, hi), next);
+        };
+
+        __m128i x1 = _mm_xor_si128 (load (data), _mm_cvtsi32_si128 (static_cast <int> (crc)));
+        __m128i x2 = load (data + 16);
+        __m128i x3 = load (data + 32);
+        __m128i x4 = load (data + 48);
+
+        data += 64;
+        size -= 64;
+
+        // four independent lanes keep the multiplier busy
+        __m128i k = _mm_load_si128 (reinterpret_cast <const __m128i*> (k1k2));
+        while (size >= 64)
+        {
+            x1 = fold (x1, k, load (data));
+            x2 = fold (x2, k, load (data + 16));
+            x3 = fold (x3, k, load (data + 32));
+            x4 = fold (x4, k, load (data + 48));
+
+            data += 64;
+            size -= 64;
+        }
+
+        k = _mm_load_si128 (reinterpret_cast <const __m128i*> (k3k4));
+        x1 = fold (x1, k, x2);
+        x1 = fold (x1, k, x3);
+        x1 = fold (x1, k, x4);
+
+        while (size >= 16)
+        {
+            x1 = fold (x1, k, load (data));
+            data += 16;
+            size -= 16;
+        }
+
+        // 128 -> 64 bits
+        const __m128i mask32 = _mm_setr_epi32 (~0, 0, ~0, 0);
+
+        __m128i t = _mm_clmulepi64_si128 (x1, k, 0x10);
+        x1 = _mm_xor_si128 (_mm_srli_si128 (x1, 8), t);
+
+        k = _mm_loadl_epi64 (reinterpret_cast <const __m128i*> (k5k0));
+        t = _mm_srli_si128 (x1, 4);
+        x1 = _mm_clmulepi64_si128 (_mm_and_si128 (x1, mask32), k, 0x00);
+        x1 = _mm_xor_si128 (x1, t);
+
+        // barrett reduction to 32 bits
+        k = _mm_load_si128 (reinterpret_cast <const __m128i*> (poly));
+        t = _mm_clmulepi64_si128 (_mm_and_si128 (x1, mask32), k, 0x10);
+        t = _mm_clmulepi64_si128 (_mm_and_si128 (t, mask32), k, 0x00);
+        x1 = _mm_xor_si128 (x1, t);
+
+        return static_cast <u32> (_mm_extract_epi32 (x1, 1));
+    }
+#endif
+
+    constexpr std::array <u32, 5> sha1_init {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+#if defined(__SHA__) && defined(__SSE4_1__)
+    // SHA extensions, 4 rounds per sha1rnds4, the message schedule is interleaved with the rounds
+    void sha1_blocks (std::array <u32, 5>& state, const u8* data, std::size_t blocks)
+    {
+        const __m128i byte_swap = _mm_set_epi64x (0x0001020304050607, 0x08090A0B0C0D0E0F);
+
+        const auto rounds = [] (const __m128i abcd, const __m128i e, const int function)
+        {
+            switch (function)
+            {
+                case 0:  return _mm_sha1rnds4_epu32 (abcd, e, 0);
+                case 1:  return _mm_sha1rnds4_epu32 (abcd, e, 1);
+                case 2:  return _mm_sha1rnds4_epu32 (abcd, e, 2);
+                default: return _mm_sha1rnds4_epu32 (abcd, e, 3);
+            }
+        };
+
+        __m128i abcd = _mm_shuffle_epi32 (_mm_loadu_si128 (reinterpret_cast <const __m128i*> (state.data())), 0x1B);
+        __m128i e0   = _mm_set_epi32 (static_cast <int> (state[4]), 0, 0, 0);
+
+        for (; blocks; --blocks, data += 64)
+        {
+            const __m128i abcd_save = abcd;
+            const __m128i e0_save   = e0;
+
+            __m128i msg[4];
+            __m128i e[2] {e0, {}};
+
+            // group g is rounds 4g .. 4g+3. fully unrolled every branch and index below is constant,
+            // left as a loop the switch and the msg[] indexing cost more than half the speed
+            #pragma GCC unroll 20
+            for (int g = 0; g < 20; ++g)
+            {
+                const int m = g & 3;
+                __m128i& current = e[g & 1];
+
+                if (g < 4)
+                    msg[m] = _mm_shuffle_epi8 (_mm_loadu_si128 (reinterpret_cast <const __m128i*> (data + g * 16)), byte_swap);
+
+                current = g == 0 ? _mm_add_epi32 (current, msg[0]) : _mm_sha1nexte_epu32 (current, msg[m]);
+                e[(g + 1) & 1] = abcd;
+
+                if (g >= 3 && g <= 18)
+                    msg[(m + 1) & 3] = _mm_sha1msg2_epu32 (msg[(m + 1) & 3], msg[m]);
+
+                abcd = rounds (abcd, current, g / 5);
+
+                if (g >= 1 && g <= 16)
+                    msg[(m + 3) & 3] = _mm_sha1msg1_epu32 (msg[(m + 3) & 3], msg[m]);
+                if (g >= 2 && g <= 17)
+                    msg[(m + 2) & 3] = _mm_xor_si128 (msg[(m + 2) & 3], msg[m]);
+            }
+
+            e0   = _mm_sha1nexte_epu32 (e[0], e0_save);
+            abcd = _mm_add_epi32 (abcd, abcd_save);
+        }
+
+        _mm_storeu_si128 (reinterpret_cast <__m128i*> (state.data()), _mm_shuffle_epi32 (abcd, 0x1B));
+        state[4] = static_cast <u32> (_mm_extract_epi32 (e0, 3));
+    }
+#else
+    void sha1_block (std::array <u32, 5>& state, const u8* block)
+    {
+        std::array <u32, 80> w;
+
+        for (int i = 0; i < 16; ++i)
+            w[i] = (u32 {block[i * 4]} << 24) | (u32 {block[i * 4 + 1]} << 16) | (u32 {block[i * 4 + 2]} << 8) | block[i * 4 + 3];
+
+        for (int i = 16; i < 80; ++i)
+            w[i] = std::rotl (w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        u32 a = state[0];
+        u32 b = state[1];
+        u32 c = state[2];
+        u32 d = state[3];
+        u32 e = state[4];
+
+        for (int i = 0; i < 80; ++i)
+        {
+            u32 f;
+            u32 k;
+
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+
+            const u32 t = std::rotl (a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = std::rotl (b, 30);
+            b = a;
+            a = t;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    void sha1_blocks (std::array <u32, 5>& state, const u8* data, std::size_t blocks)
+    {
+        for (; blocks; --blocks, data += 64)
+            sha1_block (state, data);
+    }
+#endif
+}
+
+u32 Hash::crc32 (std::span <const u8> data, const u32 crc)
+{
+    const u8* p = data.data();
+    std::size_t size = data.size();
+    u32 state = ~crc;
+
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+    if (size >= 64)
+    {
+        const std::size_t folded = size & ~std::size_t {15};
+        state = crc32_fold (p, folded, state);
+        p += folded;
+        size -= folded;
+    }
+#endif
+
+    return ~crc32_slice8 (p, size, state);
+}
+
+Hash::SHA1_Digest Hash::sha1 (std::span <const u8> data)
+{
+    std::array <u32, 5> state = sha1_init;
+
+    const std::size_t full = data.size() / 64 * 64;
+    sha1_blocks (state, data.data(), full / 64);
+
+    // padding: 0x80, zeros, then the bit length big endian, one or two blocks
+    std::array <u8, 128> tail {};
+    const std::size_t rest = data.size() - full;
+    if (rest)
+        std::memcpy (tail.data(), data.data() + full, rest);
+    tail[rest] = 0x80;
+
+    const std::size_t tail_size = rest < 56 ? 64 : 128;
+    const u64 bits = static_cast <u64> (data.size()) * 8;
+    for (int i = 0; i < 8; ++i)
+        tail[tail_size - 1 - i] = static_cast <u8> (bits >> (i * 8));
+
+    sha1_blocks (state, tail.data(), tail_size / 64);
+
+    SHA1_Digest digest;
+    for (int i = 0; i < 5; ++i)
+    {
+        digest[i * 4]     = static_cast <u8> (state[i] >> 24);
+        digest[i * 4 + 1] = static_cast <u8> (state[i] >> 16);
+        digest[i * 4 + 2] = static_cast <u8> (state[i] >> 8);
+        digest[i * 4 + 3] = static_cast <u8> (state[i]);
+    }
+
+    return digest;
+}
+
+std::string Hash::to_hex (const SHA1_Digest& digest)
+{
+    static constexpr char digits[] = "0123456789abcdef";
+
+    std::string hex (digest.size() * 2, '0');
+    for (std::size_t i = 0; i < digest.size(); ++i)
+    {
+        hex[i * 2]     = digits[digest[i] >> 4];
+        hex[i * 2 + 1] = digits[digest[i] & 0x0F];
+    }
+
+    return hex;
+}
@@ -1,25 +1,275 @@
 #include "mapper.h"
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
 
-Mapper::Mapper (u8 _prg_banks, u8 _chr_banks)
-: prg_banks {_prg_banks}
-, chr_banks {_chr_banks}
-{}
+namespace
+{
+    // function local so registrations from other translation units never run before it exists
+    std::map <u16, Mapper::Factory>& factories ()
+    {
+        static std::map <u16, Mapper::Factory> registry;
+        return registry;
+    }
+}
+
+std::unique_ptr <Mapper> Mapper::create (const u16 id, std::span <const u8> prg, std::span <const u8> chr, std::span <u8> chr_ram, const Mirroring mirroring)
+{
+    const auto it = factories ().find (id);
+    if (it == factories ().end())
+        throw std::runtime_error ("mapper " + std::to_string (id) + " is not supported");
+
+    return it->second (prg, chr, chr_ram, mirroring);
+}
+
+bool Mapper::add_factory (const u16 id, Factory factory)
+{
+    return factories ().emplace (id, factory).second;
+}
+
+namespace
+{
+    template <class... M>
+    bool add_boards (Board_List <M...>)
+    {
+        bool added = true;
+        ((added = Mapper::add_factory <M> () && added), ...);
+        return added;
+    }
+
+    [[maybe_unused]] const bool boards_registered = add_boards (Boards {});
+}
+
+Mapper::Mapper (std::span <const u8> _prg, std::span <const u8> _chr, std::span <u8> _chr_ram, const Mirroring _mirroring)
+: prg {_prg}
+, chr {_chr}
+, chr_ram {_chr_ram}
+, mirroring {_mirroring}
+, prg_ram_enabled {true}
+, prg_ram_writable {true}
+, prg_banks {}
+, chr_banks {}
+, prg_offsets {}
+, chr_offsets {}
+, prg_pages {}
+, prg_ram {}
+, prg_ram_owned (0x2000, 0)
+, prg_ram_dirty {false}
+{
+    prg_ram = prg_ram_owned;
+
+    // until the derived reset () picks real banks, every window sees the start of the rom
+    set_prg_32k (0);
+    set_chr_8k (0);
+}
 
 Mapper::~Mapper()
 {}
 
-Mapper_000::Mapper_000 (const u8 _prg_banks, const u8 _chr_banks)
-: Mapper {_prg_banks, _chr_banks}
+bool Mapper::prg_ram_read (const u16 address, u8& data) const
+{
+    if (!prg_ram_enabled)
+        return false;
+
+    data = prg_ram[address & 0x1FFF];
+    return true;
+}
+
+bool Mapper::prg_ram_write (const u16 address, const u8 data)
+{
+    if (!prg_ram_enabled || !prg_ram_writable)
+        return false;
+
+    prg_ram[address & 0x1FFF] = data;
+    prg_ram_dirty = true;
+    return true;
+}
+
+void Mapper::clock_scanline ()
 {}
 
-Mapper_000::~Mapper_000 ()
+bool Mapper::irq_pending () const
+{
+    return false;
+}
+
+Mapper::Mirroring Mapper::get_mirroring () const
+{
+    return mirroring;
+}
+
+u32 Mapper::prg_offset (const u16 address) const
+{
+    return prg_offsets[(address >> 13) & 0x03] + (address & (prg_window - 1));
+}
+
+void Mapper::set_memory (std::span <const u8> _prg, std::span <const u8> _chr, std::span <u8> _chr_ram)
+{
+    prg = _prg;
+    chr = _chr;
+    chr_ram = _chr_ram;
+
+    for (std::size_t i = 0; i < prg_banks.size(); ++i)
+    {
+        prg_banks[i] = prg.data() + prg_offsets[i];
+        map_prg_pages (static_cast <int> (i));
+    }
+
+    for (std::size_t i = 0; i < chr_banks.size(); ++i)
+        chr_banks[i] = chr.data() + chr_offsets[i];
+}
+
+std::span <u8> Mapper::get_prg_ram ()
+{
+    return prg_ram;
+}
+
+void Mapper::set_prg_ram (std::span <u8> _prg_ram)
+{
+    prg_ram = _prg_ram;
+    prg_ram_owned = {};
+}
+
+bool Mapper::take_prg_ram_dirty ()
+{
+    const bool dirty = prg_ram_dirty;
+    prg_ram_dirty = false;
+    return dirty;
+}
+
+void Mapper::set_rom_patches (std::span <const Cheat::Code> patches)
+{
+    rom_patches.clear ();
+    std::copy_if (patches.begin(), patches.end(), std::back_inserter (rom_patches), [] (const Cheat::Code& code) { return code.address >= 0x8000; });
+
+    if (rom_patches.empty())
+        overlays = {};
+    else
+        overlays.resize (prg_pages.size());
+
+    for (int window = 0; window < 4; ++window)
+        map_prg_pages (window);
+}
+
+void Mapper::map_prg_pages (const int window)
+{
+    constexpr int pages_per_window = prg_window / 0x100;
+
+    const u8* bank = prg_banks[window];
+    const int first = window * pages_per_window;
+
+    for (int i = 0; i < pages_per_window; ++i)
+        prg_pages[first + i] = bank + i * 0x100;
+
+    for (const auto& patch : rom_patches)
+    {
+        const int page = (patch.address >> 8) & 0x7F;
+        if (page / pages_per_window != window)
+            continue;
+
+        const u8* rom_page = bank + (page - first) * 0x100;
+
+        // compares are against rom, not against an earlier patch to the same byte
+        if (patch.has_compare && rom_page[patch.address & 0xFF] != patch.compare)
+            continue;
+
+        // first patch to this page since the window was mapped
+        if (prg_pages[page] == rom_page)
+        {
+            std::copy_n (rom_page, 0x100, overlays[page].begin());
+            prg_pages[page] = overlays[page].data();
+        }
+
+        overlays[page][patch.address & 0xFF] = patch.value;
+    }
+}
+
+u32 Mapper::prg_bank_n () const
+{
+    return static_cast <u32> (prg.size() / prg_window);
+}
+
+u32 Mapper::chr_bank_n () const
+{
+    return static_cast <u32> (chr.size() / chr_window);
+}
+
+void Mapper::set_prg_8k (const int window, const int bank)
+{
+    const int n = static_cast <int> (prg_bank_n ());
+
+    // nothing to map, NES_ROM doesn't load a rom without prg
+    if (n == 0)
+        return;
+
+    const u32 offset = static_cast <u32> (((bank % n) + n) % n) * prg_window;
+
+    prg_offsets[window] = offset;
+    prg_banks[window] = prg.data() + offset;
+    map_prg_pages (window);
+}
+
+void Mapper::set_prg_16k (const int window, const int bank)
+{
+    set_prg_8k (window * 2,     bank * 2);
+    set_prg_8k (window * 2 + 1, bank * 2 + 1);
+}
+
+void Mapper::set_prg_32k (const int bank)
+{
+    for (int window = 0; window < 4; ++window)
+        set_prg_8k (window, bank * 4 + window);
+}
+
+void Mapper::set_chr_1k (const int window, const int bank)
+{
+    const int n = static_cast <int> (chr_bank_n ());
+
+    // a rom without chr gets chr ram here instead, an empty span has no banks to pick from
+    if (n == 0)
+        return;
+
+    const u32 offset = static_cast <u32> (((bank % n) + n) % n) * chr_window;
+
+    chr_offsets[window] = offset;
+    chr_banks[window] = chr.data() + offset;
+}
+
+void Mapper::set_chr_2k (const int window, const int bank)
+{
+    for (int i = 0; i < 2; ++i)
+        set_chr_1k (window * 2 + i, bank * 2 + i);
+}
+
+void Mapper::set_chr_4k (const int window, const int bank)
+{
+    for (int i = 0; i < 4; ++i)
+        set_chr_1k (window * 4 + i, bank * 4 + i);
+}
+
+void Mapper::set_chr_8k (const int bank)
+{
+    for (int i = 0; i < 8; ++i)
+        set_chr_1k (i, bank * 8 + i);
+}
+
+
+/* NROM */
+
+Mapper_000::Mapper_000 (std::span <const u8> _prg, std::span <const u8> _chr, std::span <u8> _chr_ram, const Mirroring _mirroring)
+: Mapper {_prg, _chr, _chr_ram, _mirroring}
+{
+    reset ();
+}
+
+void Mapper_000::cpu_write ([[maybe_unused]] const u16 address, [[maybe_unused]] const u8 data)
 {}
 
-bool Mapper_000::cpu_read (const u16 address, u32& mapped_address, [[maybe_unused]] u8& data)
+void Mapper_000::reset ()
 {
     /*
-        EXAMPLE
-        
         16kb----------------------------
         program address      rom address
         $8000 - $BFFF   -->  $0000 - $3FFF
@@ -28,22 +278,283 @@ bool Mapper_000::cpu_read (const u16 address, u32& mapped_address, [[maybe_unuse
         32kb----------------------------
         program address      rom address
         $8000 - $FFFF   -->  $0000 - $7FFF
-
     */
+    set_prg_32k (0);
+    set_chr_8k (0);
+}
 
-    // address range check
-    if (!(address >= 0x8000 && address <= 0xFFFF))
-        return false;
-    
-    mapped_address = address & (prg_banks > 1 ? 0x7FFF : 0x3FFF);
-    return true;
+
+/* MMC1 */
+
+Mapper_001::Mapper_001 (std::span <const u8> _prg, std::span <const u8> _chr, std::span <u8> _chr_ram, const Mirroring _mirroring)
+: Mapper {_prg, _chr, _chr_ram, _mirroring}
+{
+    reset ();
 }
 
+void Mapper_001::reset ()
+{
+    shift = 0x10;
+    control = 0x0C; // prg mode 3, last bank fixed at $C000
+    chr_bank_0 = 0;
+    chr_bank_1 = 0;
+    prg_bank = 0;
+    update_banks ();
+}
 
-bool Mapper_000::cpu_write (u16 address, u32& mapped_address, const u8 data)
+void Mapper_001::cpu_write (const u16 address, const u8 data)
 {
-    (void) address;
-    (void) mapped_address;
-    (void) data;
-    return false;
+    if (address < 0x8000)
+        return;
+
+    if (data & 0x80)
+    {
+        shift = 0x10;
+        control |= 0x0C;
+        update_banks ();
+        return;
+    }
+
+    // the marker bit reaching bit 0 means this is the 5th write
+    const bool complete = shift & 0x01;
+    shift = static_cast <u8> ((shift >> 1) | ((data & 0x01) << 4));
+
+    if (!complete)
+        return;
+
+    switch ((address >> 13) & 0x03)
+    {
+        case 0: control    = shift; break;
+        case 1: chr_bank_0 = shift; break;
+        case 2: chr_bank_1 = shift; break;
+        case 3: prg_bank   = shift; break;
+    }
+
+    shift = 0x10;
+    update_banks ();
+}
+
+void Mapper_001::update_banks ()
+{
+    static constexpr Mirroring mirroring_modes[4] {Mirroring::SINGLE_LOW, Mirroring::SINGLE_HIGH, Mirroring::VERTICAL, Mirroring::HORIZONTAL};
+    mirroring = mirroring_modes[control & 0x03];
+
+    // SUROM, 512 KB of prg in two 256 KB halves picked by chr bank 0 bit 4
+    const int outer = prg.size() > 0x40000 ? (chr_bank_0 & 0x10) : 0;
+    const int bank = outer | (prg_bank & 0x0F);
+
+    switch ((control >> 2) & 0x03)
+    {
+        case 0:
+        case 1: // 32 KB, low bit ignored
+            set_prg_16k (0, bank & ~1);
+            set_prg_16k (1, bank | 1);
+        break;
+        case 2: // first bank fixed at $8000
+            set_prg_16k (0, outer);
+            set_prg_16k (1, bank);
+        break;
+        case 3: // last bank fixed at $C000
+            set_prg_16k (0, bank);
+            set_prg_16k (1, outer | 0x0F);
+        break;
+    }
+
+    if (control & 0x10)
+    {
+        set_chr_4k (0, chr_bank_0);
+        set_chr_4k (1, chr_bank_1);
+    }
+    else
+        set_chr_8k (chr_bank_0 >> 1);
+
+    prg_ram_enabled = !(prg_bank & 0x10);
+}
+
+
+/* UxROM */
+
+Mapper_002::Mapper_002 (std::span <const u8> _prg, std::span <const u8> _chr, std::span <u8> _chr_ram, const Mirroring _mirroring)
+: Mapper {_prg, _chr, _chr_ram, _mirroring}
+{
+    reset ();
+}
+
+void Mapper_002::reset ()
+{
+    set_prg_16k (0, 0);
+    set_prg_16k (1, -1);
+    set_chr_8k (0);
+}
+
+void Mapper_002::cpu_write (const u16 address, const u8 data)
+{
+    if (address >= 0x8000)
+        set_prg_16k (0, data);
+}
+
+
+/* CNROM */
+
+Mapper_003::Mapper_003 (std::span <const u8> _prg, std::span <const u8> _chr, std::span <u8> _chr_ram, const Mirroring _mirroring)
+: Mapper {_prg, _chr, _chr_ram, _mirroring}
+{
+    reset ();
+}
+
+void Mapper_003::reset ()
+{
+    set_prg_32k (0);
+    set_chr_8k (0);
+}
+
+void Mapper_003::cpu_write (const u16 address, const u8 data)
+{
+    if (address >= 0x8000)
+        set_chr_8k (data);
+}
+
+
+/* MMC3 */
+
+Mapper_004::Mapper_004 (std::span <const u8> _prg, std::span <const u8> _chr, std::span <u8> _chr_ram, const Mirroring _mirroring)
+: Mapper {_prg, _chr, _chr_ram, _mirroring}
+, four_screen {_mirroring == Mirroring::FOUR_SCREEN}
+{
+    reset ();
+}
+
+void Mapper_004::reset ()
+{
+    bank_select = 0;
+    registers = {0, 2, 4, 5, 6, 7, 0, 1};
+
+    irq_latch = 0;
+    irq_counter = 0;
+    irq_reload = false;
+    irq_enabled = false;
+    irq = false;
+
+    update_banks ();
+}
+
+void Mapper_004::cpu_write (const u16 address, const u8 data)
+{
+    if (address < 0x8000)
+        return;
+
+    const bool odd = address & 0x01;
+
+    switch (address & 0xE000)
+    {
+        case 0x8000:
+            if (odd)
+                registers[bank_select & 0x07] = data;
+            else
+                bank_select = data;
+            update_banks ();
+        break;
+        case 0xA000:
+            if (odd)
+            {
+                prg_ram_enabled  = data & 0x80;
+                prg_ram_writable = !(data & 0x40);
+            }
+            else if (!four_screen)
+                mirroring = data & 0x01 ? Mirroring::HORIZONTAL : Mirroring::VERTICAL;
+        break;
+        case 0xC000:
+            if (odd)
+            {
+                irq_counter = 0;
+                irq_reload = true;
+            }
+            else
+                irq_latch = data;
+        break;
+        case 0xE000:
+            irq_enabled = odd;
+            if (!odd)
+                irq = false;
+        break;
+    }
+}
+
+void Mapper_004::update_banks ()
+{
+    // prg mode swaps which of $8000 / $C000 is R6 and which is fixed to the second last bank
+    if (bank_select & 0x40)
+    {
+        set_prg_8k (0, -2);
+        set_prg_8k (2, registers[6]);
+    }
+    else
+    {
+        set_prg_8k (0, registers[6]);
+        set_prg_8k (2, -2);
+    }
+    set_prg_8k (1, registers[7]);
+    set_prg_8k (3, -1);
+
+    // chr a12 inversion swaps the 2 KB and 1 KB halves
+    const int big   = bank_select & 0x80 ? 2 : 0;  // in 2 KB windows
+    const int small = bank_select & 0x80 ? 0 : 4;  // in 1 KB windows
+
+    set_chr_2k (big,     registers[0] >> 1);
+    set_chr_2k (big + 1, registers[1] >> 1);
+    for (int i = 0; i < 4; ++i)
+        set_chr_1k (small + i, registers[2 + i]);
+}
+
+void Mapper_004::clock_scanline ()
+{
+    if (irq_counter == 0 || irq_reload)
+    {
+        irq_counter = irq_latch;
+        irq_reload = false;
+    }
+    else
+        --irq_counter;
+
+    if (irq_counter == 0 && irq_enabled)
+        irq = true;
+}
+
+void Mapper_004::clock_scanlines (u64 count)
+{
+    if (count == 0)
+        return;
+
+    // the first clock may reload, after that the counter just cycles latch .. 0
+    clock_scanline ();
+    --count;
+
+    if (count == 0)
+        return;
+
+    // clocks until the counter next reads 0, a full period when it is 0 already
+    const u64 period = irq_latch + 1u;
+    const u64 distance = irq_counter ? irq_counter : period;
+
+    if (count >= distance && irq_enabled)
+        irq = true;
+
+    const u64 left = count < distance ? distance - count : period - (count - distance) % period;
+    irq_counter = left == period ? 0 : static_cast <u8> (left);
+}
+
+int Mapper_004::scanlines_until_irq () const
+{
+    if (!irq_enabled)
+        return -1;
+
+    if (irq_counter == 0 || irq_reload)
+        return irq_latch + 1;
+
+    return irq_counter;
+}
+
+bool Mapper_004::irq_pending () const
+{
+    return irq;
 }
@@ -0,0 +1,248 @@
+#include "nsf.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::size_t header_size = 0x80;
+    constexpr u16 bank_size = 0x1000;
+
+    // cpu cycles per emulated frame, only sets how much audio run_frame produces at a time
+    constexpr u64 frame_cycles = 29781;
+
+    u16 get_u16 (const u8* src)
+    {
+        return static_cast <u16> (src[0] | (src[1] << 8));
+    }
+
+    // header strings are 32 bytes, nul padded but not always nul terminated
+    std::string get_string (const u8* src)
+    {
+        const u8* end = std::find (src, src + 32, 0);
+        return std::string {src, end};
+    }
+}
+
+NSF::File::File (const std::string& _path)
+: path {_path}
+{
+    std::ifstream file {path, std::ios::binary};
+
+    if (!file.is_open())
+        throw std::runtime_error ("nsf: could not open " + path);
+
+    const std::vector <u8> contents {std::istreambuf_iterator <char> {file}, std::istreambuf_iterator <char> {}};
+
+    if (contents.size() <= header_size || std::memcmp (contents.data(), "NESM\x1A", 5) != 0)
+        throw std::runtime_error ("nsf: " + path + " is not an NSF file");
+
+    const u8* header = contents.data();
+
+    version        = header[0x05];
+    track_n        = header[0x06];
+    start_track    = header[0x07] ? header[0x07] - 1 : 0;
+    load_address   = get_u16 (&header[0x08]);
+    init_address   = get_u16 (&header[0x0A]);
+    play_address   = get_u16 (&header[0x0C]);
+    name           = get_string (&header[0x0E]);
+    artist         = get_string (&header[0x2E]);
+    copyright      = get_string (&header[0x4E]);
+    play_period_us = get_u16 (&header[0x6E]);
+    chips          = header[0x7B];
+
+    std::copy_n (&header[0x70], 8, initial_banks.begin());
+    banked = std::any_of (initial_banks.begin(), initial_banks.end(), [] (const u8 bank) { return bank != 0; });
+
+    if (track_n == 0)
+        throw std::runtime_error ("nsf: " + path + " has no tracks");
+
+    if (!banked && load_address < 0x8000)
+        throw std::runtime_error ("nsf: " + path + " loads below $8000");
+
+    data.assign (contents.begin() + header_size, contents.end());
+}
+
+NSF::Player::Player (std::shared_ptr <const File> _file, const double sample_rate)
+: file {std::move (_file)}
+, cpu {*this}
+, apu {sample_rate, [this] (const u16 address) { return read (address); }}
+, cycle {0}
+, play_period {0}
+, play_time {0}
+, idle {true}
+, play_pending {false}
+{
+    if (file->banked)
+    {
+        // banks are counted from the 4 KB boundary below the load address
+        rom.assign (file->load_address & (bank_size - 1), 0);
+        rom.insert (rom.end(), file->data.begin(), file->data.end());
+        rom.resize ((rom.size() + bank_size - 1) / bank_size * bank_size, 0);
+    }
+    else
+    {
+        rom.assign (0x8000, 0);
+        const std::size_t offset = file->load_address - 0x8000;
+        const std::size_t length = std::min (file->data.size(), rom.size() - offset);
+        std::copy_n (file->data.begin(), length, rom.begin() + offset);
+    }
+
+    // 0 isn't a valid period, assume the usual ntsc 60 Hz
+    const double period_us = file->play_period_us ? file->play_period_us : 16639;
+    play_period = static_cast <u64> (period_us * APU::RP2A03::cpu_clock / 1e6 * 256.0);
+
+    start_track (file->start_track);
+}
+
+void NSF::Player::start_track (const int track)
+{
+    ram.fill (0);
+    work_ram.fill (0);
+
+    apu.reset ();
+    cycle = 0;
+
+    for (std::size_t event = 0; event < static_cast <std::size_t> (Scheduler::Event::COUNT); ++event)
+        scheduler.cancel (static_cast <Scheduler::Event> (event));
+
+    for (u16 address = 0x4000; address <= 0x4013; ++address)
+        apu.write (address, 0, cycle);
+    apu.write (0x4015, 0x00, cycle);
+    apu.write (0x4015, 0x0F, cycle);
+    apu.write (0x4017, 0x40, cycle);
+
+    for (int window = 0; window < 8; ++window)
+        set_bank (window, file->banked ? file->initial_banks[window] : static_cast <u8> (window));
+
+    play_time = play_period;
+    scheduler.schedule (Scheduler::Event::NSF_PLAY, play_time >> 8);
+    play_pending = false;
+
+    cpu.set_AC (static_cast <byte> (std::clamp (track, 0, file->track_n - 1)));
+    cpu.set_X (0); // ntsc
+    cpu.set_Y (0);
+    call (file->init_address);
+}
+
+std::size_t NSF::Player::run_frame (std::span <i16> out)
+{
+    scheduler.schedule (Scheduler::Event::FRAME, cycle + frame_cycles);
+
+    for (bool frame_done = false; !frame_done;)
+    {
+        Scheduler::Event event;
+
+        while (scheduler.pop_due (cycle, event))
+        {
+            switch (event)
+            {
+                case Scheduler::Event::FRAME:
+                    frame_done = true;
+                break;
+                case Scheduler::Event::NSF_PLAY:
+                    // a play routine that overruns its period just delays the next call, like on hardware
+                    if (idle)
+                        call (file->play_address);
+                    else
+                        play_pending = true;
+
+                    play_time += play_period;
+                    scheduler.schedule (Scheduler::Event::NSF_PLAY, play_time >> 8);
+                break;
+                default:
+                break;
+            }
+        }
+
+        if (frame_done)
+            break;
+
+        // nothing runs between routines, skip straight to the next event
+        if (idle)
+        {
+            cycle = scheduler.next_cycle ();
+            continue;
+        }
+
+        cpu.update ();
+        cycle += cpu.get_current_cycles ();
+
+        if (cpu.get_PC () == return_address)
+        {
+            idle = true;
+
+            if (play_pending)
+            {
+                play_pending = false;
+                call (file->play_address);
+            }
+        }
+    }
+
+    apu.end_frame (cycle);
+    return apu.get_output ().read_samples (out);
+}
+
+const NSF::File& NSF::Player::get_file () const
+{
+    return *file;
+}
+
+APU::RP2A03& NSF::Player::get_apu ()
+{
+    return apu;
+}
+
+u64 NSF::Player::get_cycles () const
+{
+    return cycle;
+}
+
+u8 NSF::Player::read (const u16 address)
+{
+    if (address < 0x2000)
+        return ram[address & 0x07FF];
+
+    if (address == 0x4015)
+        return apu.read_status (cycle);
+
+    if (address >= 0x6000 && address < 0x8000)
+        return work_ram[address - 0x6000];
+
+    if (address >= 0x8000)
+        return rom[bank_offsets[(address - 0x8000) >> 12] + (address & (bank_size - 1))];
+
+    return 0;
+}
+
+void NSF::Player::write (const u16 address, const u8 data)
+{
+    if (address < 0x2000)
+        ram[address & 0x07FF] = data;
+    else if (address >= 0x4000 && address <= 0x4017 && address != 0x4014 && address != 0x4016)
+        apu.write (address, data, cycle);
+    else if (address >= 0x5FF8 && address <= 0x5FFF && file->banked)
+        set_bank (address - 0x5FF8, data);
+    else if (address >= 0x6000 && address < 0x8000)
+        work_ram[address - 0x6000] = data;
+}
+
+void NSF::Player::set_bank (const int window, const u8 bank)
+{
+    const std::size_t bank_n = rom.size() / bank_size;
+    bank_offsets[window] = static_cast <u32> ((bank % bank_n) * bank_size);
+}
+
+void NSF::Player::call (const u16 address)
+{
+    // fake a jsr from just below return_address, the routine's rts lands on it
+    const u16 pushed = return_address - 1;
+    ram[0x01FD] = pushed >> 8;
+    ram[0x01FC] = pushed & 0xFF;
+    cpu.set_SP (0xFB);
+    cpu.set_PC (address);
+    idle = false;
+}
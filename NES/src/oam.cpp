@@ -0,0 +1,153 @@
+#include "oam.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    /*
+        returns a 64 bit mask of the sprites in range for scanline, bit n = sprite n
+
+        in range means y <= scanline (no borrow) and scanline - y <= height - 1,
+        both done as unsigned byte compares through min / max.
+    */
+
+#if defined(__AVX2__)
+
+    u64 in_range (const u8* y_positions, const u8 scanline, const u8 height)
+    {
+        const __m256i line = _mm256_set1_epi8 (static_cast <char> (scanline));
+        const __m256i last = _mm256_set1_epi8 (static_cast <char> (height - 1));
+        u64 mask = 0;
+
+        for (int i = 0; i < 64; i += 32)
+        {
+            const __m256i y    = _mm256_load_si256 (reinterpret_cast <const __m256i*> (y_positions + i));
+            const __m256i diff = _mm256_sub_epi8 (line, y);
+            const __m256i below_or_on = _mm256_cmpeq_epi8 (_mm256_max_epu8 (line, y), line);
+            const __m256i within      = _mm256_cmpeq_epi8 (_mm256_min_epu8 (diff, last), diff);
+            const u32 bits = static_cast <u32> (_mm256_movemask_epi8 (_mm256_and_si256 (below_or_on, within)));
+            mask |= static_cast <u64> (bits) << i;
+        }
+        return mask;
+    }
+
+#elif defined(__SSE2__)
+
+    u64 in_range (const u8* y_positions, const u8 scanline, const u8 height)
+    {
+        const __m128i line = _mm_set1_epi8 (static_cast <char> (scanline));
+        const __m128i last = _mm_set1_epi8 (static_cast <char> (height - 1));
+        u64 mask = 0;
+
+        for (int i = 0; i < 64; i += 16)
+        {
+            const __m128i y    = _mm_load_si128 (reinterpret_cast <const __m128i*> (y_positions + i));
+            const __m128i diff = _mm_sub_epi8 (line, y);
+            const __m128i below_or_on = _mm_cmpeq_epi8 (_mm_max_epu8 (line, y), line);
+            const __m128i within      = _mm_cmpeq_epi8 (_mm_min_epu8 (diff, last), diff);
+            const u32 bits = static_cast <u32> (_mm_movemask_epi8 (_mm_and_si128 (below_or_on, within)));
+            mask |= static_cast <u64> (bits) << i;
+        }
+        return mask;
+    }
+
+#else
+
+    u64 in_range (const u8* y_positions, const u8 scanline, const u8 height)
+    {
+        u64 mask = 0;
+        for (int i = 0; i < 64; ++i)
+        {
+            const u8 y = y_positions[i];
+            if (y <= scanline && scanline - y < height)
+                mask |= u64 {1} << i;
+        }
+        return mask;
+    }
+
+#endif
+}
+
+PPU::OAM::OAM ()
+: memory {}
+, y_positions {}
+, lines {}
+, sprite_height {8}
+, dirty {true}
+{}
+
+u8 PPU::OAM::read (const u8 address) const
+{
+    return memory[address];
+}
+
+void PPU::OAM::write (const u8 address, const u8 data)
+{
+    memory[address] = data;
+
+    // only the Y byte changes which lines a sprite is on
+    if ((address & 0x03) == 0)
+    {
+        y_positions[address >> 2] = data;
+        dirty = true;
+    }
+}
+
+void PPU::OAM::dma (std::span <const u8, 256> page)
+{
+    std::memcpy (memory.data(), page.data(), memory.size());
+
+    for (int i = 0; i < sprite_n; ++i)
+        y_positions[i] = memory[i * 4];
+
+    dirty = true;
+}
+
+void PPU::OAM::set_sprite_height (const int height)
+{
+    if (height == sprite_height)
+        return;
+
+    sprite_height = height;
+    dirty = true;
+}
+
+const PPU::OAM::Line& PPU::OAM::get_line (const int scanline)
+{
+    if (dirty)
+        evaluate ();
+
+    return lines[scanline];
+}
+
+const PPU::OAM::Sprite& PPU::OAM::get_sprite (const int index) const
+{
+    return reinterpret_cast <const Sprite*> (memory.data())[index];
+}
+
+void PPU::OAM::evaluate ()
+{
+    for (int scanline = 0; scanline < scanline_n; ++scanline)
+    {
+        u64 mask = in_range (y_positions.data(), static_cast <u8> (scanline), static_cast <u8> (sprite_height));
+        Line& line = lines[scanline];
+
+        line.sprite_zero = mask & 1;
+        line.overflow = std::popcount (mask) > sprites_per_line;
+        line.count = 0;
+
+        // lowest index wins, same order the hardware scans oam in
+        while (mask && line.count < sprites_per_line)
+        {
+            line.sprites[line.count++] = static_cast <u8> (std::countr_zero (mask));
+            mask &= mask - 1;
+        }
+    }
+
+    dirty = false;
+}
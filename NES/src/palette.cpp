@@ -0,0 +1,216 @@
+#include "palette.h"
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    struct RGB
+    {
+        u8 r;
+        u8 g;
+        u8 b;
+    };
+
+    // 2C02
+    constexpr std::array <RGB, PPU::Palette::color_n> colors
+    {{
+        {0x54, 0x54, 0x54}, {0x00, 0x1E, 0x74}, {0x08, 0x10, 0x90}, {0x30, 0x00, 0x88}, {0x44, 0x00, 0x64}, {0x5C, 0x00, 0x30}, {0x54, 0x04, 0x00}, {0x3C, 0x18, 0x00}, {0x20, 0x2A, 0x00}, {0x08, 0x3A, 0x00}, {0x00, 0x40, 0x00}, {0x00, 0x3C, 0x00}, {0x00, 0x32, 0x3C}, {0x00, 0x00, 0x00}, {0x00, 0x00, 0x00}, {0x00, 0x00, 0x00},
+        {0x98, 0x96, 0x98}, {0x08, 0x4C, 0xC4}, {0x30, 0x32, 0xEC}, {0x5C, 0x1E, 0xE4}, {0x88, 0x14, 0xB0}, {0xA0, 0x14, 0x64}, {0x98, 0x22, 0x20}, {0x78, 0x3C, 0x00}, {0x54, 0x5A, 0x00}, {0x28, 0x72, 0x00}, {0x08, 0x7C, 0x00}, {0x00, 0x76, 0x28}, {0x00, 0x66, 0x78}, {0x00, 0x00, 0x00}, {0x00, 0x00, 0x00}, {0x00, 0x00, 0x00},
+        {0xEC, 0xEE, 0xEC}, {0x4C, 0x9A, 0xEC}, {0x78, 0x7C, 0xEC}, {0xB0, 0x62, 0xEC}, {0xE4, 0x54, 0xEC}, {0xEC, 0x58, 0xB4}, {0xEC, 0x6A, 0x64}, {0xD4, 0x88, 0x20}, {0xA0, 0xAA, 0x00}, {0x74, 0xC4, 0x00}, {0x4C, 0xD0, 0x20}, {0x38, 0xCC, 0x6C}, {0x38, 0xB4, 0xCC}, {0x3C, 0x3C, 0x3C}, {0x00, 0x00, 0x00}, {0x00, 0x00, 0x00},
+        {0xEC, 0xEE, 0xEC}, {0xA8, 0xCC, 0xEC}, {0xBC, 0xBC, 0xEC}, {0xD4, 0xB2, 0xEC}, {0xEC, 0xAE, 0xEC}, {0xEC, 0xAE, 0xD4}, {0xEC, 0xB4, 0xB0}, {0xE4, 0xC4, 0x90}, {0xCC, 0xD2, 0x78}, {0xB4, 0xDE, 0x78}, {0xA8, 0xE2, 0x90}, {0x98, 0xE2, 0xB4}, {0xA0, 0xD6, 0xE4}, {0xA0, 0xA2, 0xA0}, {0x00, 0x00, 0x00}, {0x00, 0x00, 0x00},
+    }};
+
+    // how much the channels that are not emphasized get dimmed
+    constexpr float attenuation = 0.816328f;
+
+    RGB emphasize (RGB color, const int emphasis)
+    {
+        const auto dim = [] (u8& channel) { channel = static_cast <u8> (channel * attenuation); };
+
+        if (emphasis & 0b110) dim (color.r);
+        if (emphasis & 0b101) dim (color.g);
+        if (emphasis & 0b011) dim (color.b);
+        return color;
+    }
+
+    /*
+        a 64 entry byte table does not fit in one pshufb (16 entries), so each
+        16 entry quarter is looked up with the low nibble and the result for
+        the quarter the high bits select is kept
+    */
+
+#if defined(__AVX2__)
+
+    __m256i lookup (const u8* table, __m256i index)
+    {
+        const __m256i low_nibble  = _mm256_and_si256 (index, _mm256_set1_epi8 (0x0F));
+        const __m256i high_nibble = _mm256_and_si256 (_mm256_srli_epi16 (index, 4), _mm256_set1_epi8 (0x03));
+        __m256i result = _mm256_setzero_si256 ();
+
+        for (int i = 0; i < 4; ++i)
+        {
+            const __m256i quarter = _mm256_broadcastsi128_si256 (_mm_load_si128 (reinterpret_cast <const __m128i*> (table + i * 16)));
+            const __m256i hit = _mm256_cmpeq_epi8 (high_nibble, _mm256_set1_epi8 (static_cast <char> (i)));
+            result = _mm256_or_si256 (result, _mm256_and_si256 (hit, _mm256_shuffle_epi8 (quarter, low_nibble)));
+        }
+        return result;
+    }
+
+    void convert_row_rgba (const u8* src, u32* dst, const int width, const u32* table)
+    {
+        for (int x = 0; x < width; x += 8)
+        {
+            const __m256i index = _mm256_and_si256 (_mm256_cvtepu8_epi32 (_mm_loadl_epi64 (reinterpret_cast <const __m128i*> (src + x))), _mm256_set1_epi32 (0x3F));
+            const __m256i color = _mm256_i32gather_epi32 (reinterpret_cast <const int*> (table), index, 4);
+            _mm256_storeu_si256 (reinterpret_cast <__m256i*> (dst + x), color);
+        }
+    }
+
+    void convert_row_565 (const u8* src, u16* dst, const int width, const u8* lo_table, const u8* hi_table)
+    {
+        for (int x = 0; x < width; x += 32)
+        {
+            const __m256i index = _mm256_and_si256 (_mm256_loadu_si256 (reinterpret_cast <const __m256i*> (src + x)), _mm256_set1_epi8 (0x3F));
+            const __m256i lo = lookup (lo_table, index);
+            const __m256i hi = lookup (hi_table, index);
+
+            // unpack works per 128 bit lane, permute the halves back into pixel order
+            const __m256i first  = _mm256_unpacklo_epi8 (lo, hi);
+            const __m256i second = _mm256_unpackhi_epi8 (lo, hi);
+            _mm256_storeu_si256 (reinterpret_cast <__m256i*> (dst + x),      _mm256_permute2x128_si256 (first, second, 0x20));
+            _mm256_storeu_si256 (reinterpret_cast <__m256i*> (dst + x + 16), _mm256_permute2x128_si256 (first, second, 0x31));
+        }
+    }
+
+    void convert_row_gray (const u8* src, u8* dst, const int width, const u8* table)
+    {
+        for (int x = 0; x < width; x += 32)
+        {
+            const __m256i index = _mm256_and_si256 (_mm256_loadu_si256 (reinterpret_cast <const __m256i*> (src + x)), _mm256_set1_epi8 (0x3F));
+            _mm256_storeu_si256 (reinterpret_cast <__m256i*> (dst + x), lookup (table, index));
+        }
+    }
+
+#elif defined(__SSSE3__)
+
+    __m128i lookup (const u8* table, __m128i index)
+    {
+        const __m128i low_nibble  = _mm_and_si128 (index, _mm_set1_epi8 (0x0F));
+        const __m128i high_nibble = _mm_and_si128 (_mm_srli_epi16 (index, 4), _mm_set1_epi8 (0x03));
+        __m128i result = _mm_setzero_si128 ();
+
+        for (int i = 0; i < 4; ++i)
+        {
+            const __m128i quarter = _mm_load_si128 (reinterpret_cast <const __m128i*> (table + i * 16));
+            const __m128i hit = _mm_cmpeq_epi8 (high_nibble, _mm_set1_epi8 (static_cast <char> (i)));
+            result = _mm_or_si128 (result, _mm_and_si128 (hit, _mm_shuffle_epi8 (quarter, low_nibble)));
+        }
+        return result;
+    }
+
+    // no gather before avx2, a plain table walk is as fast as anything else here
+    void convert_row_rgba (const u8* src, u32* dst, const int width, const u32* table)
+    {
+        for (int x = 0; x < width; ++x)
+            dst[x] = table[src[x] & 0x3F];
+    }
+
+    void convert_row_565 (const u8* src, u16* dst, const int width, const u8* lo_table, const u8* hi_table)
+    {
+        for (int x = 0; x < width; x += 16)
+        {
+            const __m128i index = _mm_and_si128 (_mm_loadu_si128 (reinterpret_cast <const __m128i*> (src + x)), _mm_set1_epi8 (0x3F));
+            const __m128i lo = lookup (lo_table, index);
+            const __m128i hi = lookup (hi_table, index);
+            _mm_storeu_si128 (reinterpret_cast <__m128i*> (dst + x),     _mm_unpacklo_epi8 (lo, hi));
+            _mm_storeu_si128 (reinterpret_cast <__m128i*> (dst + x + 8), _mm_unpackhi_epi8 (lo, hi));
+        }
+    }
+
+    void convert_row_gray (const u8* src, u8* dst, const int width, const u8* table)
+    {
+        for (int x = 0; x < width; x += 16)
+        {
+            const __m128i index = _mm_and_si128 (_mm_loadu_si128 (reinterpret_cast <const __m128i*> (src + x)), _mm_set1_epi8 (0x3F));
+            _mm_storeu_si128 (reinterpret_cast <__m128i*> (dst + x), lookup (table, index));
+        }
+    }
+
+#else
+
+    void convert_row_rgba (const u8* src, u32* dst, const int width, const u32* table)
+    {
+        for (int x = 0; x < width; ++x)
+            dst[x] = table[src[x] & 0x3F];
+    }
+
+    void convert_row_565 (const u8* src, u16* dst, const int width, const u8* lo_table, const u8* hi_table)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const u8 index = src[x] & 0x3F;
+            dst[x] = static_cast <u16> (lo_table[index] | (hi_table[index] << 8));
+        }
+    }
+
+    void convert_row_gray (const u8* src, u8* dst, const int width, const u8* table)
+    {
+        for (int x = 0; x < width; ++x)
+            dst[x] = table[src[x] & 0x3F];
+    }
+
+#endif
+}
+
+PPU::Palette::Palette ()
+{
+    for (int emphasis = 0; emphasis < emphasis_n; ++emphasis)
+    {
+        for (int index = 0; index < color_n; ++index)
+        {
+            const RGB color = emphasize (colors[index], emphasis);
+
+            // R, G, B, A in memory order
+            const u8 bytes[4] {color.r, color.g, color.b, 0xFF};
+            std::memcpy (&rgba[emphasis][index], bytes, sizeof(bytes));
+
+            const u16 rgb565 = static_cast <u16> (((color.r >> 3) << 11) | ((color.g >> 2) << 5) | (color.b >> 3));
+            rgb565_lo[emphasis][index] = rgb565 & 0xFF;
+            rgb565_hi[emphasis][index] = rgb565 >> 8;
+
+            // BT.601 luma
+            gray[emphasis][index] = static_cast <u8> ((77 * color.r + 150 * color.g + 29 * color.b) >> 8);
+        }
+    }
+}
+
+u32 PPU::Palette::get_color (const u8 index, const u8 emphasis) const
+{
+    return rgba[emphasis & 0x07][index & 0x3F];
+}
+
+void PPU::Palette::convert (const Frame& frame, const Pixel_Format format, void* dst, const std::size_t pitch) const
+{
+    u8* out = static_cast <u8*> (dst);
+
+    for (int y = 0; y < screen_height; ++y, out += pitch)
+    {
+        const u8  emphasis = frame.emphasis[y] & 0x07;
+        const u8* row = frame.get_row (y);
+
+        switch (format)
+        {
+            case Pixel_Format::RGBA8888: convert_row_rgba (row, reinterpret_cast <u32*> (out), screen_width, rgba[emphasis].data()); break;
+            case Pixel_Format::RGB565:   convert_row_565  (row, reinterpret_cast <u16*> (out), screen_width, rgb565_lo[emphasis].data(), rgb565_hi[emphasis].data()); break;
+            case Pixel_Format::GRAY8:    convert_row_gray (row, out, screen_width, gray[emphasis].data()); break;
+        }
+    }
+}
+
+void PPU::Palette::convert_row (const u8* src, u32* dst, const int width, const u8 emphasis) const
+{
+    convert_row_rgba (src, dst, width, rgba[emphasis & 0x07].data());
+}
@@ -0,0 +1,125 @@
+#include "render_thread.h"
+#include <algorithm>
+
+PPU::Render_Thread::Render_Thread (replay_cb _replay, const int _max_frames_behind)
+: replay {_replay}
+, max_frames_behind {std::max (_max_frames_behind, 1)}
+, synchronous {false}
+, ring {std::make_unique <SPSC_Ring <Log_Entry, log_size>> ()}
+, frames_logged {0}
+, frames_rendered {0}
+, entries_logged {0}
+, entries_replayed {0}
+, running {true}
+, worker {&Render_Thread::work, this}
+{}
+
+PPU::Render_Thread::~Render_Thread ()
+{
+    running = false;
+
+    // bump the counter the worker sleeps on so it wakes up and sees running
+    entries_logged.fetch_add (1, std::memory_order_release);
+    entries_logged.notify_one ();
+    worker.join ();
+}
+
+void PPU::Render_Thread::log (const Log_Entry& entry)
+{
+    if (synchronous)
+    {
+        replay (entry);
+        return;
+    }
+    push (entry);
+}
+
+void PPU::Render_Thread::end_frame (const u64 cycle)
+{
+    log ({cycle, 0, 0, Log_Entry::Target::FRAME_END});
+
+    if (synchronous)
+    {
+        frames_logged.fetch_add (1, std::memory_order_relaxed);
+        frames_rendered.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    const u64 logged = frames_logged.fetch_add (1, std::memory_order_relaxed) + 1;
+
+    // the worker only gets woken up once per frame, not for every write
+    entries_logged.notify_one ();
+
+    for (u64 rendered = frames_rendered.load (std::memory_order_acquire); logged - rendered > static_cast <u64> (max_frames_behind); rendered = frames_rendered.load (std::memory_order_acquire))
+        frames_rendered.wait (rendered, std::memory_order_acquire);
+}
+
+void PPU::Render_Thread::sync ()
+{
+    if (synchronous)
+        return;
+
+    entries_logged.notify_one ();
+
+    const u64 target = entries_logged.load (std::memory_order_relaxed);
+    for (u64 replayed = entries_replayed.load (std::memory_order_acquire); replayed != target; replayed = entries_replayed.load (std::memory_order_acquire))
+        entries_replayed.wait (replayed, std::memory_order_acquire);
+}
+
+void PPU::Render_Thread::set_synchronous (const bool enabled)
+{
+    // the worker must be idle before the cpu thread starts replaying itself
+    if (enabled)
+        sync ();
+
+    synchronous = enabled;
+}
+
+bool PPU::Render_Thread::is_synchronous () const
+{
+    return synchronous;
+}
+
+u64 PPU::Render_Thread::get_frames_rendered () const
+{
+    return frames_rendered.load (std::memory_order_acquire);
+}
+
+void PPU::Render_Thread::push (const Log_Entry& entry)
+{
+    while (!ring->push (entry))
+    {
+        // full, the render thread is behind inside a frame. wake it and give it the core
+        entries_logged.notify_one ();
+        std::this_thread::yield ();
+    }
+    entries_logged.fetch_add (1, std::memory_order_release);
+}
+
+void PPU::Render_Thread::work ()
+{
+    Log_Entry entry;
+
+    while (running.load (std::memory_order_acquire))
+    {
+        if (ring->pop (entry))
+        {
+            replay (entry);
+            entries_replayed.fetch_add (1, std::memory_order_release);
+
+            if (entry.target == Log_Entry::Target::FRAME_END)
+            {
+                frames_rendered.fetch_add (1, std::memory_order_release);
+                frames_rendered.notify_one ();
+            }
+            continue;
+        }
+
+        // drained, let sync () know and sleep until the cpu thread logs more
+        entries_replayed.notify_all ();
+
+        const u64 logged = entries_logged.load (std::memory_order_acquire);
+        if (logged == entries_replayed.load (std::memory_order_acquire))
+            entries_logged.wait (logged, std::memory_order_acquire);
+    }
+}
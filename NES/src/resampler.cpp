@@ -0,0 +1,227 @@
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <numbers>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // room for a few frames at 96 kHz before process () has to grow the buffer
+    constexpr std::size_t reserved_block = 8192;
+
+    // kaiser window, beta 8 puts the stop band around -80 dB for 32 taps
+    constexpr double beta = 8.0;
+
+    // how far below nyquist the pass band ends
+    constexpr double rolloff = 0.92;
+
+    // how far the cut off can wander before the kernels are rebuilt, well inside the 8% rolloff
+    constexpr double max_cutoff_drift = 0.01;
+
+    double bessel_i0 (const double x)
+    {
+        double sum  = 1.0;
+        double term = 1.0;
+
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+    float dot (const float* kernel, const float* samples)
+    {
+        __m256 acc_0 = _mm256_setzero_ps ();
+        __m256 acc_1 = _mm256_setzero_ps ();
+
+        for (int i = 0; i < APU::Resampler::taps; i += 16)
+        {
+            acc_0 = _mm256_fmadd_ps (_mm256_loadu_ps (kernel + i),     _mm256_loadu_ps (samples + i),     acc_0);
+            acc_1 = _mm256_fmadd_ps (_mm256_loadu_ps (kernel + i + 8), _mm256_loadu_ps (samples + i + 8), acc_1);
+        }
+
+        const __m256 acc = _mm256_add_ps (acc_0, acc_1);
+        __m128 sum = _mm_add_ps (_mm256_castps256_ps128 (acc), _mm256_extractf128_ps (acc, 1));
+        sum = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+        sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+        return _mm_cvtss_f32 (sum);
+    }
+
+#elif defined(__SSE2__)
+
+    float dot (const float* kernel, const float* samples)
+    {
+        __m128 acc_0 = _mm_setzero_ps ();
+        __m128 acc_1 = _mm_setzero_ps ();
+
+        for (int i = 0; i < APU::Resampler::taps; i += 8)
+        {
+            acc_0 = _mm_add_ps (acc_0, _mm_mul_ps (_mm_loadu_ps (kernel + i),     _mm_loadu_ps (samples + i)));
+            acc_1 = _mm_add_ps (acc_1, _mm_mul_ps (_mm_loadu_ps (kernel + i + 4), _mm_loadu_ps (samples + i + 4)));
+        }
+
+        __m128 sum = _mm_add_ps (acc_0, acc_1);
+        sum = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+        sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+        return _mm_cvtss_f32 (sum);
+    }
+
+#else
+
+    float dot (const float* kernel, const float* samples)
+    {
+        float sum = 0.f;
+        for (int i = 0; i < APU::Resampler::taps; ++i)
+            sum += kernel[i] * samples[i];
+        return sum;
+    }
+
+#endif
+}
+
+APU::Resampler::Resampler (const int _input_rate, const int _output_rate)
+: input_rate {0}
+, output_rate {0}
+, up {1}
+, down {1}
+, phase_n {0}
+, cutoff {0.0}
+, history {0}
+, skip {0}
+, phase {0}
+{
+    buffer.reserve (taps + reserved_block);
+    set_rates (_input_rate, _output_rate);
+}
+
+void APU::Resampler::set_rates (const int _input_rate, const int _output_rate)
+{
+    if (_input_rate == input_rate && _output_rate == output_rate)
+        return;
+
+    input_rate = _input_rate;
+    output_rate = _output_rate;
+
+    const int divisor = std::gcd (input_rate, output_rate);
+    const u32 new_up = static_cast <u32> (output_rate / divisor);
+
+    // keep the position between samples when the ratio changes on the fly
+    phase = static_cast <u32> (static_cast <u64> (phase) * new_up / up);
+    up = new_up;
+    down = static_cast <u32> (input_rate / divisor);
+
+    // cycles per input sample, downsampling has to cut below the output's nyquist too
+    const double new_cutoff = 0.5 * std::min (1.0, static_cast <double> (up) / down) * rolloff;
+    const u32 new_phase_n = std::min <u32> (up, max_phases);
+
+    // rate control moves the ratio a little every few frames, the kernels that are
+    // there do as long as they have enough phases and the cut off stays close
+    if (new_phase_n > phase_n || std::abs (new_cutoff / cutoff - 1.0) > max_cutoff_drift)
+    {
+        cutoff = new_cutoff;
+        phase_n = new_phase_n;
+        build_kernels ();
+    }
+}
+
+void APU::Resampler::build_kernels ()
+{
+    static constexpr double half = taps / 2.0;
+
+    const double window_scale = 1.0 / bessel_i0 (beta);
+
+    kernels.assign (static_cast <std::size_t> (phase_n) * taps, 0.f);
+
+    for (u32 p = 0; p < phase_n; ++p)
+    {
+        const double frac = static_cast <double> (p) / phase_n;
+        float* kernel = &kernels[static_cast <std::size_t> (p) * taps];
+        double sum = 0.0;
+
+        for (int k = 0; k < taps; ++k)
+        {
+            const double x = k - (half - 1.0) - frac;
+            const double r = x / half;
+            const double window = std::abs (r) < 1.0 ? bessel_i0 (beta * std::sqrt (1.0 - r * r)) * window_scale : 0.0;
+            const double sinc = x == 0.0 ? 1.0 : std::sin (2.0 * std::numbers::pi * cutoff * x) / (std::numbers::pi * x) / (2.0 * cutoff);
+
+            kernel[k] = static_cast <float> (sinc * window);
+            sum += kernel[k];
+        }
+
+        // unity gain at dc for every phase, otherwise the phases beat against each other
+        for (int k = 0; k < taps; ++k)
+            kernel[k] = static_cast <float> (kernel[k] / sum);
+    }
+}
+
+std::size_t APU::Resampler::max_output (const std::size_t n) const
+{
+    return (history + n) * up / down + 2;
+}
+
+std::size_t APU::Resampler::process (std::span <const i16> in, std::span <i16> out)
+{
+    if (is_passthrough ())
+    {
+        const std::size_t n = std::min (in.size(), out.size());
+        std::copy_n (in.begin(), n, out.begin());
+        return n;
+    }
+
+    buffer.resize (history + in.size());
+    std::transform (in.begin(), in.end(), buffer.begin() + history, [] (const i16 s) { return static_cast <float> (s); });
+
+    const std::size_t size = buffer.size();
+    std::size_t index = skip;
+    std::size_t n = 0;
+
+    while (index + taps <= size && n < out.size())
+    {
+        const u32 kernel_index = phase_n == up ? phase : static_cast <u32> (static_cast <u64> (phase) * phase_n / up);
+        const float sample = dot (&kernels[static_cast <std::size_t> (kernel_index) * taps], &buffer[index]);
+        out[n++] = static_cast <i16> (std::clamp (std::lround (sample), -32768l, 32767l));
+
+        phase += down;
+        index += phase / up;
+        phase %= up;
+    }
+
+    // keep what the next block still needs, or remember how far the last step overshot
+    if (index >= size)
+    {
+        skip = index - size;
+        history = 0;
+    }
+    else
+    {
+        skip = 0;
+        history = size - index;
+        std::memmove (buffer.data(), buffer.data() + index, history * sizeof(float));
+    }
+    buffer.resize (history);
+
+    return n;
+}
+
+void APU::Resampler::reset ()
+{
+    buffer.clear ();
+    history = 0;
+    skip = 0;
+    phase = 0;
+}
+
+bool APU::Resampler::is_passthrough () const
+{
+    return input_rate == output_rate;
+}
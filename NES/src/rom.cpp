@@ -1,6 +1,10 @@
 #include "rom.h"
+#include "rom_stream.h"
+#include "hash.h"
+#include <algorithm>
 #include <cstring>
-#include <fstream>
+#include <filesystem>
+#include <string>
 #include <iostream>
 #include <stdexcept>
 #include "mapper.h"
@@ -61,9 +65,6 @@ FLAGS 10
 
 */
 
-#define VERTICAL   = 0
-#define HORIZONTAL = 1
-
 namespace
 {
     #pragma pack (push, 1)
@@ -82,53 +83,139 @@ namespace
     #pragma pack (pop)
 }
 
-NES_ROM::NES_ROM(const char* file_name)
-: prg_memory {}
-, chr_memory {}
+NES_ROM::Contents NES_ROM::load (const std::string& file_name, const std::string& patch_name)
 {
-    NES_ROM_Header header {};
+    Contents contents {};
+    contents.image = ROM_Image::open(file_name);
 
-    std::ifstream file (file_name);
+    const std::span<const u8> file = contents.image->data();
 
-    if (!file.is_open())
+    if (patch_name.empty() && ROM_Stream::is_ines(file))
     {
-        std::cerr << "File could not be opened" << std::endl;
-        std::exit(EXIT_FAILURE);
+        // plain rom, prg and chr stay in the mapping
+        NES_ROM_Header header {};
+        std::memcpy(&header, file.data(), sizeof(header));
+        std::memcpy(contents.header.data(), file.data(), sizeof(header));
+
+        std::size_t offset = sizeof(header);
+
+        // 512 bytes the program expects at $7000, it sits before PRG
+        if(header.flags_6 & 0x04)
+        {
+            if (file.size() < offset + 512)
+                throw std::runtime_error(file_name + " is truncated");
+
+            contents.trainer.assign(file.begin() + offset, file.begin() + offset + 512);
+            offset += 512;
+        }
+
+        const std::size_t prg_size = header.prg_size * 16384;
+        const std::size_t chr_size = header.chr_size * 8192;
+
+        if (file.size() < offset + prg_size + chr_size)
+            throw std::runtime_error(file_name + " is truncated");
+
+        contents.prg = file.subspan(offset, prg_size);
+        contents.chr = file.subspan(offset + prg_size, chr_size);
     }
+    else
+    {
+        // compressed and / or patched, decoded straight into the owned buffers
+        const auto patch = patch_name.empty() ? nullptr : ROM_Image::open(patch_name);
+        auto decoded = ROM_Stream::decode(file, file_name, patch ? patch->data() : std::span<const u8> {});
+
+        contents.header    = decoded.header;
+        contents.trainer   = std::move(decoded.trainer);
+        contents.prg_owned = std::move(decoded.prg);
+        contents.chr_owned = std::move(decoded.chr);
+
+        // moving the vectors kept their buffers
+        contents.prg = contents.prg_owned;
+        contents.chr = contents.chr_owned;
+
+        // nothing points into the file
+        contents.image.reset();
+    }
+
+    // the cpu has nothing to start from, every bank number would also be taken modulo 0
+    if (contents.prg.empty())
+        throw std::runtime_error(file_name + " has no prg");
+
+    return contents;
+}
+
+std::vector<u32> NES_ROM::chunk_crcs (std::span<const u8> memory)
+{
+    std::vector<u32> crcs;
+    crcs.reserve(memory.size() / Reload::chunk);
+
+    for (std::size_t offset = 0; offset < memory.size(); offset += Reload::chunk)
+        crcs.push_back(Hash::crc32(memory.subspan(offset, std::min(Reload::chunk, memory.size() - offset))));
+
+    return crcs;
+}
+
+NES_ROM::NES_ROM(const char* file_name, const char* patch_name)
+: path {file_name}
+, patch_path {patch_name ? patch_name : ""}
+, prg_memory {}
+, chr_memory {}
+{
+    Contents contents = load(path, patch_path);
+
+    NES_ROM_Header header {};
+    std::memcpy(&header, contents.header.data(), sizeof(header));
+    header_bytes = contents.header;
 
-    file.read(reinterpret_cast<char*> (&header), sizeof(header));
+    image      = std::move(contents.image);
+    trainer    = std::move(contents.trainer);
+    prg_owned  = std::move(contents.prg_owned);
+    chr_owned  = std::move(contents.chr_owned);
+    prg_memory = contents.prg;
+    chr_memory = contents.chr;
 
     prg_bank_n = header.prg_size;
     chr_bank_n = header.chr_size;
 
     mapper_id =  (header.flags_7  & 0xF0) | (header.flags_6 >> 4);
-    mirror = static_cast<int> (header.flags_6 & 0x01);
 
+    Mapper::Mirroring mirroring = header.flags_6 & 0x01 ? Mapper::Mirroring::VERTICAL : Mapper::Mirroring::HORIZONTAL;
+    if (header.flags_6 & 0x08)
+        mirroring = Mapper::Mirroring::FOUR_SCREEN;
 
-    prg_memory.resize(prg_bank_n * 16384);
-    chr_memory.resize((chr_bank_n == 0 ? 1 : chr_bank_n) * 8192);
+    if (chr_bank_n == 0)
+    {
+        // chr ram, the one part that has to be private to the instance
+        chr_owned.resize(8192);
+        chr_memory = chr_owned;
+    }
 
-    // checking if there is a trainer (idk what that is)
-    if(header.flags_6 & 0x04)
-        file.seekg(512, std::ios::cur);
+    // what reload () compares against, chr ram is the game's and never reloaded
+    prg_crcs = chunk_crcs(prg_memory);
+    if (chr_bank_n)
+        chr_crcs = chunk_crcs(chr_memory);
 
-    // if(((header.flags_7 >> 2) & 0x3) == 2)
-    // {}
+    chr_cache = PPU::CHR_Cache {chr_memory};
 
+    const std::span<u8> chr_ram = chr_bank_n == 0 ? std::span<u8> {chr_owned} : std::span<u8> {};
 
-    file.read(reinterpret_cast<char*>(prg_memory.data()), prg_memory.size());
-    file.read(reinterpret_cast<char*>(chr_memory.data()), chr_memory.size());
+    mapper = Mapper::create(mapper_id, prg_memory, chr_memory, chr_ram, mirroring);
 
-    switch (mapper_id)
+    battery = header.flags_6 & 0x02;
+    if (battery)
     {
-        case 0: mapper = std::make_shared<Mapper_000> (prg_bank_n, chr_bank_n);
-        break;
-        default: throw std::runtime_error("NO MAPPER");
-        break;
+        try
+        {
+            save = std::make_unique<Save_RAM>(std::filesystem::path {file_name}.replace_extension(".sav").string());
+            mapper->set_prg_ram(save->data());
+        }
+        catch (const std::exception& e)
+        {
+            // still playable, the save just won't outlive the session
+            std::clog << e.what() << '\n';
+        }
     }
 
-    file.close();
-
 #ifdef DEBUG_ROM
     std::cout 
     << file_name << '\n'
@@ -144,20 +231,176 @@ NES_ROM::NES_ROM(const char* file_name)
 
 bool NES_ROM::cpu_read (u16 address, u8& data)
 {
-    (void) address;
-    (void) data;
-    std::uint32_t mapped_address {};
-    // std::vector<u8> prg_memory;
-    return mapper->cpu_read(address, mapped_address, data);
-    // return false;
+    if (address >= 0x8000)
+    {
+        data = mapper->cpu_read(address);
+        return true;
+    }
+
+    if (address >= 0x6000)
+        return mapper->prg_ram_read(address, data);
+
+    return false;
+}
+
+bool NES_ROM::cpu_write (u16 address, u8 data)
+{
+    if (address >= 0x6000 && address < 0x8000)
+        return mapper->prg_ram_write(address, data);
+
+    if (address < 0x4020)
+        return false;
+
+    mapper->cpu_write(address, data);
+    return true;
+}
+
+bool NES_ROM::ppu_read (u16 address, u8& data)
+{
+    if (address >= 0x2000)
+        return false;
+
+    data = mapper->ppu_read(address);
+    return true;
+}
+
+bool NES_ROM::ppu_write (u16 address, u8 data)
+{
+    u32 offset {};
+    if (address >= 0x2000 || !mapper->ppu_write(address, data, offset))
+        return false;
+
+    chr_cache.invalidate(offset);
+    return true;
 }
 
 /* GETTERS */
 u8 NES_ROM::get_prg_bank_n () const {return prg_bank_n;}
 u8 NES_ROM::get_chr_bank_n () const {return chr_bank_n;}
+u8 NES_ROM::get_mapper_id () const {return mapper_id;}
+bool NES_ROM::has_battery () const {return battery;}
+
+std::span<const u8> NES_ROM::get_prg_memory () const {return prg_memory;}
+std::span<const u8> NES_ROM::get_chr_memory () const {return chr_memory;}
+std::span<const u8> NES_ROM::get_trainer () const {return trainer;}
+
+std::span<u8> NES_ROM::get_writable_prg ()
+{
+    if (prg_owned.empty() && !prg_memory.empty())
+    {
+        prg_owned.assign(prg_memory.begin(), prg_memory.end());
+        prg_memory = prg_owned;
+        mapper->set_memory(prg_memory, chr_memory, chr_bank_n == 0 ? std::span<u8> {chr_owned} : std::span<u8> {});
+    }
+
+    return prg_owned;
+}
+
+std::span<u8> NES_ROM::get_writable_chr ()
+{
+    if (chr_owned.empty() && !chr_memory.empty())
+    {
+        chr_owned.assign(chr_memory.begin(), chr_memory.end());
+        chr_memory = chr_owned;
+
+        // the cache and the mapper still point at the mapping. it stays rom as far as the ppu is concerned
+        chr_cache = PPU::CHR_Cache {chr_memory};
+        mapper->set_memory(prg_memory, chr_memory, {});
+    }
+
+    return chr_owned;
+}
+
+NES_ROM::Reload NES_ROM::reload ()
+{
+    Contents contents = load(path, patch_path);
+
+    Reload changes {};
+
+    // new sizes or a new board, nothing that holds on to this rom would survive that
+    if (contents.header != header_bytes)
+    {
+        changes.header_changed = true;
+        return changes;
+    }
+
+    const auto compare = [] (std::vector<u32>& crcs, const std::vector<u32>& fresh, std::vector<bool>& changed)
+    {
+        changed.resize(fresh.size());
+        for (std::size_t i = 0; i < fresh.size(); ++i)
+            changed[i] = crcs[i] != fresh[i];
+
+        crcs = fresh;
+    };
+
+    // writable copies are updated in place, every span handed out of get_writable_* stays valid
+    const auto update = [] (std::vector<u8>& owned, std::span<const u8> fresh, const std::vector<bool>& changed)
+    {
+        for (std::size_t i = 0; i < changed.size(); ++i)
+            if (changed[i])
+            {
+                const std::size_t offset = i * Reload::chunk;
+                const std::size_t count  = std::min(Reload::chunk, fresh.size() - offset);
+                std::memcpy(owned.data() + offset, fresh.data() + offset, count);
+            }
+    };
+
+    compare(prg_crcs, chunk_crcs(contents.prg), changes.prg);
+
+    if (!prg_owned.empty())
+        update(prg_owned, contents.prg, changes.prg);
+    else
+    {
+        prg_owned  = std::move(contents.prg_owned);
+        prg_memory = contents.prg;
+    }
+
+    if (chr_bank_n)
+    {
+        compare(chr_crcs, chunk_crcs(contents.chr), changes.chr);
+
+        if (!chr_owned.empty())
+            update(chr_owned, contents.chr, changes.chr);
+        else
+        {
+            chr_owned  = std::move(contents.chr_owned);
+            chr_memory = contents.chr;
+            chr_cache.set_chr(chr_memory);
+        }
+
+        // tiles are keyed by offset, only the ones in changed chunks decode again
+        for (std::size_t i = 0; i < changes.chr.size(); ++i)
+            if (changes.chr[i])
+                chr_cache.invalidate(i * Reload::chunk, (i + 1) * Reload::chunk);
+    }
+
+    // same banking, new pointers, cheat overlays copied again from the new bytes
+    mapper->set_memory(prg_memory, chr_memory, chr_bank_n == 0 ? std::span<u8> {chr_owned} : std::span<u8> {});
+
+    // the old mapping goes once nothing points into it
+    image   = std::move(contents.image);
+    trainer = std::move(contents.trainer);
+
+    return changes;
+}
+
+bool NES_ROM::Reload::any () const
+{
+    return header_changed
+        || std::find(prg.begin(), prg.end(), true) != prg.end()
+        || std::find(chr.begin(), chr.end(), true) != chr.end();
+}
+
+const std::string& NES_ROM::get_path () const {return path;}
+
+void NES_ROM::flush_save ()
+{
+    if (mapper->take_prg_ram_dirty() && save)
+        save->flush();
+}
 
-std::vector<u8>& NES_ROM::get_prg_memory () {return prg_memory;}
-std::vector<u8>& NES_ROM::get_chr_memory () {return chr_memory;}
+PPU::CHR_Cache& NES_ROM::get_chr_cache () {return chr_cache;}
+Mapper& NES_ROM::get_mapper () {return *mapper;}
 
 
 
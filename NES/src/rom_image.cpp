@@ -0,0 +1,104 @@
+#include "rom_image.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace
+{
+    // (device, inode) of every file currently mapped
+    std::mutex registry_mutex;
+    std::map <std::pair <u64, u64>, std::weak_ptr <const ROM_Image>> registry;
+}
+
+std::shared_ptr <const ROM_Image> ROM_Image::open (const std::string& path)
+{
+    const int fd = ::open (path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error ("rom: could not open " + path + ": " + std::strerror (errno));
+
+    struct stat info {};
+    if (fstat (fd, &info) != 0)
+    {
+        const int error = errno;
+        ::close (fd);
+        throw std::runtime_error ("rom: could not stat " + path + ": " + std::strerror (error));
+    }
+
+    const std::lock_guard lock {registry_mutex};
+
+    const u64 device = static_cast <u64> (info.st_dev);
+    const u64 inode  = static_cast <u64> (info.st_ino);
+
+    const u64 modified = static_cast <u64> (info.st_mtim.tv_sec) * 1000000000 + static_cast <u64> (info.st_mtim.tv_nsec);
+    const std::size_t size = static_cast <std::size_t> (info.st_size);
+
+    // a file rewritten in place keeps its inode, the old mapping would have the old size
+    auto& entry = registry[{device, inode}];
+    if (auto shared = entry.lock (); shared && shared->size == size && shared->modified == modified)
+    {
+        ::close (fd);
+        return shared;
+    }
+
+    // the constructor is private, so no make_shared
+    std::shared_ptr <const ROM_Image> image {new ROM_Image {path, fd, size, device, inode, modified}};
+    entry = image;
+    return image;
+}
+
+ROM_Image::ROM_Image (const std::string& _path, const int fd, const std::size_t _size, const u64 _device, const u64 _inode, const u64 _modified)
+: path {_path}
+, device {_device}
+, inode {_inode}
+, modified {_modified}
+, mapping {nullptr}
+, size {_size}
+{
+    // mmap refuses a length of 0, an empty file just has no data
+    if (size)
+    {
+        void* address = ::mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        const int error = errno;
+
+        if (address == MAP_FAILED)
+        {
+            ::close (fd);
+            throw std::runtime_error ("rom: could not map " + path + ": " + std::strerror (error));
+        }
+
+        mapping = static_cast <const u8*> (address);
+    }
+
+    // the mapping stays valid without the descriptor
+    ::close (fd);
+}
+
+ROM_Image::~ROM_Image ()
+{
+    if (mapping)
+        ::munmap (const_cast <u8*> (mapping), size);
+
+    // drop the expired entry, unless the file was opened again in the meantime
+    const std::lock_guard lock {registry_mutex};
+
+    const auto it = registry.find ({device, inode});
+    if (it != registry.end() && it->second.expired ())
+        registry.erase (it);
+}
+
+std::span <const u8> ROM_Image::data () const
+{
+    return {mapping, size};
+}
+
+const std::string& ROM_Image::get_path () const
+{
+    return path;
+}
@@ -0,0 +1,396 @@
+#include "rom_library.h"
+#include "rom_image.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace
+{
+    constexpr char index_magic[8] {'N', 'E', 'S', 'L', 'I', 'B', 0, 0};
+    constexpr u32 index_version = 1;
+
+    struct Index_Header
+    {
+        char magic[8];
+        u32  version;
+        u32  count;
+        u64  strings_size;
+    };
+
+    struct Record
+    {
+        u64 path_offset;
+        u32 path_length;
+        u8  format;
+        u8  submapper;
+        u16 mapper;
+        i64 mtime;
+        u64 size;
+        u32 prg_size;
+        u32 chr_size;
+        u32 crc32;
+        u8  battery;
+        u8  trainer;
+        u8  mirroring;
+        u8  unused;
+        u8  sha1[20];
+        u32 padding;
+    };
+
+    static_assert (sizeof(Index_Header) == 24);
+    static_assert (sizeof(Record) == 72);
+
+    bool is_rom (const std::filesystem::path& path)
+    {
+        std::string extension = path.extension().string();
+        std::transform (extension.begin(), extension.end(), extension.begin(), [] (const unsigned char c) { return static_cast <char> (std::tolower (c)); });
+        return extension == ".nes";
+    }
+}
+
+ROM_Library::ROM_Library (const std::string& _index_path)
+: index_path {_index_path}
+{
+    load ();
+    rebuild_lookup ();
+}
+
+void ROM_Library::load ()
+{
+    const int fd = ::open (index_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    struct stat info {};
+    const bool stat_ok = fstat (fd, &info) == 0;
+    const std::size_t size = stat_ok ? static_cast <std::size_t> (info.st_size) : 0;
+
+    if (size < sizeof(Index_Header))
+    {
+        ::close (fd);
+        return;
+    }
+
+    void* mapping = ::mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close (fd);
+
+    if (mapping == MAP_FAILED)
+        return;
+
+    const u8* data = static_cast <const u8*> (mapping);
+
+    Index_Header header;
+    std::memcpy (&header, data, sizeof(header));
+
+    const u64 records_size = u64 {header.count} * sizeof(Record);
+
+    const bool valid = std::memcmp (header.magic, index_magic, sizeof(index_magic)) == 0
+                    && header.version == index_version
+                    && sizeof(Index_Header) + records_size + header.strings_size == size;
+
+    if (valid)
+    {
+        const u8* records = data + sizeof(Index_Header);
+        const char* strings = reinterpret_cast <const char*> (records + records_size);
+
+        entries.resize (header.count);
+
+        for (std::size_t i = 0; i < header.count; ++i)
+        {
+            Record record;
+            std::memcpy (&record, records + i * sizeof(Record), sizeof(Record));
+
+            if (record.path_offset + record.path_length > header.strings_size)
+            {
+                entries.clear ();
+                break;
+            }
+
+            Entry& entry = entries[i];
+            entry.path.assign (strings + record.path_offset, record.path_length);
+            entry.mtime     = record.mtime;
+            entry.size      = record.size;
+            entry.format    = static_cast <Format> (record.format);
+            entry.mapper    = record.mapper;
+            entry.submapper = record.submapper;
+            entry.battery   = record.battery;
+            entry.trainer   = record.trainer;
+            entry.mirroring = record.mirroring;
+            entry.prg_size  = record.prg_size;
+            entry.chr_size  = record.chr_size;
+            entry.crc32     = record.crc32;
+            std::memcpy (entry.sha1.data(), record.sha1, entry.sha1.size());
+        }
+    }
+
+    ::munmap (mapping, size);
+}
+
+ROM_Library::Scan_Stats ROM_Library::scan (std::span <const std::string> directories, unsigned threads)
+{
+    Scan_Stats stats {};
+
+    std::vector <Entry> found;
+    std::vector <std::size_t> changed;
+    std::unordered_set <std::string> seen; // overlapping directories
+
+    for (const auto& directory : directories)
+    {
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator {directory, std::filesystem::directory_options::skip_permission_denied, error};
+             !error && it != std::filesystem::recursive_directory_iterator {};
+             it.increment (error))
+        {
+            // an error here is about this entry only, it must not end the walk
+            if (!it->is_regular_file (error) || !is_rom (it->path()))
+            {
+                error.clear ();
+                continue;
+            }
+
+            Entry entry {};
+            entry.path  = it->path().generic_string();
+
+            if (!seen.insert (entry.path).second)
+                continue;
+
+            entry.size  = it->file_size (error);
+            entry.mtime = static_cast <i64> (it->last_write_time (error).time_since_epoch().count());
+
+            if (error)
+            {
+                ++stats.failed;
+                error.clear ();
+                continue;
+            }
+
+            const auto cached = by_path.find (entry.path);
+            if (cached != by_path.end() && entries[cached->second].size == entry.size && entries[cached->second].mtime == entry.mtime)
+            {
+                found.push_back (entries[cached->second]);
+                ++stats.reused;
+            }
+            else
+            {
+                changed.push_back (found.size());
+                found.push_back (std::move (entry));
+            }
+        }
+    }
+
+    stats.files  = found.size();
+    stats.hashed = changed.size();
+
+    if (threads == 0)
+        threads = std::max (1u, std::thread::hardware_concurrency ());
+    threads = static_cast <unsigned> (std::min <std::size_t> (threads, changed.size()));
+
+    std::atomic <std::size_t> next {0};
+    std::atomic <std::size_t> failed {0};
+    std::atomic <u64> bytes {0};
+
+    {
+        std::vector <std::jthread> workers;
+
+        for (unsigned i = 0; i < threads; ++i)
+        {
+            workers.emplace_back ([&]
+            {
+                for (std::size_t index = next++; index < changed.size(); index = next++)
+                {
+                    Entry& entry = found[changed[index]];
+
+                    if (identify (entry))
+                        bytes += u64 {entry.prg_size} + entry.chr_size;
+                    else
+                        ++failed;
+                }
+            });
+        }
+    }
+
+    stats.failed += failed;
+    stats.bytes_hashed = bytes;
+
+    // files that disappeared drop out of the index here
+    entries = std::move (found);
+    rebuild_lookup ();
+
+    return stats;
+}
+
+void ROM_Library::save () const
+{
+    std::string strings;
+    std::vector <Record> records (entries.size());
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        const Entry& entry = entries[i];
+        Record& record = records[i];
+
+        record = {};
+        record.path_offset = strings.size();
+        record.path_length = static_cast <u32> (entry.path.size());
+        record.format      = static_cast <u8> (entry.format);
+        record.submapper   = entry.submapper;
+        record.mapper      = entry.mapper;
+        record.mtime       = entry.mtime;
+        record.size        = entry.size;
+        record.prg_size    = entry.prg_size;
+        record.chr_size    = entry.chr_size;
+        record.crc32       = entry.crc32;
+        record.battery     = entry.battery;
+        record.trainer     = entry.trainer;
+        record.mirroring   = entry.mirroring;
+        std::memcpy (record.sha1, entry.sha1.data(), entry.sha1.size());
+
+        strings += entry.path;
+    }
+
+    Index_Header header {};
+    std::memcpy (header.magic, index_magic, sizeof(index_magic));
+    header.version      = index_version;
+    header.count        = static_cast <u32> (records.size());
+    header.strings_size = strings.size();
+
+    // readers never see a half written index
+    const std::string temporary = index_path + ".tmp";
+    {
+        std::ofstream file {temporary, std::ios::binary | std::ios::trunc};
+        file.write (reinterpret_cast <const char*> (&header), sizeof(header));
+        file.write (reinterpret_cast <const char*> (records.data()), static_cast <std::streamsize> (records.size() * sizeof(Record)));
+        file.write (strings.data(), static_cast <std::streamsize> (strings.size()));
+        file.close ();
+
+        if (file.fail())
+            throw std::runtime_error ("rom library: could not write " + temporary);
+    }
+
+    std::error_code error;
+    std::filesystem::rename (temporary, index_path, error);
+    if (error)
+        throw std::runtime_error ("rom library: could not replace " + index_path + ": " + error.message());
+}
+
+std::span <const ROM_Library::Entry> ROM_Library::get_entries () const
+{
+    return entries;
+}
+
+const ROM_Library::Entry* ROM_Library::find (const std::string_view path) const
+{
+    const auto it = by_path.find (path);
+    return it != by_path.end() ? &entries[it->second] : nullptr;
+}
+
+const ROM_Library::Entry* ROM_Library::find_crc32 (const u32 crc32) const
+{
+    const auto it = by_crc32.find (crc32);
+    return it != by_crc32.end() ? &entries[it->second] : nullptr;
+}
+
+void ROM_Library::rebuild_lookup ()
+{
+    by_path.clear ();
+    by_crc32.clear ();
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        by_path.emplace (entries[i].path, i);
+
+        if (entries[i].format != Format::INVALID)
+            by_crc32.emplace (entries[i].crc32, i);
+    }
+}
+
+/*
+    https://www.nesdev.org/wiki/NES_2.0
+
+    NES 2.0 is flags 7 bits 2-3 == 2. it adds mapper bits 8-11 and a submapper
+    in byte 8, and size msbs in byte 9, an msb nibble of F means the lsb byte
+    is an exponent / multiplier pair instead (2^E * (M*2+1) bytes).
+*/
+bool ROM_Library::identify (Entry& entry)
+{
+    std::shared_ptr <const ROM_Image> image;
+
+    try
+    {
+        image = ROM_Image::open (entry.path);
+    }
+    catch (const std::exception&)
+    {
+        entry.format = Format::INVALID;
+        return false;
+    }
+
+    const std::span <const u8> file = image->data();
+    entry.format = Format::INVALID;
+
+    if (file.size() < 16 || std::memcmp (file.data(), "NES\x1A", 4) != 0)
+        return true;
+
+    const u8* h = file.data();
+    const bool nes2 = (h[7] & 0x0C) == 0x08;
+
+    entry.battery   = h[6] & 0x02;
+    entry.trainer   = h[6] & 0x04;
+    entry.mirroring = (h[6] & 0x01) | ((h[6] & 0x08) >> 2);
+
+    u64 prg_size;
+    u64 chr_size;
+
+    if (nes2)
+    {
+        const auto rom_size = [] (const u8 lsb, const u8 msb, const u64 unit) -> u64
+        {
+            if (msb == 0x0F)
+                return (u64 {1} << (lsb >> 2)) * ((lsb & 0x03) * 2 + 1);
+            return ((u64 {msb} << 8) | lsb) * unit;
+        };
+
+        entry.mapper    = static_cast <u16> (((h[8] & 0x0F) << 8) | (h[7] & 0xF0) | (h[6] >> 4));
+        entry.submapper = h[8] >> 4;
+        prg_size = rom_size (h[4], h[9] & 0x0F, 16384);
+        chr_size = rom_size (h[5], h[9] >> 4, 8192);
+    }
+    else
+    {
+        // old dumps ("DiskDude!") have junk in bytes 7 - 15, the upper mapper nibble can't be trusted then
+        const bool junk = h[12] || h[13] || h[14] || h[15];
+
+        entry.mapper    = static_cast <u16> ((junk ? 0 : (h[7] & 0xF0)) | (h[6] >> 4));
+        entry.submapper = 0;
+        prg_size = u64 {h[4]} * 16384;
+        chr_size = u64 {h[5]} * 8192;
+    }
+
+    const std::size_t offset = 16 + (entry.trainer ? 512 : 0);
+    const bool complete = file.size() >= offset + prg_size + chr_size;
+
+    entry.prg_size = static_cast <u32> (prg_size);
+    entry.chr_size = static_cast <u32> (chr_size);
+
+    // a truncated dump still gets hashed as far as it goes, but it isn't a usable rom
+    const std::span <const u8> data = file.subspan (std::min (offset, file.size()), std::min <u64> (prg_size + chr_size, file.size() - std::min (offset, file.size())));
+
+    entry.crc32 = Hash::crc32 (data);
+    entry.sha1  = Hash::sha1 (data);
+
+    if (complete)
+        entry.format = nes2 ? Format::NES2 : Format::INES;
+
+    return true;
+}
@@ -0,0 +1,663 @@
+#include "rom_stream.h"
+#include "hash.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <zlib.h>
+
+namespace
+{
+    u16 get_u16 (const u8* src)
+    {
+        return static_cast <u16> (src[0] | (src[1] << 8));
+    }
+
+    u32 get_u32 (const u8* src)
+    {
+        return static_cast <u32> (src[0] | (src[1] << 8) | (src[2] << 16) | (u32 {src[3]} << 24));
+    }
+
+    // the uncompressed bytes of a container, front to back
+    class Reader
+    {
+    public:
+
+        Reader (const std::string& _name, const bool _check_crc, const u32 _expected_crc)
+        : name {_name}
+        , check_crc {_check_crc}
+        , expected_crc {_expected_crc}
+        , crc {0}
+        {}
+
+        virtual ~Reader () = default;
+
+        // up to out.size() bytes, 0 only at the end
+        std::size_t read (std::span <u8> out)
+        {
+            const std::size_t n = read_some (out);
+            if (check_crc)
+                crc = Hash::crc32 (out.first (n), crc);
+            return n;
+        }
+
+        void read_exact (std::span <u8> out)
+        {
+            while (!out.empty())
+            {
+                const std::size_t n = read (out);
+                if (n == 0)
+                    throw std::runtime_error (name + " is truncated");
+                out = out.subspan (n);
+            }
+        }
+
+        // runs to the end so the container's crc covers everything, throws if it fails
+        void finish ()
+        {
+            if (!check_crc && !get_stored ().empty())
+                return;
+
+            std::array <u8, 4096> scratch;
+            while (read (scratch))
+            {}
+
+            if (check_crc && crc != expected_crc)
+                throw std::runtime_error (name + " fails its crc check");
+        }
+
+        // all of the data if it sits uncompressed in the file, empty otherwise
+        virtual std::span <const u8> get_stored () const
+        {
+            return {};
+        }
+
+    protected:
+
+        std::string name;
+
+        virtual std::size_t read_some (std::span <u8> out) = 0;
+
+    private:
+
+        bool check_crc;
+        u32  expected_crc;
+        u32  crc;
+    };
+
+    class Stored_Reader final: public Reader
+    {
+    public:
+
+        Stored_Reader (std::span <const u8> _data, const std::string& _name, const bool _check_crc, const u32 _expected_crc)
+        : Reader {_name, _check_crc, _expected_crc}
+        , data {_data}
+        , position {0}
+        {}
+
+        std::span <const u8> get_stored () const override
+        {
+            return data;
+        }
+
+    private:
+
+        std::span <const u8> data;
+        std::size_t position;
+
+        std::size_t read_some (std::span <u8> out) override
+        {
+            const std::size_t n = std::min (out.size(), data.size() - position);
+            std::memcpy (out.data(), data.data() + position, n);
+            position += n;
+            return n;
+        }
+    };
+
+    // zlib writes straight into whatever read () is given
+    class Inflate_Reader final: public Reader
+    {
+    public:
+
+        // window_bits as for inflateInit2, 16 + MAX_WBITS for gzip, -MAX_WBITS for raw deflate (zip)
+        Inflate_Reader (std::span <const u8> compressed, const int window_bits, const std::string& _name, const bool _check_crc, const u32 _expected_crc)
+        : Reader {_name, _check_crc, _expected_crc}
+        , stream {}
+        , done {false}
+        {
+            if (compressed.size() > std::numeric_limits <uInt>::max())
+                throw std::runtime_error (name + " is too large");
+
+            if (inflateInit2 (&stream, window_bits) != Z_OK)
+                throw std::runtime_error (name + ": could not start inflating");
+
+            stream.next_in  = const_cast <Bytef*> (compressed.data());
+            stream.avail_in = static_cast <uInt> (compressed.size());
+        }
+
+        ~Inflate_Reader () override
+        {
+            inflateEnd (&stream);
+        }
+
+    private:
+
+        z_stream stream;
+        bool done;
+
+        std::size_t read_some (std::span <u8> out) override
+        {
+            if (done || out.empty())
+                return 0;
+
+            stream.next_out  = out.data();
+            stream.avail_out = static_cast <uInt> (std::min <std::size_t> (out.size(), std::numeric_limits <uInt>::max()));
+            const uInt requested = stream.avail_out;
+
+            while (stream.avail_out)
+            {
+                const int result = inflate (&stream, Z_NO_FLUSH);
+
+                if (result == Z_STREAM_END)
+                {
+                    done = true;
+                    break;
+                }
+
+                // Z_BUF_ERROR here means the input ran out before the stream ended
+                if (result != Z_OK)
+                    throw std::runtime_error (name + ": " + (result == Z_BUF_ERROR ? "truncated" : stream.msg ? stream.msg : "inflate failed"));
+            }
+
+            return requested - stream.avail_out;
+        }
+    };
+
+    /*
+        https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT
+
+        the central directory at the end lists the entries, each one points
+        back at its local header, the data follows that
+    */
+    std::unique_ptr <Reader> open_zip (std::span <const u8> file, const std::string& name)
+    {
+        constexpr std::size_t end_size = 22;
+
+        if (file.size() < end_size)
+            throw std::runtime_error (name + " is truncated");
+
+        // end of central directory record, followed by a comment of up to 64 KB
+        std::size_t end = file.size() - end_size;
+        const std::size_t lowest = end > 0xFFFF ? end - 0xFFFF : 0;
+        while (get_u32 (&file[end]) != 0x06054B50)
+        {
+            if (end == lowest)
+                throw std::runtime_error (name + " is not a zip archive");
+            --end;
+        }
+
+        const u16 entry_n = get_u16 (&file[end + 10]);
+        std::size_t position = get_u32 (&file[end + 16]);
+
+        const u8* chosen = nullptr;
+
+        for (u16 i = 0; i < entry_n; ++i)
+        {
+            if (position + 46 > file.size() || get_u32 (&file[position]) != 0x02014B50)
+                throw std::runtime_error (name + ": broken zip directory");
+
+            const u8* entry = &file[position];
+            const std::size_t name_size = get_u16 (entry + 28);
+
+            if (position + 46 + name_size > file.size())
+                throw std::runtime_error (name + ": broken zip directory");
+
+            std::string entry_name {reinterpret_cast <const char*> (entry + 46), name_size};
+            std::transform (entry_name.begin(), entry_name.end(), entry_name.begin(), [] (const unsigned char c) { return static_cast <char> (std::tolower (c)); });
+
+            // directories end in a slash, a .nes entry beats whatever came first
+            if (!entry_name.ends_with ('/'))
+            {
+                if (entry_name.ends_with (".nes"))
+                {
+                    chosen = entry;
+                    break;
+                }
+
+                if (chosen == nullptr)
+                    chosen = entry;
+            }
+
+            position += 46 + name_size + get_u16 (entry + 30) + get_u16 (entry + 32);
+        }
+
+        if (chosen == nullptr)
+            throw std::runtime_error (name + ": empty zip archive");
+
+        const u16 method          = get_u16 (chosen + 10);
+        const u32 crc             = get_u32 (chosen + 16);
+        const std::size_t size    = get_u32 (chosen + 20);
+        const std::size_t local   = get_u32 (chosen + 42);
+
+        if (local + 30 > file.size() || get_u32 (&file[local]) != 0x04034B50)
+            throw std::runtime_error (name + ": broken zip entry");
+
+        const std::size_t data = local + 30 + get_u16 (&file[local + 26]) + get_u16 (&file[local + 28]);
+
+        if (data + size > file.size())
+            throw std::runtime_error (name + " is truncated");
+
+        switch (method)
+        {
+            case 0: return std::make_unique <Stored_Reader> (file.subspan (data, size), name, true, crc);
+            case 8: return std::make_unique <Inflate_Reader> (file.subspan (data, size), -MAX_WBITS, name, true, crc);
+        }
+
+        throw std::runtime_error (name + ": zip compression method " + std::to_string (method) + " is not supported");
+    }
+
+    std::unique_ptr <Reader> open_reader (std::span <const u8> file, const std::string& name)
+    {
+        if (file.size() >= 2 && file[0] == 0x1F && file[1] == 0x8B)
+            return std::make_unique <Inflate_Reader> (file, 16 + MAX_WBITS, name, false, 0);
+
+        if (file.size() >= 4 && std::memcmp (file.data(), "PK\x03\x04", 4) == 0)
+            return open_zip (file, name);
+
+        return std::make_unique <Stored_Reader> (file, name, false, 0);
+    }
+
+    /*
+        https://zerosoft.zophar.net/ips.php
+
+        "PATCH", then records until "EOF"
+            offset  3 bytes big endian
+            size    2 bytes big endian, 0 means a run: 2 byte count, 1 byte value
+            data    size bytes
+    */
+    struct IPS_Record
+    {
+        u32 offset;
+        u32 size;
+        const u8* data;  // nullptr for a run of fill
+        u8 fill;
+    };
+
+    std::vector <IPS_Record> parse_ips (std::span <const u8> patch)
+    {
+        std::vector <IPS_Record> records;
+        std::size_t position = 5;
+
+        const auto need = [&] (const std::size_t n)
+        {
+            if (patch.size() - position < n)
+                throw std::runtime_error ("ips patch is truncated");
+        };
+
+        for (;;)
+        {
+            need (3);
+            if (std::memcmp (&patch[position], "EOF", 3) == 0)
+                break;
+
+            IPS_Record record {};
+            record.offset = static_cast <u32> ((patch[position] << 16) | (patch[position + 1] << 8) | patch[position + 2]);
+            position += 3;
+
+            need (2);
+            record.size = static_cast <u32> ((patch[position] << 8) | patch[position + 1]);
+            position += 2;
+
+            if (record.size)
+            {
+                need (record.size);
+                record.data = &patch[position];
+                position += record.size;
+            }
+            else
+            {
+                need (3);
+                record.size = static_cast <u32> ((patch[position] << 8) | patch[position + 1]);
+                record.fill = patch[position + 2];
+                position += 3;
+            }
+
+            records.push_back (record);
+        }
+
+        return records;
+    }
+
+    // trainer + prg + chr as a header describes them
+    u64 body_size (const std::array <u8, 16>& header)
+    {
+        return (header[6] & 0x04 ? 512 : 0) + u64 {header[4]} * 16384 + u64 {header[5]} * 8192;
+    }
+
+    // only the parts that land inside the buffers are written, before allocate () that is just the header
+    void apply_ips (ROM_Stream::Buffers& rom, std::span <const IPS_Record> records)
+    {
+        for (const auto& record : records)
+        {
+            for (u32 done = 0; done < record.size;)
+            {
+                const std::span <u8> destination = rom.span_at (u64 {record.offset} + done);
+                if (destination.empty())
+                    break;
+
+                const std::size_t n = std::min <std::size_t> (destination.size(), record.size - done);
+
+                if (record.data)
+                    std::memcpy (destination.data(), record.data + done, n);
+                else
+                    std::memset (destination.data(), record.fill, n);
+
+                done += static_cast <u32> (n);
+            }
+        }
+    }
+
+    // the bps target, written front to back into the rom buffers
+    class Target
+    {
+    public:
+
+        Target (ROM_Stream::Buffers& _rom, const u64 _size)
+        : rom {_rom}
+        , size {_size}
+        , offset {0}
+        , crc {0}
+        {
+            if (size < rom.header.size())
+                throw std::runtime_error ("bps target is not an iNES rom");
+        }
+
+        u64 get_offset () const
+        {
+            return offset;
+        }
+
+        void write (std::span <const u8> data)
+        {
+            if (data.size() > size - offset)
+                throw std::runtime_error ("bps patch writes past its target");
+
+            crc = Hash::crc32 (data, crc);
+
+            while (!data.empty())
+            {
+                const std::span <u8> destination = next ();
+                const std::size_t n = std::min (destination.size(), data.size());
+                std::memcpy (destination.data(), data.data(), n);
+                offset += n;
+                data = data.subspan (n);
+            }
+        }
+
+        // from earlier output, the two ranges overlap for runs so it goes a byte at a time
+        void copy (const u64 from, const u64 length)
+        {
+            if (from >= offset || length > size - offset)
+                throw std::runtime_error ("bps patch copies outside its target");
+
+            const u64 start = offset;
+
+            for (u64 i = 0; i < length; ++i)
+            {
+                next ()[0] = rom.span_at (from + i)[0];
+                ++offset;
+            }
+
+            for (u64 position = start; position < offset;)
+            {
+                const std::span <u8> written = rom.span_at (position).first (std::min <u64> (rom.span_at (position).size(), offset - position));
+                crc = Hash::crc32 (written, crc);
+                position += written.size();
+            }
+        }
+
+        void finish (const u32 expected_crc)
+        {
+            if (offset != size)
+                throw std::runtime_error ("bps patch ends before its target");
+
+            if (crc != expected_crc)
+                throw std::runtime_error ("bps patch result fails its crc check");
+        }
+
+    private:
+
+        ROM_Stream::Buffers& rom;
+        u64 size;
+        u64 offset;
+        u32 crc;
+
+        // the buffers are sized as soon as the header is complete
+        std::span <u8> next ()
+        {
+            if (offset == rom.header.size() && rom.size() == rom.header.size())
+            {
+                if (!ROM_Stream::is_ines (rom.header))
+                    throw std::runtime_error ("bps target is not an iNES rom");
+
+                rom.allocate ();
+
+                if (size < rom.size())
+                    throw std::runtime_error ("bps target is truncated");
+
+                rom.tail.resize (size - rom.size());
+            }
+
+            return rom.span_at (offset);
+        }
+    };
+
+    /*
+        https://github.com/blakesmith/rombp/blob/master/docs/bps_spec.md
+
+        "BPS1", varint source size, target size, metadata size, metadata,
+        actions, then source crc, target crc and patch crc (u32 little endian)
+
+        action = varint, low 2 bits the command, the rest length - 1
+            0  source read   source at the current output offset
+            1  target read   bytes from the patch
+            2  source copy   source at a relative, signed varint moved offset
+            3  target copy   earlier output, same offset scheme
+    */
+    ROM_Stream::Buffers apply_bps (Reader& reader, std::span <const u8> patch)
+    {
+        constexpr std::size_t footer_size = 12;
+
+        if (patch.size() < 4 + footer_size)
+            throw std::runtime_error ("bps patch is truncated");
+
+        const std::size_t end = patch.size() - footer_size;
+        const u8* footer = &patch[end];
+
+        if (Hash::crc32 (patch.first (patch.size() - 4)) != get_u32 (footer + 8))
+            throw std::runtime_error ("bps patch fails its crc check");
+
+        std::size_t position = 4;
+
+        const auto varint = [&] () -> u64
+        {
+            u64 data = 0;
+            u64 shift = 1;
+
+            for (;;)
+            {
+                if (position >= end)
+                    throw std::runtime_error ("bps patch is truncated");
+
+                const u8 x = patch[position++];
+                data += (x & 0x7F) * shift;
+                if (x & 0x80)
+                    break;
+                shift <<= 7;
+                data += shift;
+            }
+
+            return data;
+        };
+
+        const u64 source_size   = varint ();
+        const u64 target_size   = varint ();
+        const u64 metadata_size = varint ();
+
+        if (metadata_size > end - position)
+            throw std::runtime_error ("bps patch is truncated");
+        position += metadata_size;
+
+        // copies jump around the source, a compressed one has to be inflated whole
+        std::vector <u8> inflated;
+        std::span <const u8> source = reader.get_stored ();
+
+        if (source.empty())
+        {
+            inflated.resize (source_size);
+            reader.read_exact (inflated);
+            source = inflated;
+        }
+
+        reader.finish ();
+
+        if (source.size() != source_size || Hash::crc32 (source) != get_u32 (footer))
+            throw std::runtime_error ("bps patch is for a different rom");
+
+        ROM_Stream::Buffers rom {};
+        Target target {rom, target_size};
+
+        u64 source_offset = 0;
+        u64 target_offset = 0;
+
+        // offsets move by a sign bit + magnitude, negative ones wrap and fail the bounds checks
+        const auto move = [&] (u64& offset)
+        {
+            const u64 data = varint ();
+            offset += data & 1 ? ~(data >> 1) + 1 : data >> 1;
+        };
+
+        while (position < end)
+        {
+            const u64 action = varint ();
+            const u64 length = (action >> 2) + 1;
+
+            switch (action & 0x03)
+            {
+                case 0:
+                    if (target.get_offset () > source.size() || length > source.size() - target.get_offset ())
+                        throw std::runtime_error ("bps patch reads outside its source");
+                    target.write (source.subspan (target.get_offset (), length));
+                break;
+                case 1:
+                    if (length > end - position)
+                        throw std::runtime_error ("bps patch is truncated");
+                    target.write (patch.subspan (position, length));
+                    position += length;
+                break;
+                case 2:
+                    move (source_offset);
+                    if (source_offset > source.size() || length > source.size() - source_offset)
+                        throw std::runtime_error ("bps patch reads outside its source");
+                    target.write (source.subspan (source_offset, length));
+                    source_offset += length;
+                break;
+                case 3:
+                    move (target_offset);
+                    target.copy (target_offset, length);
+                    target_offset += length;
+                break;
+            }
+        }
+
+        target.finish (get_u32 (footer + 4));
+        return rom;
+    }
+}
+
+void ROM_Stream::Buffers::allocate ()
+{
+    if (!is_ines (header))
+        throw std::runtime_error ("not an iNES rom");
+
+    trainer.assign (header[6] & 0x04 ? 512 : 0, 0);
+    prg.assign (std::size_t {header[4]} * 16384, 0);
+    chr.assign (std::size_t {header[5]} * 8192, 0);
+}
+
+u64 ROM_Stream::Buffers::size () const
+{
+    return header.size() + trainer.size() + prg.size() + chr.size() + tail.size();
+}
+
+std::span <u8> ROM_Stream::Buffers::span_at (u64 offset)
+{
+    const std::span <u8> pieces[] {header, trainer, prg, chr, tail};
+
+    for (const auto piece : pieces)
+    {
+        if (offset < piece.size())
+            return piece.subspan (offset);
+        offset -= piece.size();
+    }
+
+    return {};
+}
+
+bool ROM_Stream::is_ines (std::span <const u8> file)
+{
+    return file.size() >= 16 && std::memcmp (file.data(), "NES\x1A", 4) == 0;
+}
+
+ROM_Stream::Buffers ROM_Stream::decode (std::span <const u8> file, const std::string& name, std::span <const u8> patch)
+{
+    const auto reader = open_reader (file, name);
+
+    if (patch.size() >= 4 && std::memcmp (patch.data(), "BPS1", 4) == 0)
+        return apply_bps (*reader, patch);
+
+    std::vector <IPS_Record> records;
+
+    if (!patch.empty())
+    {
+        if (patch.size() < 5 || std::memcmp (patch.data(), "PATCH", 5) != 0)
+            throw std::runtime_error ("unknown patch format");
+        records = parse_ips (patch);
+    }
+
+    Buffers rom {};
+
+    // a patch may change the sizes, the header is patched before it is read
+    reader->read_exact (rom.header);
+    const std::array <u8, 16> source_header = rom.header;
+    apply_ips (rom, records);
+
+    if (!is_ines (rom.header))
+        throw std::runtime_error (name + " is not an iNES rom");
+
+    rom.allocate ();
+
+    // ips works on file offsets, unpatched bytes stay where the source has them. a patch
+    // that grows the rom (translations, expansions) leaves zeros past the end of the
+    // source for its records to fill, a shrinking one drops what doesn't fit
+    u64 remaining = std::min (body_size (source_header), rom.size () - rom.header.size ());
+
+    for (u64 offset = rom.header.size (); remaining; )
+    {
+        const std::span <u8> destination = rom.span_at (offset);
+        const std::size_t n = static_cast <std::size_t> (std::min <u64> (destination.size (), remaining));
+
+        reader->read_exact (destination.first (n));
+        offset += n;
+        remaining -= n;
+    }
+
+    reader->finish ();
+
+    apply_ips (rom, records);
+    return rom;
+}
@@ -0,0 +1,60 @@
+#include "rom_watcher.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+ROM_Watcher::ROM_Watcher (const std::string& path)
+: name {std::filesystem::path {path}.filename ().string ()}
+, fd {::inotify_init1 (IN_NONBLOCK | IN_CLOEXEC)}
+{
+    if (fd < 0)
+        throw std::runtime_error (std::string {"watcher: inotify_init1: "} + std::strerror (errno));
+
+    auto directory = std::filesystem::path {path}.parent_path ();
+    if (directory.empty ())
+        directory = ".";
+
+    // the watch is released with the descriptor
+    if (::inotify_add_watch (fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        const int error = errno;
+        ::close (fd);
+        throw std::runtime_error ("watcher: could not watch " + directory.string () + ": " + std::strerror (error));
+    }
+}
+
+ROM_Watcher::~ROM_Watcher ()
+{
+    ::close (fd);
+}
+
+bool ROM_Watcher::poll ()
+{
+    // aligned for the inotify_event headers inside
+    alignas (inotify_event) char buffer[4096];
+    bool changed = false;
+
+    // drain everything that queued up since the last frame
+    for (;;)
+    {
+        const ssize_t length = ::read (fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const auto* event = reinterpret_cast <const inotify_event*> (buffer + offset);
+
+            // an overflowed queue may have dropped the event we wanted
+            if ((event->mask & IN_Q_OVERFLOW) || (event->len && name == event->name))
+                changed = true;
+
+            offset += static_cast <ssize_t> (sizeof(inotify_event) + event->len);
+        }
+    }
+
+    return changed;
+}
@@ -0,0 +1,60 @@
+#include "save_ram.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Save_RAM::Save_RAM (const std::string& _path)
+: path {_path}
+, mapping {nullptr}
+{
+    const int fd = ::open (path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::runtime_error ("save: could not open " + path + ": " + std::strerror (errno));
+
+    struct stat info {};
+    if (fstat (fd, &info) != 0 || (static_cast <std::size_t> (info.st_size) < size && ftruncate (fd, size) != 0))
+    {
+        const int error = errno;
+        ::close (fd);
+        throw std::runtime_error ("save: could not size " + path + ": " + std::strerror (error));
+    }
+
+    void* address = ::mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int error = errno;
+
+    // the mapping stays valid without the descriptor
+    ::close (fd);
+
+    if (address == MAP_FAILED)
+        throw std::runtime_error ("save: could not map " + path + ": " + std::strerror (error));
+
+    mapping = static_cast <u8*> (address);
+}
+
+Save_RAM::~Save_RAM ()
+{
+    if (::msync (mapping, size, MS_SYNC) != 0)
+        std::clog << "save: could not write " << path << ": " << std::strerror (errno) << '\n';
+
+    ::munmap (mapping, size);
+}
+
+std::span <u8> Save_RAM::data ()
+{
+    return {mapping, size};
+}
+
+const std::string& Save_RAM::get_path () const
+{
+    return path;
+}
+
+void Save_RAM::flush ()
+{
+    ::msync (mapping, size, MS_ASYNC);
+}
@@ -0,0 +1,47 @@
+#include "scheduler.h"
+#include <algorithm>
+
+Scheduler::Scheduler ()
+: next {never}
+{
+    when.fill (never);
+}
+
+void Scheduler::schedule (const Event event, const u64 cycle)
+{
+    when[static_cast <std::size_t> (event)] = cycle;
+    update_next ();
+}
+
+void Scheduler::cancel (const Event event)
+{
+    when[static_cast <std::size_t> (event)] = never;
+    update_next ();
+}
+
+u64 Scheduler::get (const Event event) const
+{
+    return when[static_cast <std::size_t> (event)];
+}
+
+u64 Scheduler::next_cycle () const
+{
+    return next;
+}
+
+bool Scheduler::pop_due (const u64 cycle, Event& event)
+{
+    if (next > cycle)
+        return false;
+
+    const auto earliest = std::min_element (when.begin(), when.end());
+    event = static_cast <Event> (earliest - when.begin());
+    *earliest = never;
+    update_next ();
+    return true;
+}
+
+void Scheduler::update_next ()
+{
+    next = *std::min_element (when.begin(), when.end());
+}
@@ -0,0 +1,358 @@
+#include "system.h"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    // cpu cycles per emulated frame (ntsc)
+    constexpr u64 frame_cycles = 29781;
+
+    constexpr u64 dots_per_line    = 341;
+    constexpr u64 dots_per_frame   = dots_per_line * 262;
+    constexpr u64 clocks_per_frame = 241; // 240 visible lines and the pre-render line
+
+    // dot within a line where A12 rises, 0 if it never does with these settings
+    u64 get_a12_dot (const u8 ctrl, const u8 mask)
+    {
+        if (!(mask & 0x18))
+            return 0;
+
+        // sprites from $1000 (8x16 sprites mostly are), A12 goes up with the first sprite fetch
+        if (ctrl & 0x28)
+            return 260;
+
+        // background from $1000, goes up with the first tile fetch for the next line
+        if (ctrl & 0x10)
+            return 324;
+
+        return 0;
+    }
+
+    // number of A12 rises on dots 0 .. dot
+    u64 count_clocks (const u64 dot, const u64 a12_dot)
+    {
+        const u64 position = dot % dots_per_frame;
+
+        u64 clocks = position >= a12_dot ? std::min <u64> ((position - a12_dot) / dots_per_line + 1, 240) : 0;
+        if (position >= 261 * dots_per_line + a12_dot)
+            ++clocks;
+
+        return dot / dots_per_frame * clocks_per_frame + clocks;
+    }
+
+    // dot of the index'th (0 based) A12 rise
+    u64 get_clock_dot (const u64 index, const u64 a12_dot)
+    {
+        const u64 line = index % clocks_per_frame;
+        return index / clocks_per_frame * dots_per_frame + (line < 240 ? line : 261) * dots_per_line + a12_dot;
+    }
+
+    // function local so registrations never run before it exists
+    std::map <u16, NES_System::Factory>& factories ()
+    {
+        static std::map <u16, NES_System::Factory> registry;
+        return registry;
+    }
+
+    template <class M>
+    M& get_board (NES_ROM& rom)
+    {
+        M* board = dynamic_cast <M*> (&rom.get_mapper ());
+        if (board == nullptr)
+            throw std::runtime_error ("system: rom mapper " + std::to_string (rom.get_mapper_id ()) + " is not mapper " + std::to_string (M::id));
+        return *board;
+    }
+
+    template <class M>
+    bool add_system ()
+    {
+        return NES_System::add_factory (M::id, [] (NES_ROM& rom, const double sample_rate) -> std::unique_ptr <NES_System>
+        {
+            return std::make_unique <System <M>> (rom, sample_rate);
+        });
+    }
+}
+
+std::unique_ptr <NES_System> NES_System::create (NES_ROM& rom, const double sample_rate)
+{
+    const auto it = factories ().find (rom.get_mapper_id ());
+    if (it == factories ().end())
+        throw std::runtime_error ("system: no system for mapper " + std::to_string (rom.get_mapper_id ()));
+
+    return it->second (rom, sample_rate);
+}
+
+bool NES_System::add_factory (const u16 mapper_id, Factory factory)
+{
+    return factories ().emplace (mapper_id, factory).second;
+}
+
+NES_System::~NES_System ()
+{}
+
+template <class M>
+System <M>::System (NES_ROM& _rom, const double sample_rate)
+: rom {_rom}
+, mapper {get_board <M> (_rom)}
+, ram {}
+, cpu {*this}
+, apu {sample_rate, [this] (const u16 address) { return read (address); }}
+, cycle {0}
+, irq_line {false}
+, ppu_ctrl {0}
+, ppu_mask {0}
+, counter_dot {0}
+{
+    reset ();
+}
+
+template <class M>
+void System <M>::reset ()
+{
+    ram.fill (0);
+
+    mapper.reset ();
+
+    // the trainer is meant to be at $7000 before the program starts
+    const auto trainer = rom.get_trainer ();
+    const auto prg_ram = mapper.get_prg_ram ();
+    if (!trainer.empty())
+        std::copy (trainer.begin(), trainer.end(), prg_ram.begin() + 0x1000);
+
+    for (std::size_t event = 0; event < static_cast <std::size_t> (Scheduler::Event::COUNT); ++event)
+        scheduler.cancel (static_cast <Scheduler::Event> (event));
+
+    apu.reset ();
+    cycle = 0;
+    irq_line = false;
+    ppu_ctrl = 0;
+    ppu_mask = 0;
+    counter_dot = 0;
+    apu.write (0x4015, 0x00, cycle);
+    schedule_apu_irq ();
+
+    cpu.reset ();
+}
+
+template <class M>
+std::size_t System <M>::run_frame (std::span <i16> out)
+{
+    const u64 start = cycle;
+    const u64 origin = cpu.get_cycles ();
+
+    apply_freezes ();
+
+    scheduler.schedule (Scheduler::Event::FRAME, start + frame_cycles);
+
+    for (bool frame_done = false; !frame_done;)
+    {
+        Scheduler::Event event;
+
+        while (scheduler.pop_due (cycle, event))
+        {
+            switch (event)
+            {
+                case Scheduler::Event::FRAME:
+                    frame_done = true;
+                break;
+                case Scheduler::Event::APU_IRQ:
+                    irq_line = irq_line || apu.irq_pending (cycle);
+                    schedule_apu_irq ();
+                break;
+                case Scheduler::Event::MAPPER_IRQ:
+                    sync_scanline_counter ();
+                    irq_line = irq_line || mapper.irq_pending ();
+                    schedule_mapper_irq ();
+                break;
+                default:
+                break;
+            }
+        }
+
+        if (frame_done)
+            break;
+
+        // straight up to the next event, writes can move it closer so it is read every instruction
+        while (cycle < scheduler.next_cycle ())
+        {
+            if (irq_line)
+            {
+                if (apu.irq_pending (cycle) || mapper.irq_pending ())
+                    cpu.irq ();
+                else
+                    irq_line = false;
+            }
+
+            cpu.update ();
+            cycle = start + (cpu.get_cycles () - origin);
+        }
+    }
+
+    rom.flush_save ();
+
+    apu.end_frame (cycle);
+    return apu.get_output ().read_samples (out);
+}
+
+template <class M>
+void System <M>::set_cheats (std::span <const Cheat::Code> codes)
+{
+    mapper.set_rom_patches (codes);
+
+    freezes.clear ();
+    for (const auto& code : codes)
+    {
+        if (code.address < 0x2000 || (code.address >= 0x6000 && code.address < 0x8000))
+            freezes.push_back (code);
+    }
+}
+
+template <class M>
+void System <M>::apply_freezes ()
+{
+    for (const auto& code : freezes)
+    {
+        u8& byte = code.address < 0x2000 ? ram[code.address & 0x07FF] : mapper.get_prg_ram ()[code.address & 0x1FFF];
+
+        if (!code.has_compare || byte == code.compare)
+            byte = code.value;
+    }
+}
+
+template <class M>
+CPU::MOS6502& System <M>::get_cpu ()
+{
+    return cpu;
+}
+
+template <class M>
+APU::RP2A03& System <M>::get_apu ()
+{
+    return apu;
+}
+
+template <class M>
+u64 System <M>::get_cycles () const
+{
+    return cycle;
+}
+
+template <class M>
+u8 System <M>::read (const u16 address)
+{
+    if (address < 0x2000)
+        return ram[address & 0x07FF];
+
+    if (address >= 0x8000)
+        return mapper.cpu_read (address);
+
+    if (address == 0x4015)
+        return apu.read_status (cycle);
+
+    u8 data = 0;
+    if (address >= 0x6000)
+        mapper.prg_ram_read (address, data);
+
+    return data;
+}
+
+template <class M>
+void System <M>::write (const u16 address, const u8 data)
+{
+    if (address < 0x2000)
+        ram[address & 0x07FF] = data;
+    else if (address < 0x4000)
+    {
+        const u16 reg = address & 0x0007;
+
+        if (reg <= 1)
+        {
+            sync_scanline_counter ();
+            (reg == 0 ? ppu_ctrl : ppu_mask) = data;
+            schedule_mapper_irq ();
+        }
+    }
+    else if (address >= 0x4000 && address <= 0x4017 && address != 0x4014 && address != 0x4016)
+    {
+        apu.write (address, data, cycle);
+
+        // a new frame counter mode restarts the sequence, the dmc ones move or start the end of its sample
+        if (address == 0x4010 || address == 0x4013 || address == 0x4015 || address == 0x4017)
+        {
+            irq_line = irq_line || apu.irq_pending (cycle);
+            schedule_apu_irq ();
+        }
+    }
+    else if (address >= 0x6000 && address < 0x8000)
+        mapper.prg_ram_write (address, data);
+    else if (address >= 0x4020)
+    {
+        sync_scanline_counter ();
+        mapper.cpu_write (address, data);
+        schedule_mapper_irq ();
+    }
+}
+
+template <class M>
+void System <M>::schedule_apu_irq ()
+{
+    const u64 when = apu.get_next_irq ();
+
+    if (when != Scheduler::never && when > cycle)
+        scheduler.schedule (Scheduler::Event::APU_IRQ, when);
+    else
+        scheduler.cancel (Scheduler::Event::APU_IRQ);
+}
+
+template <class M>
+void System <M>::sync_scanline_counter ()
+{
+    if constexpr (M::scanline_counter)
+    {
+        const u64 dot = cycle * 3;
+        const u64 a12_dot = get_a12_dot (ppu_ctrl, ppu_mask);
+
+        if (a12_dot)
+            mapper.clock_scanlines (count_clocks (dot, a12_dot) - count_clocks (counter_dot, a12_dot));
+
+        counter_dot = dot;
+    }
+}
+
+template <class M>
+void System <M>::schedule_mapper_irq ()
+{
+    if constexpr (M::scanline_counter)
+    {
+        const int clocks = mapper.scanlines_until_irq ();
+        const u64 a12_dot = get_a12_dot (ppu_ctrl, ppu_mask);
+
+        if (clocks < 0 || a12_dot == 0)
+        {
+            scheduler.cancel (Scheduler::Event::MAPPER_IRQ);
+            return;
+        }
+
+        // the clocks-th rise after the ones already counted, rounded up to the cpu cycle it falls in
+        const u64 dot = get_clock_dot (count_clocks (counter_dot, a12_dot) + static_cast <u64> (clocks) - 1, a12_dot);
+        scheduler.schedule (Scheduler::Event::MAPPER_IRQ, (dot + 2) / 3);
+    }
+}
+
+
+// the supported boards, registering a System <M> is what instantiates it and its cpu core
+
+namespace
+{
+    template <class... M>
+    bool add_systems (Board_List <M...>)
+    {
+        bool added = true;
+        ((added = add_system <M> () && added), ...);
+        return added;
+    }
+
+    [[maybe_unused]] const bool systems_registered = add_systems (Boards {});
+}
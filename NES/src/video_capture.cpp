@@ -0,0 +1,331 @@
+#include "video_capture.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace
+{
+    // big enough for a whole png, a multiple of the O_DIRECT block size
+    constexpr std::size_t buffer_size = 4 << 20;
+    constexpr std::size_t block_size  = 4096;
+
+    constexpr std::size_t rgb_row_size = PPU::screen_width * 3;
+
+    // ntsc frame rate is 39375000 / 655171 (60.0988), nes pixels are 8:7
+    constexpr const char* y4m_header = "YUV4MPEG2 W256 H240 F39375000:655171 Ip A8:7 C444\n";
+
+    void put_u32_be (u8* dst, const u32 value)
+    {
+        dst[0] = value >> 24;
+        dst[1] = value >> 16;
+        dst[2] = value >> 8;
+        dst[3] = value;
+    }
+
+    int open_output (const std::string& path, const bool direct_io)
+    {
+        constexpr int flags = O_WRONLY | O_CREAT | O_TRUNC;
+
+#ifdef O_DIRECT
+        if (direct_io)
+        {
+            const int fd = ::open (path.c_str(), flags | O_DIRECT, 0644);
+
+            // not every file system supports it (tmpfs), fall back to buffered
+            if (fd >= 0 || errno != EINVAL)
+                return fd;
+        }
+#else
+        (void) direct_io;
+#endif
+        return ::open (path.c_str(), flags, 0644);
+    }
+}
+
+PPU::Video_Capture::Video_Capture (const std::string& _path, const Format _format, const Palette& palette, const Policy _policy, const bool _direct_io)
+: path {_path}
+, format {_format}
+, rgb {}
+, yuv {}
+, fd {-1}
+, direct_io {false}
+, buffer {static_cast <u8*> (std::aligned_alloc (block_size, buffer_size)), std::free}
+, buffer_used {0}
+, frame_number {0}
+, frames_written {0}
+, failed {false}
+, writer {_policy}
+{
+    if (!buffer)
+        throw std::runtime_error ("capture: out of memory");
+
+    for (int emphasis = 0; emphasis < Palette::emphasis_n; ++emphasis)
+    {
+        for (int index = 0; index < Palette::color_n; ++index)
+        {
+            const u32 color = palette.get_color (index, emphasis);
+            const int r = color & 0xFF;
+            const int g = (color >> 8) & 0xFF;
+            const int b = (color >> 16) & 0xFF;
+
+            rgb[emphasis][index] = {static_cast <u8> (r), static_cast <u8> (g), static_cast <u8> (b)};
+
+            // BT.601, studio range
+            yuv[emphasis][index] =
+            {
+                static_cast <u8> (((66 * r + 129 * g + 25 * b + 128) >> 8) + 16),
+                static_cast <u8> (((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128),
+                static_cast <u8> (((112 * r - 94 * g - 18 * b + 128) >> 8) + 128),
+            };
+        }
+    }
+
+    if (format == Format::PNG)
+    {
+        raw.resize ((rgb_row_size + 1) * screen_height);
+        compressed.resize (compressBound (raw.size()));
+    }
+    else
+    {
+        fd = open_output (path, _direct_io);
+        if (fd < 0)
+            throw std::runtime_error ("capture: could not open " + path + ": " + std::strerror (errno));
+
+#ifdef O_DIRECT
+        direct_io = _direct_io && (fcntl (fd, F_GETFL) & O_DIRECT);
+#endif
+        if (format == Format::Y4M)
+            append (y4m_header, std::strlen (y4m_header));
+    }
+
+    writer.start ([this] (const Frame& frame) { return write_frame (frame); }, [this]
+    {
+        if (fd >= 0 && !failed)
+            flush (true);
+    });
+}
+
+PPU::Video_Capture::~Video_Capture ()
+{
+    writer.stop ();
+
+    if (fd >= 0)
+        ::close (fd);
+}
+
+bool PPU::Video_Capture::submit (const Frame& frame)
+{
+    Frame* slot = writer.acquire ();
+    if (!slot)
+        return false;
+
+    *slot = frame;
+    writer.publish ();
+    return true;
+}
+
+u64 PPU::Video_Capture::get_frames_written () const {return frames_written.load (std::memory_order_relaxed);}
+u64 PPU::Video_Capture::get_frames_dropped () const {return writer.get_dropped ();}
+bool PPU::Video_Capture::has_failed () const {return failed.load (std::memory_order_relaxed);}
+
+bool PPU::Video_Capture::write_frame (const Frame& frame)
+{
+    // after a write error everything left is thrown away so submit () never hangs
+    if (failed.load (std::memory_order_relaxed))
+        return false;
+
+    switch (format)
+    {
+        case Format::Y4M:     encode_y4m (frame); break;
+        case Format::RAW_RGB: encode_rgb (frame); break;
+        case Format::PNG:     encode_png (frame, frame_number++); break;
+    }
+
+    if (!failed)
+        frames_written.fetch_add (1, std::memory_order_relaxed);
+
+    return true;
+}
+
+void PPU::Video_Capture::encode_y4m (const Frame& frame)
+{
+    static constexpr char frame_header[] = "FRAME\n";
+    append (frame_header, sizeof(frame_header) - 1);
+
+    // planar Y, U, V
+    u8 row[screen_width];
+    for (int plane = 0; plane < 3; ++plane)
+    {
+        for (int y = 0; y < screen_height; ++y)
+        {
+            const auto& table = yuv[frame.emphasis[y] & 0x07];
+            const u8* pixels = frame.get_row (y);
+
+            for (int x = 0; x < screen_width; ++x)
+                row[x] = table[pixels[x] & 0x3F][plane];
+
+            append (row, sizeof(row));
+        }
+    }
+}
+
+void PPU::Video_Capture::encode_rgb (const Frame& frame)
+{
+    u8 row[rgb_row_size];
+    for (int y = 0; y < screen_height; ++y)
+    {
+        const auto& table = rgb[frame.emphasis[y] & 0x07];
+        const u8* pixels = frame.get_row (y);
+
+        for (int x = 0; x < screen_width; ++x)
+            std::memcpy (row + x * 3, table[pixels[x] & 0x3F].data(), 3);
+
+        append (row, sizeof(row));
+    }
+}
+
+/*
+    https://www.w3.org/TR/png/
+
+    signature, IHDR (8 bit rgb), one IDAT, IEND. every row starts with filter
+    type 0, the deflate level is kept low, the point is keeping up with the
+    emulator, not the smallest file.
+*/
+void PPU::Video_Capture::encode_png (const Frame& frame, const u64 number)
+{
+    for (int y = 0; y < screen_height; ++y)
+    {
+        u8* row = raw.data() + y * (rgb_row_size + 1);
+        const auto& table = rgb[frame.emphasis[y] & 0x07];
+        const u8* pixels = frame.get_row (y);
+
+        row[0] = 0;
+        for (int x = 0; x < screen_width; ++x)
+            std::memcpy (row + 1 + x * 3, table[pixels[x] & 0x3F].data(), 3);
+    }
+
+    uLongf compressed_size = compressed.size();
+    if (compress2 (compressed.data(), &compressed_size, raw.data(), raw.size(), 1) != Z_OK)
+    {
+        std::cerr << "capture: png compression failed" << std::endl;
+        failed = true;
+        return;
+    }
+
+    u8* out = buffer.get();
+    std::size_t size = 0;
+
+    const auto chunk = [&] (const char* type, const u8* data, const u32 length)
+    {
+        put_u32_be (out + size, length);
+        std::memcpy (out + size + 4, type, 4);
+        if (length)
+            std::memcpy (out + size + 8, data, length);
+
+        const u32 crc = crc32 (0, out + size + 4, length + 4);
+        put_u32_be (out + size + 8 + length, crc);
+        size += length + 12;
+    };
+
+    static constexpr u8 signature[8] {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::memcpy (out, signature, sizeof(signature));
+    size = sizeof(signature);
+
+    u8 ihdr[13] {};
+    put_u32_be (ihdr, screen_width);
+    put_u32_be (ihdr + 4, screen_height);
+    ihdr[8] = 8; // bit depth
+    ihdr[9] = 2; // color type rgb
+
+    chunk ("IHDR", ihdr, sizeof(ihdr));
+    chunk ("IDAT", compressed.data(), static_cast <u32> (compressed_size));
+    chunk ("IEND", nullptr, 0);
+
+    char name[32];
+    std::snprintf (name, sizeof(name), "_%06llu.png", static_cast <unsigned long long> (number));
+
+    const std::string file_name = path + name;
+    const int file = ::open (file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0)
+    {
+        std::cerr << "capture: could not open " << file_name << ": " << std::strerror (errno) << std::endl;
+        failed = true;
+        return;
+    }
+
+    write_all (file, out, size);
+    ::close (file);
+}
+
+void PPU::Video_Capture::append (const void* data, std::size_t size)
+{
+    const u8* bytes = static_cast <const u8*> (data);
+
+    while (size)
+    {
+        const std::size_t n = std::min (size, buffer_size - buffer_used);
+        std::memcpy (buffer.get() + buffer_used, bytes, n);
+        buffer_used += n;
+        bytes += n;
+        size -= n;
+
+        if (buffer_used == buffer_size)
+            flush (false);
+    }
+}
+
+void PPU::Video_Capture::flush (const bool final)
+{
+    if (failed)
+        return;
+
+    std::size_t n = buffer_used;
+
+    if (direct_io)
+    {
+        // O_DIRECT only takes whole blocks, the tail waits for the next flush
+        n -= n % block_size;
+
+#ifdef O_DIRECT
+        // except at the very end, the last partial block goes out buffered
+        if (final && n != buffer_used)
+        {
+            write_all (fd, buffer.get(), n);
+            fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) & ~O_DIRECT);
+            write_all (fd, buffer.get() + n, buffer_used - n);
+            buffer_used = 0;
+            return;
+        }
+#endif
+    }
+
+    write_all (fd, buffer.get(), n);
+    std::memmove (buffer.get(), buffer.get() + n, buffer_used - n);
+    buffer_used -= n;
+}
+
+bool PPU::Video_Capture::write_all (const int file, const u8* data, std::size_t size)
+{
+    while (size)
+    {
+        const ssize_t n = ::write (file, data, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            std::cerr << "capture: write to " << path << " failed: " << std::strerror (errno) << std::endl;
+            failed = true;
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
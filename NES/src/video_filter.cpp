@@ -0,0 +1,421 @@
+#include "video_filter.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    int band_count (const int thread_n)
+    {
+        const int n = thread_n > 0 ? thread_n : static_cast <int> (std::thread::hardware_concurrency ());
+        return std::clamp (n, 1, 8);
+    }
+
+    /*
+        NTSC
+
+        every dot of the 2C02 is 8 samples of a 12 phase color subcarrier, a
+        pixel is a square wave between a low and a high level for its luma, in
+        phase with its hue. 341 dots per line moves the phase 4 samples per
+        scanline, the skipped dot on odd frames makes frames alternate 0 / 4.
+    */
+    constexpr int samples_per_dot = 8;
+    constexpr int ntsc_width      = 512;
+    constexpr int ntsc_window     = 12;
+
+    constexpr std::array <float, 4> low_levels  {0.228f, 0.312f, 0.552f, 0.880f};
+    constexpr std::array <float, 4> high_levels {0.616f, 0.840f, 1.100f, 1.100f};
+    constexpr float black = 0.312f;
+    constexpr float white = 1.100f;
+    constexpr float emphasis_attenuation = 0.746f;
+
+    // decoder hue shift in samples, lines the decoded hues up with the palette
+    constexpr float hue_shift = 3.9f;
+
+    struct NTSC_Tables
+    {
+        // normalized level of [emphasis][index][phase]
+        std::array <std::array <std::array <float, ntsc_window>, 64>, 8> signal;
+        std::array <float, ntsc_window> cos_phase;
+        std::array <float, ntsc_window> sin_phase;
+        std::array <u8, 1024> gamma; // decoded 0.0 - 1.0 to a display byte
+
+        NTSC_Tables ()
+        {
+            for (int emphasis = 0; emphasis < 8; ++emphasis)
+            for (int index = 0; index < 64; ++index)
+            for (int phase = 0; phase < ntsc_window; ++phase)
+            {
+                const int color = index & 0x0F;
+                const int level = color > 13 ? 1 : (index >> 4) & 3;
+                const auto in_phase = [phase] (const int c) { return (c + phase) % 12 < 6; };
+
+                float low  = low_levels[level];
+                float high = high_levels[level];
+                if (color == 0)  low = high;
+                if (color > 12)  high = low;
+
+                float level_out = in_phase (color) ? high : low;
+                if (((emphasis & 1) && in_phase (0)) || ((emphasis & 2) && in_phase (4)) || ((emphasis & 4) && in_phase (8)))
+                    level_out *= emphasis_attenuation;
+
+                signal[emphasis][index][phase] = (level_out - black) / (white - black);
+            }
+
+            for (int phase = 0; phase < ntsc_window; ++phase)
+            {
+                cos_phase[phase] = std::cos (std::numbers::pi_v <float> * (phase + hue_shift) / 6.f);
+                sin_phase[phase] = std::sin (std::numbers::pi_v <float> * (phase + hue_shift) / 6.f);
+            }
+
+            for (std::size_t i = 0; i < gamma.size(); ++i)
+                gamma[i] = static_cast <u8> (255.95f * std::pow (i / 1023.f, 2.2f / 1.8f));
+        }
+    };
+
+    const NTSC_Tables& ntsc_tables ()
+    {
+        static const NTSC_Tables tables;
+        return tables;
+    }
+
+    u8 to_display (const NTSC_Tables& tables, const float value)
+    {
+        return tables.gamma[static_cast <std::size_t> (std::clamp (value, 0.f, 1.f) * 1023.f)];
+    }
+
+    // repeats every pixel k times
+    void expand_row (const u32* src, u32* dst, const int k)
+    {
+#if defined(__SSE2__)
+        if (k == 2)
+        {
+            for (int x = 0; x < PPU::screen_width; x += 4)
+            {
+                const __m128i pixels = _mm_loadu_si128 (reinterpret_cast <const __m128i*> (src + x));
+                _mm_storeu_si128 (reinterpret_cast <__m128i*> (dst + x * 2),     _mm_unpacklo_epi32 (pixels, pixels));
+                _mm_storeu_si128 (reinterpret_cast <__m128i*> (dst + x * 2 + 4), _mm_unpackhi_epi32 (pixels, pixels));
+            }
+            return;
+        }
+#endif
+        for (int x = 0; x < PPU::screen_width; ++x)
+            std::fill_n (dst + x * k, k, src[x]);
+    }
+
+    // copy of a frame row with the edge pixels repeated once on both sides
+    void pad_row (const u8* src, u8* dst)
+    {
+        dst[0] = src[0];
+        std::memcpy (dst + 1, src, PPU::screen_width);
+        dst[PPU::screen_width + 1] = src[PPU::screen_width - 1];
+    }
+}
+
+PPU::Video_Filter::Video_Filter (const Palette& _palette, const Mode _mode, const int _scale, const int thread_n)
+: palette {_palette}
+, mode {_mode}
+, scale {_mode == Mode::SCALE2X ? 2 : _mode == Mode::SCALE3X ? 3 : _mode == Mode::NTSC ? 1 : std::clamp (_scale, 1, 4)}
+, width {_mode == Mode::NTSC ? ntsc_width : screen_width * scale}
+, height {screen_height * (_mode == Mode::NTSC ? 1 : scale)}
+, scratch (band_count (thread_n))
+, frame {nullptr}
+, dst {nullptr}
+, pitch {0}
+, frame_n {0}
+, stopping {false}
+, start {static_cast <std::ptrdiff_t> (scratch.size())}
+, done {static_cast <std::ptrdiff_t> (scratch.size())}
+{
+    if (mode == Mode::NTSC)
+        ntsc_tables ();
+
+    for (auto& s : scratch)
+    {
+        // three padded source rows, then room for the widest scaled index row
+        s.indices.resize ((screen_width + 2) * 3 + screen_width * 3 * 3);
+        s.row.resize (screen_width);
+        s.signal.resize ((screen_width * samples_per_dot + ntsc_window) * 4 + 3); // samples + 3 running sums
+    }
+
+    // band 0 is done by the thread calling apply ()
+    for (std::size_t band = 1; band < scratch.size(); ++band)
+        workers.emplace_back (&Video_Filter::work, this, static_cast <int> (band));
+}
+
+PPU::Video_Filter::~Video_Filter ()
+{
+    stopping = true;
+    start.arrive_and_wait ();
+
+    for (auto& worker : workers)
+        worker.join ();
+}
+
+int PPU::Video_Filter::get_width () const {return width;}
+int PPU::Video_Filter::get_height () const {return height;}
+
+void PPU::Video_Filter::apply (const Frame& _frame, u32* _dst, const std::size_t _pitch)
+{
+    frame = &_frame;
+    dst = _dst;
+    pitch = _pitch;
+
+    start.arrive_and_wait ();
+    run_band (0);
+    done.arrive_and_wait ();
+
+    ++frame_n;
+}
+
+void PPU::Video_Filter::work (const int band)
+{
+    while (true)
+    {
+        start.arrive_and_wait ();
+        if (stopping)
+            return;
+
+        run_band (band);
+        done.arrive_and_wait ();
+    }
+}
+
+void PPU::Video_Filter::run_band (const int band)
+{
+    const int band_n = static_cast <int> (scratch.size());
+    const int begin = screen_height * band / band_n;
+    const int end = screen_height * (band + 1) / band_n;
+
+    for (int y = begin; y < end; ++y)
+    {
+        switch (mode)
+        {
+            case Mode::NEAREST: nearest  (y, scratch[band]); break;
+            case Mode::SCALE2X: scale_2x (y, scratch[band]); break;
+            case Mode::SCALE3X: scale_3x (y, scratch[band]); break;
+            case Mode::NTSC:    ntsc     (y, scratch[band]); break;
+        }
+    }
+}
+
+void PPU::Video_Filter::nearest (const int y, Scratch& s)
+{
+    u8* out = reinterpret_cast <u8*> (dst) + pitch * y * scale;
+
+    if (scale == 1)
+    {
+        palette.convert_row (frame->get_row (y), reinterpret_cast <u32*> (out), screen_width, frame->emphasis[y]);
+        return;
+    }
+
+    palette.convert_row (frame->get_row (y), s.row.data(), screen_width, frame->emphasis[y]);
+    expand_row (s.row.data(), reinterpret_cast <u32*> (out), scale);
+
+    for (int i = 1; i < scale; ++i)
+        std::memcpy (out + pitch * i, out, width * sizeof(u32));
+}
+
+/*
+    Scale2x
+
+      B        E0 E1
+    D E F  ->  E2 E3
+      H
+
+    E0 = D == B && B != F && D != H ? D : E
+    E1 = B == F && B != D && F != H ? F : E
+    E2 = D == H && D != B && H != F ? D : E
+    E3 = H == F && D != H && B != F ? F : E
+*/
+void PPU::Video_Filter::scale_2x (const int y, Scratch& s)
+{
+    u8* up     = s.indices.data();
+    u8* center = up + screen_width + 2;
+    u8* down   = center + screen_width + 2;
+    u8* top    = down + screen_width + 2;
+    u8* bottom = top + screen_width * 2;
+
+    pad_row (frame->get_row (std::max (y - 1, 0)), up);
+    pad_row (frame->get_row (y), center);
+    pad_row (frame->get_row (std::min (y + 1, screen_height - 1)), down);
+
+#if defined(__SSE2__)
+    for (int x = 0; x < screen_width; x += 16)
+    {
+        const auto load = [] (const u8* p) { return _mm_loadu_si128 (reinterpret_cast <const __m128i*> (p)); };
+        const auto select = [] (const __m128i mask, const __m128i a, const __m128i b) { return _mm_or_si128 (_mm_and_si128 (mask, a), _mm_andnot_si128 (mask, b)); };
+
+        const __m128i B = load (up + x + 1);
+        const __m128i D = load (center + x);
+        const __m128i E = load (center + x + 1);
+        const __m128i F = load (center + x + 2);
+        const __m128i H = load (down + x + 1);
+
+        const __m128i ones = _mm_set1_epi8 (-1);
+        const __m128i DB = _mm_cmpeq_epi8 (D, B);
+        const __m128i BF = _mm_cmpeq_epi8 (B, F);
+        const __m128i DH = _mm_cmpeq_epi8 (D, H);
+        const __m128i HF = _mm_cmpeq_epi8 (H, F);
+
+        // B != F && D != H, shared by all four rules
+        const __m128i edge = _mm_andnot_si128 (_mm_or_si128 (BF, DH), ones);
+        const __m128i cross = _mm_andnot_si128 (_mm_or_si128 (DB, HF), ones);
+
+        const __m128i E0 = select (_mm_and_si128 (DB, edge), D, E);
+        const __m128i E1 = select (_mm_and_si128 (BF, cross), F, E);
+        const __m128i E2 = select (_mm_and_si128 (DH, cross), D, E);
+        const __m128i E3 = select (_mm_and_si128 (HF, edge), F, E);
+
+        _mm_storeu_si128 (reinterpret_cast <__m128i*> (top + x * 2),         _mm_unpacklo_epi8 (E0, E1));
+        _mm_storeu_si128 (reinterpret_cast <__m128i*> (top + x * 2 + 16),    _mm_unpackhi_epi8 (E0, E1));
+        _mm_storeu_si128 (reinterpret_cast <__m128i*> (bottom + x * 2),      _mm_unpacklo_epi8 (E2, E3));
+        _mm_storeu_si128 (reinterpret_cast <__m128i*> (bottom + x * 2 + 16), _mm_unpackhi_epi8 (E2, E3));
+    }
+#else
+    for (int x = 0; x < screen_width; ++x)
+    {
+        const u8 B = up[x + 1], D = center[x], E = center[x + 1], F = center[x + 2], H = down[x + 1];
+
+        top[x * 2]        = D == B && B != F && D != H ? D : E;
+        top[x * 2 + 1]    = B == F && B != D && F != H ? F : E;
+        bottom[x * 2]     = D == H && D != B && H != F ? D : E;
+        bottom[x * 2 + 1] = H == F && D != H && B != F ? F : E;
+    }
+#endif
+
+    u8* out = reinterpret_cast <u8*> (dst) + pitch * y * 2;
+    palette.convert_row (top,    reinterpret_cast <u32*> (out),         width, frame->emphasis[y]);
+    palette.convert_row (bottom, reinterpret_cast <u32*> (out + pitch), width, frame->emphasis[y]);
+}
+
+/*
+    Scale3x
+
+    A B C        E0 E1 E2
+    D E F   ->   E3 E4 E5
+    G H I        E6 E7 E8
+*/
+void PPU::Video_Filter::scale_3x (const int y, Scratch& s)
+{
+    u8* up     = s.indices.data();
+    u8* center = up + screen_width + 2;
+    u8* down   = center + screen_width + 2;
+    u8* rows[3];
+    rows[0] = down + screen_width + 2;
+    rows[1] = rows[0] + screen_width * 3;
+    rows[2] = rows[1] + screen_width * 3;
+
+    pad_row (frame->get_row (std::max (y - 1, 0)), up);
+    pad_row (frame->get_row (y), center);
+    pad_row (frame->get_row (std::min (y + 1, screen_height - 1)), down);
+
+    for (int x = 0; x < screen_width; ++x)
+    {
+        const u8 A = up[x],     B = up[x + 1],     C = up[x + 2];
+        const u8 D = center[x], E = center[x + 1], F = center[x + 2];
+        const u8 G = down[x],   H = down[x + 1],   I = down[x + 2];
+
+        const bool edge  = B != H && D != F;
+        const bool DB = edge && D == B;
+        const bool BF = edge && B == F;
+        const bool DH = edge && D == H;
+        const bool HF = edge && H == F;
+
+        u8* r0 = rows[0] + x * 3;
+        u8* r1 = rows[1] + x * 3;
+        u8* r2 = rows[2] + x * 3;
+
+        r0[0] = DB ? D : E;
+        r0[1] = (DB && E != C) || (BF && E != A) ? B : E;
+        r0[2] = BF ? F : E;
+        r1[0] = (DB && E != G) || (DH && E != A) ? D : E;
+        r1[1] = E;
+        r1[2] = (BF && E != I) || (HF && E != C) ? F : E;
+        r2[0] = DH ? D : E;
+        r2[1] = (DH && E != I) || (HF && E != G) ? H : E;
+        r2[2] = HF ? F : E;
+    }
+
+    u8* out = reinterpret_cast <u8*> (dst) + pitch * y * 3;
+    for (int i = 0; i < 3; ++i)
+        palette.convert_row (rows[i], reinterpret_cast <u32*> (out + pitch * i), width, frame->emphasis[y]);
+}
+
+void PPU::Video_Filter::ntsc (const int y, Scratch& s)
+{
+    constexpr int sample_n = screen_width * samples_per_dot + ntsc_window;
+    constexpr int half = ntsc_window / 2;
+    constexpr int step = screen_width * samples_per_dot / ntsc_width;
+
+    const NTSC_Tables& tables = ntsc_tables ();
+    const auto& signal_table = tables.signal[frame->emphasis[y] & 0x07];
+    const u8* row = frame->get_row (y);
+
+    // phase of signal[0], the padding in front starts half a window early
+    const int line_phase = ((frame_n & 1) * 4 + y * 4 + ntsc_window - half) % ntsc_window;
+
+    float* signal = s.signal.data();
+    float* y_sum  = signal + sample_n;
+    float* i_sum  = y_sum + sample_n + 1;
+    float* q_sum  = i_sum + sample_n + 1;
+
+    // encode, half a window of blank signal on both sides
+    std::fill_n (signal, half, 0.f);
+    std::fill_n (signal + sample_n - half, half, 0.f);
+
+    int phase = (line_phase + half) % ntsc_window;
+    for (int x = 0; x < screen_width; ++x)
+    {
+        const auto& levels = signal_table[row[x] & 0x3F];
+        float* dot = signal + half + x * samples_per_dot;
+
+        for (int i = 0; i < samples_per_dot; ++i)
+        {
+            dot[i] = levels[phase];
+            phase = phase == ntsc_window - 1 ? 0 : phase + 1;
+        }
+    }
+
+    /*
+        decode, YIQ averaged over one subcarrier period centered on every output
+        pixel. running sums turn each window into two lookups
+    */
+    y_sum[0] = i_sum[0] = q_sum[0] = 0.f;
+    phase = line_phase;
+    for (int p = 0; p < sample_n; ++p)
+    {
+        y_sum[p + 1] = y_sum[p] + signal[p];
+        i_sum[p + 1] = i_sum[p] + signal[p] * tables.cos_phase[phase];
+        q_sum[p + 1] = q_sum[p] + signal[p] * tables.sin_phase[phase];
+        phase = phase == ntsc_window - 1 ? 0 : phase + 1;
+    }
+
+    u8* out = reinterpret_cast <u8*> (dst) + pitch * y;
+
+    for (int x = 0; x < ntsc_width; ++x)
+    {
+        // window [center - half, center + half) in unpadded samples is [center, center + 12) here
+        const int begin = x * step + step / 2;
+        const int end = begin + ntsc_window;
+
+        const float Y = (y_sum[end] - y_sum[begin]) / ntsc_window;
+        const float I = (i_sum[end] - i_sum[begin]) / ntsc_window;
+        const float Q = (q_sum[end] - q_sum[begin]) / ntsc_window;
+
+        const u8 rgba[4]
+        {
+            to_display (tables, Y + 0.946882f * I + 0.623557f * Q),
+            to_display (tables, Y - 0.274788f * I - 0.635691f * Q),
+            to_display (tables, Y - 1.108545f * I + 1.709007f * Q),
+            0xFF,
+        };
+        std::memcpy (out + x * sizeof(u32), rgba, sizeof(rgba));
+    }
+}
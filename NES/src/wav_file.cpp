@@ -0,0 +1,115 @@
+#include "wav_file.h"
+#include <array>
+#include <bit>
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::size_t header_size = 44;
+
+    void put_u16 (u8* dst, const u16 value)
+    {
+        dst[0] = value & 0xFF;
+        dst[1] = value >> 8;
+    }
+
+    void put_u32 (u8* dst, const u32 value)
+    {
+        dst[0] = value & 0xFF;
+        dst[1] = (value >> 8) & 0xFF;
+        dst[2] = (value >> 16) & 0xFF;
+        dst[3] = value >> 24;
+    }
+}
+
+APU::Wav_File::Wav_File (const std::string& _path, const int _sample_rate, const int _channels, const Format _format)
+: file {_path, std::ios::binary | std::ios::trunc}
+, path {_path}
+, sample_rate {_sample_rate}
+, channels {_channels}
+, format {_format}
+, samples_written {0}
+{
+    if (!file.is_open())
+        throw std::runtime_error ("wav: could not create " + path);
+
+    // placeholder sizes, close () writes the real ones
+    if (format == Format::WAV)
+        write_header ();
+}
+
+APU::Wav_File::~Wav_File ()
+{
+    if (!file.is_open())
+        return;
+
+    try
+    {
+        close ();
+    }
+    catch (const std::exception&)
+    {
+        // nothing sensible to do about it in a destructor
+    }
+}
+
+void APU::Wav_File::write (std::span <const i16> samples)
+{
+    if constexpr (std::endian::native == std::endian::little)
+        file.write (reinterpret_cast <const char*> (samples.data()), static_cast <std::streamsize> (samples.size_bytes()));
+    else
+    {
+        for (const i16 sample : samples)
+        {
+            const u16 bits = std::byteswap (static_cast <u16> (sample));
+            file.write (reinterpret_cast <const char*> (&bits), sizeof(bits));
+        }
+    }
+
+    samples_written += samples.size();
+}
+
+void APU::Wav_File::close ()
+{
+    if (format == Format::WAV)
+    {
+        file.seekp (0);
+        write_header ();
+    }
+
+    file.close ();
+
+    if (file.fail())
+        throw std::runtime_error ("wav: write to " + path + " failed");
+}
+
+u64 APU::Wav_File::get_samples_written () const
+{
+    return samples_written;
+}
+
+bool APU::Wav_File::good () const
+{
+    return !file.fail();
+}
+
+void APU::Wav_File::write_header ()
+{
+    const u32 data_size   = static_cast <u32> (samples_written * sizeof(i16));
+    const u16 block_align = static_cast <u16> (channels * sizeof(i16));
+
+    std::array <u8, header_size> header {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' '};
+
+    put_u32 (&header[4],  static_cast <u32> (header_size - 8 + data_size));
+    put_u32 (&header[16], 16);         // fmt chunk size
+    put_u16 (&header[20], 1);          // pcm
+    put_u16 (&header[22], static_cast <u16> (channels));
+    put_u32 (&header[24], static_cast <u32> (sample_rate));
+    put_u32 (&header[28], static_cast <u32> (sample_rate) * block_align);
+    put_u16 (&header[32], block_align);
+    put_u16 (&header[34], 16);         // bits per sample
+    header[36] = 'd'; header[37] = 'a'; header[38] = 't'; header[39] = 'a';
+    put_u32 (&header[40], data_size);
+
+    file.write (reinterpret_cast <const char*> (header.data()), header.size());
+}
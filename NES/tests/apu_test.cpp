@@ -0,0 +1,67 @@
+#include "apu.h"
+#include "check.h"
+
+/*
+
+APU::RP2A03::get_next_irq against what the channels actually do. with the frame
+counter's interrupt inhibited the only source left is the dmc, the reported
+cycle has to be the first one irq_pending () sees it at.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    APU::RP2A03 playing (const u8 rate, const u8 length, const u64 start)
+    {
+        APU::RP2A03 apu;
+        apu.reset ();
+        apu.write (0x4017, 0x40, start);
+        apu.write (0x4010, static_cast <u8> (0x80 | rate), start + 3);
+        apu.write (0x4013, length, start + 5);
+        apu.write (0x4015, 0x10, start + 7 + rate);
+        return apu;
+    }
+
+    void dmc_end_of_sample ()
+    {
+        for (const u8 rate : {0, 7, 15})
+            for (const u8 length : {1, 5})
+                for (const u64 start : {0, 13, 1001})
+                {
+                    APU::RP2A03 apu = playing (rate, length, start);
+                    const u64 when = apu.get_next_irq ();
+
+                    check (when != ~u64 {0}, "a sample with its irq enabled reports when it ends");
+
+                    APU::RP2A03 early = apu;
+                    check (!early.irq_pending (when - 1), "the dmc irq isn't raised before the reported cycle");
+                    check (apu.irq_pending (when), "the dmc irq is raised at the reported cycle");
+                }
+    }
+
+    void dmc_one_byte ()
+    {
+        // a 1 byte sample is fetched by the $4015 write itself
+        APU::RP2A03 apu = playing (0, 0, 0);
+        check (apu.get_next_irq () == ~u64 {0}, "nothing is left to report once the last byte is fetched");
+        check (apu.irq_pending (8), "the irq of a 1 byte sample is raised at once");
+    }
+
+    void dmc_loop ()
+    {
+        APU::RP2A03 apu = playing (15, 1, 0);
+        apu.write (0x4010, 0xC0 | 15, 20);
+        check (apu.get_next_irq () == ~u64 {0}, "a looping sample never ends");
+    }
+}
+
+int main ()
+{
+    dmc_end_of_sample ();
+    dmc_one_byte ();
+    dmc_loop ();
+
+    return Test::report ("apu");
+}
@@ -0,0 +1,200 @@
+#include "cheat.h"
+#include "mapper.h"
+#include "check.h"
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+
+Cheat::decode and the mapper's rom overlays. Game Genie codes are checked
+against a published one and against an encoder that puts every field bit
+back in its letter, Pro Action Replay codes are plain hex. on the mapper side
+a compare code may only show while the bank it was made for is switched in,
+the rest of its page has to read as rom and the rom itself stays untouched.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    constexpr std::string_view genie_letters = "APZLGITYEOXUKSVN";
+
+    // the letter layout from the nesdev wiki, the inverse of what decode () reads
+    std::string encode_genie (const Cheat::Code& code)
+    {
+        const int a = code.address, v = code.value, c = code.compare;
+        const bool long_code = code.has_compare;
+
+        const int n[8]
+        {
+            (v & 7) | ((v >> 4) & 8),
+            ((v >> 4) & 7) | ((a >> 4) & 8),
+            ((a >> 4) & 7) | (long_code ? 8 : 0),
+            ((a >> 12) & 7) | (a & 8),
+            (a & 7) | ((a >> 8) & 8),
+            ((a >> 8) & 7) | ((long_code ? c : v) & 8),
+            (c & 7) | ((c >> 4) & 8),
+            ((c >> 4) & 7) | (v & 8),
+        };
+
+        std::string text;
+        for (int i = 0; i < (long_code ? 8 : 6); ++i)
+            text += genie_letters[n[i]];
+        return text;
+    }
+
+    bool same (const Cheat::Code& a, const Cheat::Code& b)
+    {
+        return a.address == b.address && a.value == b.value && a.has_compare == b.has_compare && (!a.has_compare || a.compare == b.compare);
+    }
+
+    bool throws (const std::string_view text)
+    {
+        try
+        {
+            Cheat::decode (text);
+        }
+        catch (const std::runtime_error&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    void decoding ()
+    {
+        // Super Mario Bros., infinite lives: DEC $075A becomes LDA $075A
+        check (same (Cheat::decode ("SXIOPO"), {0x91D9, 0xAD, false, 0}), "SXIOPO is $91D9 = $AD");
+        check (same (Cheat::decode ("sxio-po"), {0x91D9, 0xAD, false, 0}), "lower case and groups decode the same");
+
+        check (same (Cheat::decode ("075A09"), {0x075A, 0x09, false, 0}), "Pro Action Replay is address then value");
+        check (same (Cheat::decode ("07 5a 09"), {0x075A, 0x09, false, 0}), "Pro Action Replay with spaces");
+
+        // every code made of genie letters is read as one, even when it is also hex
+        check (same (Cheat::decode ("AAAAAA"), {0x8000, 0x00, false, 0}), "AAAAAA is a Game Genie code");
+
+        check (throws (""), "nothing is no code");
+        check (throws ("SXIOP"), "5 letters is no code");
+        check (throws ("SXIOPOA"), "7 letters is no code");
+        check (throws ("SXIOPOQ1"), "letters outside the genie set and hex");
+        check (throws ("07G5A0"), "6 characters of neither kind");
+
+        std::mt19937 random {1};
+        bool round_trip = true;
+        for (int i = 0; i < 2000; ++i)
+        {
+            const bool long_code = i & 1;
+            const Cheat::Code code {static_cast <u16> (0x8000 | (random () & 0x7FFF)), static_cast <u8> (random ()), long_code, static_cast <u8> (long_code ? random () : 0)};
+            round_trip &= same (Cheat::decode (encode_genie (code)), code);
+        }
+        check (round_trip, "every address, value and compare bit comes back from its letter");
+    }
+
+    // every byte is its bank number in the high nibble and its offset in the low one,
+    // so any two banks differ at every address
+    std::vector <u8> make_prg (const int banks_8k)
+    {
+        std::vector <u8> prg (static_cast <std::size_t> (banks_8k) * Mapper::prg_window);
+        for (std::size_t i = 0; i < prg.size (); ++i)
+            prg[i] = static_cast <u8> (((i / Mapper::prg_window) << 4) | (i & 0x0F));
+        return prg;
+    }
+
+    u8 rom_byte (const std::vector <u8>& prg, const int bank_8k, const u16 address)
+    {
+        return prg[static_cast <std::size_t> (bank_8k) * Mapper::prg_window + (address & (Mapper::prg_window - 1))];
+    }
+
+    void uxrom_overlays ()
+    {
+        // 8 x 16 KB, $8000 switches, $C000 is the last bank (8 KB banks 14 and 15)
+        const std::vector <u8> prg = make_prg (16);
+        const std::vector <u8> original = prg;
+        std::vector <u8> chr (0x2000);
+        Mapper_002 mapper {prg, {}, chr, Mapper::Mirroring::VERTICAL};
+
+        const std::vector <Cheat::Code> codes
+        {
+            {0x8123, 0xA5, true,  rom_byte (prg, 6, 0x8123)}, // only in bank 3 (8 KB bank 6)
+            {0x8124, 0x5A, false, 0},                        // always
+            {0xC010, 0x77, false, 0},                        // the fixed bank
+            {0x9F00, 0x11, true,  0xEE},                     // no bank has it, never shows
+        };
+        mapper.set_rom_patches (codes);
+
+        bool switched = true;
+        for (const int bank : {0, 3, 5, 3, 7, 0})
+        {
+            mapper.cpu_write (0x8000, static_cast <u8> (bank));
+
+            const u8 compared = bank == 3 ? 0xA5 : rom_byte (prg, bank * 2, 0x8123);
+            switched &= mapper.cpu_read (0x8123) == compared;
+            switched &= mapper.cpu_read (0x8124) == 0x5A;
+            switched &= mapper.cpu_read (0x8122) == rom_byte (prg, bank * 2, 0x8122);
+            switched &= mapper.cpu_read (0x81FF) == rom_byte (prg, bank * 2, 0x81FF);
+            switched &= mapper.cpu_read (0x9F00) == rom_byte (prg, bank * 2, 0x9F00);
+            switched &= mapper.cpu_read (0xC010) == 0x77;
+        }
+
+        check (switched, "a compare code only shows while its bank is switched in, the rest of the page is rom");
+        check (prg == original, "patching never writes the rom");
+
+        mapper.set_rom_patches ({});
+        mapper.cpu_write (0x8000, 3);
+        check (mapper.cpu_read (0x8123) == rom_byte (prg, 6, 0x8123) && mapper.cpu_read (0xC010) == rom_byte (prg, 14, 0xC010), "no codes reads rom again");
+    }
+
+    void mmc3_overlays ()
+    {
+        // 16 x 8 KB, R6 moves between $8000 and $C000 with the prg mode
+        const std::vector <u8> prg = make_prg (16);
+        std::vector <u8> chr (0x2000);
+        Mapper_004 mapper {prg, {}, chr, Mapper::Mirroring::VERTICAL};
+
+        const std::vector <Cheat::Code> codes
+        {
+            {0xA050, 0x42, true, rom_byte (prg, 9, 0xA050)},  // R7 = 9
+            {0xC050, 0x24, true, rom_byte (prg, 4, 0xC050)},  // R6 = 4 in prg mode 1
+        };
+        mapper.set_rom_patches (codes);
+
+        const auto select = [&mapper] (const u8 reg, const u8 bank, const bool mode)
+        {
+            mapper.cpu_write (0x8000, static_cast <u8> (reg | (mode ? 0x40 : 0)));
+            mapper.cpu_write (0x8001, bank);
+        };
+
+        bool switched = true;
+        for (const int step : {0, 1, 2, 3, 4, 5})
+        {
+            const u8 r7 = step % 2 ? 9 : static_cast <u8> (step + 2);
+            const u8 r6 = step < 3 ? 4 : 8;
+            const bool mode = step % 3 != 0;
+
+            select (7, r7, mode);
+            select (6, r6, mode);
+
+            switched &= mapper.cpu_read (0xA050) == (r7 == 9 ? 0x42 : rom_byte (prg, r7, 0xA050));
+
+            // in mode 1 $C000 is R6, in mode 0 the second last bank
+            const int c000 = mode ? r6 : 14;
+            switched &= mapper.cpu_read (0xC050) == (c000 == 4 ? 0x24 : rom_byte (prg, c000, 0xC050));
+            switched &= mapper.cpu_read (0xC051) == rom_byte (prg, c000, 0xC051);
+        }
+
+        check (switched, "compare codes follow MMC3 bank and prg mode switches");
+    }
+}
+
+int main ()
+{
+    decoding ();
+    uxrom_overlays ();
+    mmc3_overlays ();
+
+    return Test::report ("cheat");
+}
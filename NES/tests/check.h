@@ -0,0 +1,38 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <cstdio>
+
+/*
+
+the harness every test in NES/tests shares
+
+check () prints and counts a condition that didn't hold, report () is what main
+returns. ctest only looks at the exit code, the output is for whoever reads
+the log.
+
+*/
+
+namespace Test
+{
+    inline int failures = 0;
+
+    inline void check (const bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::fprintf (stderr, "failed: %s\n", what);
+            ++failures;
+        }
+    }
+
+    inline int report (const char* name)
+    {
+        if (failures == 0)
+            std::printf ("%s: ok\n", name);
+
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+#endif
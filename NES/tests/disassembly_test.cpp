@@ -0,0 +1,119 @@
+#include "disassembly.h"
+#include "check.h"
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+
+Disassembly's incremental updates against a full sweep. random prg gets random
+small edits (and random code maps), after each one the index that was updated
+through invalidate () / set_code_map () has to match a Disassembly built from
+scratch over the same bytes, line for line and text for text.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    bool same (const Disassembly& updated, const Disassembly& fresh)
+    {
+        if (updated.size () != fresh.size ())
+            return false;
+
+        for (std::size_t line = 0; line < fresh.size (); ++line)
+        {
+            if (updated.get_offset (line) != fresh.get_offset (line) || updated.get_text (line) != fresh.get_text (line))
+                return false;
+        }
+
+        return true;
+    }
+
+    void lengths ()
+    {
+        // JMP abs, BIT abs, CPY abs, CPX abs, JMP ind, NOP
+        const std::vector <u8> prg {0x4C, 0x00, 0x80, 0x2C, 0x00, 0x20, 0xCC, 0x01, 0x00, 0xEC, 0x02, 0x00, 0x6C, 0xFC, 0xFF, 0xEA};
+        const Disassembly disassembly {prg};
+
+        check (disassembly.size () == 6, "3 byte instructions are swept as 3 bytes");
+        check (disassembly.get_offset (5) == 15, "the sweep stays in step after them");
+        check (disassembly.get_text (0) == "8000: 4C 00 80  JMP $8000", "JMP abs prints its operand");
+    }
+
+    void edits (const std::size_t size, const u32 seed)
+    {
+        std::mt19937 random {seed};
+        std::vector <u8> prg (size);
+        for (auto& byte : prg)
+            byte = static_cast <u8> (random ());
+
+        Disassembly updated {prg};
+        bool ok = same (updated, Disassembly {prg});
+
+        for (int edit = 0; edit < 500 && ok; ++edit)
+        {
+            const std::size_t begin = random () % size;
+            const std::size_t end = std::min (size, begin + 1 + random () % 4);
+
+            for (std::size_t i = begin; i < end; ++i)
+                prg[i] = static_cast <u8> (random ());
+
+            updated.invalidate (begin, end);
+            ok = same (updated, Disassembly {prg});
+        }
+
+        check (ok, "invalidate () matches a full sweep after every edit");
+    }
+
+    void code_maps (const std::size_t size, const u32 seed)
+    {
+        std::mt19937 random {seed};
+        std::vector <u8> prg (size);
+        for (auto& byte : prg)
+            byte = static_cast <u8> (random ());
+
+        Flow_Analyzer::Marks marks (size, Flow_Analyzer::OPCODE);
+        Disassembly updated {prg};
+        bool ok = true;
+
+        for (int change = 0; change < 100 && ok; ++change)
+        {
+            // a few runs of bytes flip between code and data
+            for (int run = 0; run < 4; ++run)
+            {
+                const std::size_t begin = random () % size;
+                const std::size_t end = std::min (size, begin + 1 + random () % 64);
+                const u8 mark = static_cast <u8> (random () % 3);
+
+                for (std::size_t i = begin; i < end; ++i)
+                    marks[i] = mark;
+            }
+
+            const auto shared = std::make_shared <const Flow_Analyzer::Marks> (marks);
+            updated.set_code_map (shared);
+
+            Disassembly fresh {prg};
+            fresh.set_code_map (shared);
+            ok = same (updated, fresh);
+        }
+
+        check (ok, "set_code_map () matches a full sweep after every change");
+    }
+}
+
+int main ()
+{
+    lengths ();
+
+    // one fits $8000 - $FFFF, the other is labelled by offset
+    edits (0x4000, 1);
+    edits (0x9000, 2);
+    code_maps (0x4000, 3);
+    code_maps (0x9000, 4);
+
+    return Test::report ("disassembly");
+}
@@ -0,0 +1,104 @@
+#include "hash.h"
+#include "check.h"
+#include <random>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+
+/*
+
+Hash::crc32 and Hash::sha1 against published vectors, plus crc32 against
+zlib's over random lengths, alignments and chained splits so the 64 byte
+folding and its tail both get covered. which paths run depends on the build:
+the default target has the table / round loop versions, NATIVE_ARCH on a cpu
+with PCLMULQDQ and the SHA extensions has the others, the expected values are
+the same for both.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    std::span <const u8> bytes (const std::string_view text)
+    {
+        return {reinterpret_cast <const u8*> (text.data ()), text.size ()};
+    }
+
+    // the sha1 inputs around the padding boundaries are (i * 7 + 3) & 0xFF
+    std::vector <u8> pattern (const std::size_t n)
+    {
+        std::vector <u8> data (n);
+        for (std::size_t i = 0; i < n; ++i)
+            data[i] = static_cast <u8> (i * 7 + 3);
+        return data;
+    }
+
+    void crc32_vectors ()
+    {
+        check (Hash::crc32 ({}) == 0, "crc32 of nothing is 0");
+        check (Hash::crc32 (bytes ("123456789")) == 0xCBF43926, "crc32 check value");
+        check (Hash::crc32 (bytes ("The quick brown fox jumps over the lazy dog")) == 0x414FA339, "crc32 of the quick brown fox");
+        check (Hash::crc32 (pattern (1000)) == 0x17BC2A46, "crc32 of 1000 pattern bytes");
+    }
+
+    void crc32_zlib (const u32 seed)
+    {
+        std::mt19937 random {seed};
+        std::vector <u8> data (70000);
+        for (auto& byte : data)
+            byte = static_cast <u8> (random ());
+
+        bool same = true;
+        for (int i = 0; i < 300; ++i)
+        {
+            // odd starts and every length class, from nothing to past a few folds
+            const std::size_t offset = random () % 64;
+            const std::size_t size = i < 200 ? static_cast <std::size_t> (i) : random () % (data.size () - offset);
+            const std::span <const u8> span {data.data () + offset, size};
+
+            const u32 expected = static_cast <u32> (::crc32 (0, span.data (), static_cast <uInt> (span.size ())));
+            same &= Hash::crc32 (span) == expected;
+
+            const std::size_t split = size ? random () % size : 0;
+            same &= Hash::crc32 (span.subspan (split), Hash::crc32 (span.first (split))) == expected;
+        }
+        check (same, "crc32 matches zlib, whole and chained");
+    }
+
+    void sha1_vectors ()
+    {
+        check (Hash::to_hex (Hash::sha1 ({})) == "da39a3ee5e6b4b0d3255bfef95601890afd80709", "sha1 of nothing");
+        check (Hash::to_hex (Hash::sha1 (bytes ("abc"))) == "a9993e364706816aba3e25717850c26c9cd0d89d", "sha1 of abc");
+        check (Hash::to_hex (Hash::sha1 (bytes ("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"))) == "84983e441c3bd26ebaae4aa1f95129e5e54670f1", "sha1 of the two block vector");
+        check (Hash::to_hex (Hash::sha1 (std::vector <u8> (1000000, 'a'))) == "34aa973cd4c4daa4f61eeb2bdbad27316534016f", "sha1 of a million a");
+
+        // one byte short of the length fitting, exactly fitting, and whole blocks either side
+        const std::pair <std::size_t, std::string_view> padding[]
+        {
+            {55,   "ddf57317ef34bfee3b6df83d359098930eb278bc"},
+            {56,   "a0d492bb0fc889d0eca3bc137066ab6f4f74f369"},
+            {63,   "c55856749bef509bdfe6bfebfc7bf4e793e82132"},
+            {64,   "bede92be29c3874e1b54ddc77988d606fc857a8e"},
+            {65,   "b05a80522b053d6dc7e0a517d0e70212c7dad11f"},
+            {119,  "504e27376a6e0f0dba8295b85cb25dc4dfa17d23"},
+            {1000, "4231a8a50a10fa9758db8ec71fdef855b751048a"},
+        };
+
+        bool same = true;
+        for (const auto& [size, digest] : padding)
+            same &= Hash::to_hex (Hash::sha1 (pattern (size))) == digest;
+        check (same, "sha1 around the padding boundaries");
+    }
+}
+
+int main ()
+{
+    crc32_vectors ();
+    crc32_zlib (1);
+    sha1_vectors ();
+
+    return Test::report ("hash");
+}
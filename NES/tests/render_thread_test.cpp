@@ -0,0 +1,200 @@
+#include "render_thread.h"
+#include "spsc_ring.h"
+#include "check.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <span>
+#include <thread>
+#include <vector>
+
+/*
+
+SPSC_Ring and Render_Thread with a real second thread. the ring is small so
+both sides keep running into full and empty, every way in (push, span push,
+acquire / commit) is mixed with every way out and the values have to come out
+in order. the render thread gets more than a ring's worth of log per frame and
+a replay that stalls now and then, sync () and end_frame () have to hold the
+cpu side back exactly as far as they promise.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    void ring ()
+    {
+        static constexpr u64 count = 1'000'000;
+        SPSC_Ring <u64, 64> ring;
+
+        std::thread producer {[&ring]
+        {
+            u64 next = 0;
+            while (next < count)
+            {
+                const u64 before = next;
+
+                switch (next % 3)
+                {
+                    case 0:
+                        if (ring.push (next))
+                            ++next;
+                        break;
+
+                    case 1:
+                    {
+                        std::array <u64, 7> values;
+                        for (std::size_t i = 0; i < values.size(); ++i)
+                            values[i] = next + i;
+                        next += ring.push (std::span <const u64> {values.data(), std::min <std::size_t> (values.size(), count - next)});
+                        break;
+                    }
+
+                    default:
+                        if (u64* slot = ring.acquire ())
+                        {
+                            *slot = next++;
+                            ring.commit ();
+                        }
+                        break;
+                }
+
+                // full, let the consumer have the core
+                if (next == before)
+                    std::this_thread::yield ();
+            }
+        }};
+
+        u64 expected = 0;
+        bool in_order = true;
+        while (expected < count)
+        {
+            const u64 before = expected;
+
+            switch (expected % 3)
+            {
+                case 0:
+                {
+                    u64 value;
+                    if (ring.pop (value))
+                        in_order &= value == expected++;
+                    break;
+                }
+
+                case 1:
+                {
+                    std::array <u64, 5> values;
+                    const std::size_t n = ring.pop (values);
+                    for (std::size_t i = 0; i < n; ++i)
+                        in_order &= values[i] == expected++;
+                    break;
+                }
+
+                default:
+                    if (const u64* slot = ring.front ())
+                    {
+                        in_order &= *slot == expected++;
+                        ring.release ();
+                    }
+                    break;
+            }
+
+            if (expected == before)
+                std::this_thread::yield ();
+        }
+
+        producer.join ();
+
+        check (in_order, "every value comes out once and in order");
+        check (ring.size () == 0, "the ring is empty once everything was popped");
+    }
+
+    void render_thread (const int max_frames_behind)
+    {
+        static constexpr int frames = 40;
+
+        // the worker writes these, the test only looks after sync () / end_frame ()
+        std::vector <PPU::Log_Entry> replayed;
+        std::atomic <u64> replayed_count {0};
+        std::thread::id replayed_on {};
+
+        PPU::Render_Thread thread {[&] (const PPU::Log_Entry& entry)
+        {
+            replayed.push_back (entry);
+            replayed_on = std::this_thread::get_id ();
+
+            // stall now and then so the ring fills up and end_frame () has to wait
+            if (replayed.size () % 20011 == 0)
+                std::this_thread::sleep_for (std::chrono::microseconds {200});
+
+            replayed_count.fetch_add (1, std::memory_order_relaxed);
+        }, max_frames_behind};
+
+        u64 cycle = 0;
+        u64 logged = 0;
+        bool held_back = true;
+        bool synced = true;
+
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            // the first frames log more than the ring holds
+            const u64 writes = frame < 4 ? PPU::Render_Thread::log_size * 3 / 2 : 3000 + frame * 101;
+
+            for (u64 i = 0; i < writes; ++i)
+                thread.log ({cycle++, static_cast <u16> (i & 0x3FFF), static_cast <u8> (i), PPU::Log_Entry::Target::VRAM});
+
+            thread.end_frame (cycle++);
+            logged += writes + 1;
+
+            held_back &= static_cast <u64> (frame + 1) - thread.get_frames_rendered () <= static_cast <u64> (max_frames_behind);
+
+            if (frame % 8 == 7)
+            {
+                thread.sync ();
+                synced &= replayed_count.load (std::memory_order_relaxed) == logged;
+                synced &= thread.get_frames_rendered () == static_cast <u64> (frame + 1);
+            }
+        }
+
+        thread.sync ();
+
+        check (held_back, "end_frame () keeps the cpu within max_frames_behind frames");
+        check (synced, "sync () returns once everything logged was replayed");
+        check (replayed.size () == logged, "every entry is replayed once");
+        check (replayed_on != std::this_thread::get_id (), "entries are replayed on the render thread");
+
+        bool in_order = true;
+        for (std::size_t i = 0; i < replayed.size (); ++i)
+            in_order &= replayed[i].cycle == i;
+        check (in_order, "entries are replayed in the order they were logged");
+
+        // synchronous mode replays right away on the calling thread
+        thread.set_synchronous (true);
+        thread.log ({cycle++, 0x2000, 0x80, PPU::Log_Entry::Target::REGISTER});
+        check (replayed.size () == logged + 1, "a synchronous log is replayed before it returns");
+        check (replayed_on == std::this_thread::get_id (), "a synchronous log is replayed on the calling thread");
+
+        thread.end_frame (cycle++);
+        check (thread.get_frames_rendered () == frames + 1, "a synchronous frame counts as rendered right away");
+
+        // and back, the worker picks up where it left off
+        thread.set_synchronous (false);
+        for (int i = 0; i < 1000; ++i)
+            thread.log ({cycle++, 0, 0, PPU::Log_Entry::Target::OAM});
+        thread.end_frame (cycle++);
+        thread.sync ();
+
+        check (replayed.size () == logged + 1003, "the worker replays again after synchronous mode");
+        check (thread.get_frames_rendered () == frames + 2, "and counts its frames on from there");
+    }
+}
+
+int main ()
+{
+    ring ();
+    render_thread (1);
+    render_thread (3);
+
+    return Test::report ("render_thread");
+}
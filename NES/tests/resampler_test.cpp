@@ -0,0 +1,150 @@
+#include "resampler.h"
+#include "check.h"
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+/*
+
+APU::Resampler::process at its block boundaries. a stream cut into random
+blocks has to come out sample for sample like the same stream in one block,
+with exactly as many outputs as there are kernel positions inside the input.
+a constant input has to come out at the same level (unity dc gain), also
+while set_rates () nudges the output rate the way the debugger's rate
+control does.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    std::vector <i16> run (APU::Resampler& resampler, const std::vector <i16>& in, const std::vector <std::size_t>& blocks, bool& bounded)
+    {
+        std::vector <i16> out;
+        std::size_t at = 0;
+
+        for (const std::size_t n : blocks)
+        {
+            std::vector <i16> block (resampler.max_output (n));
+            const std::size_t m = resampler.process ({in.data() + at, n}, block);
+
+            bounded &= m < block.size ();
+            out.insert (out.end (), block.begin (), block.begin () + m);
+            at += n;
+        }
+        return out;
+    }
+
+    void blocks (const int input_rate, const int output_rate, const u32 seed)
+    {
+        std::mt19937 random {seed};
+
+        std::vector <i16> in (20000);
+        for (auto& sample : in)
+            sample = static_cast <i16> (static_cast <int> (random () % 20001) - 10000);
+
+        std::vector <std::size_t> cuts;
+        for (std::size_t left = in.size (); left;)
+        {
+            const std::size_t n = std::min <std::size_t> (left, random () % 1200);
+            cuts.push_back (n);
+            left -= n;
+        }
+
+        bool bounded = true;
+        APU::Resampler whole {input_rate, output_rate};
+        APU::Resampler cut {input_rate, output_rate};
+        const std::vector <i16> expected = run (whole, in, {in.size ()}, bounded);
+        const std::vector <i16> got = run (cut, in, cuts, bounded);
+
+        // output k reads taps inputs from floor (k * down / up) on, passthrough just copies
+        const int divisor = std::gcd (input_rate, output_rate);
+        const u64 up = static_cast <u64> (output_rate / divisor);
+        const u64 down = static_cast <u64> (input_rate / divisor);
+
+        u64 count = 0;
+        if (input_rate == output_rate)
+            count = in.size ();
+        else
+            while (count * down / up + APU::Resampler::taps <= in.size ())
+                ++count;
+
+        check (bounded, "process () stays below max_output ()");
+        check (expected.size () == count, "one output for every kernel position inside the input");
+        check (got == expected, "blocks of any size give the same samples as one block");
+    }
+
+    // every output after the kernel has filled up is the input level
+    bool flat (const std::vector <i16>& out, const i16 level)
+    {
+        return std::all_of (out.begin () + APU::Resampler::taps, out.end (), [level] (const i16 sample) { return std::abs (sample - level) <= 1; });
+    }
+
+    void dc_gain (const int input_rate, const int output_rate)
+    {
+        for (const i16 level : {i16 {12000}, i16 {-7000}})
+        {
+            APU::Resampler resampler {input_rate, output_rate};
+            const std::vector <i16> in (input_rate / 60, level);
+            std::vector <i16> out;
+
+            for (int frame = 0; frame < 30; ++frame)
+            {
+                std::vector <i16> block (resampler.max_output (in.size ()));
+                const std::size_t n = resampler.process (in, block);
+                out.insert (out.end (), block.begin (), block.begin () + n);
+            }
+
+            check (flat (out, level), "a constant comes out at the same level");
+        }
+    }
+
+    void rate_control (const int device_rate)
+    {
+        std::mt19937 random {static_cast <u32> (device_rate)};
+        APU::Resampler resampler {48000, device_rate};
+        const std::vector <i16> in (800, 9000);
+        std::vector <i16> out;
+        double expected = 0.0;
+
+        for (int frame = 0; frame < 120; ++frame)
+        {
+            // +-0.5% around the device rate
+            const int rate = device_rate + static_cast <int> (random () % (device_rate / 100 + 1)) - device_rate / 200;
+            resampler.set_rates (48000, rate);
+            expected += in.size () * rate / 48000.0;
+
+            std::vector <i16> block (resampler.max_output (in.size ()));
+            const std::size_t n = resampler.process (in, block);
+            out.insert (out.end (), block.begin (), block.begin () + n);
+        }
+
+        check (flat (out, 9000), "a constant keeps its level while the output rate moves");
+
+        // the kernel's length (in output samples) is all that's missing at the end
+        const double missing = expected - static_cast <double> (out.size ());
+        check (missing >= 0.0 && missing <= APU::Resampler::taps * device_rate / 48000.0 + 2.0, "the output follows the moving rate");
+    }
+}
+
+int main ()
+{
+    blocks (48000, 44100, 1);
+    blocks (48000, 96000, 2);
+    blocks (48000, 44123, 3);  // more phases than max_phases
+    blocks (32000, 48000, 4);
+    blocks (48000, 48000, 5);
+
+    dc_gain (48000, 44100);
+    dc_gain (48000, 96000);
+    dc_gain (48000, 44123);
+    dc_gain (48000, 48000);
+
+    rate_control (44100);
+    rate_control (48000);
+
+    return Test::report ("resampler");
+}
@@ -0,0 +1,136 @@
+#include "rom_stream.h"
+#include "check.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+
+ROM_Stream::decode with ips patches that change the rom's size. the source is
+a plain NROM-128 (16 KB prg, 8 KB chr), patches are built in memory.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    std::vector <u8> nrom_128 ()
+    {
+        std::vector <u8> file {'N', 'E', 'S', 0x1A, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        for (std::size_t i = 0; i < 16384 + 8192; ++i)
+            file.push_back (static_cast <u8> (i * 7));
+        return file;
+    }
+
+    struct IPS
+    {
+        std::vector <u8> bytes {'P', 'A', 'T', 'C', 'H'};
+
+        void offset (const u32 at)
+        {
+            bytes.push_back (static_cast <u8> (at >> 16));
+            bytes.push_back (static_cast <u8> (at >> 8));
+            bytes.push_back (static_cast <u8> (at));
+        }
+
+        void record (const u32 at, std::vector <u8> data)
+        {
+            offset (at);
+            bytes.push_back (static_cast <u8> (data.size() >> 8));
+            bytes.push_back (static_cast <u8> (data.size()));
+            bytes.insert (bytes.end(), data.begin(), data.end());
+        }
+
+        void fill (const u32 at, const u16 size, const u8 value)
+        {
+            offset (at);
+            bytes.insert (bytes.end(), {0, 0, static_cast <u8> (size >> 8), static_cast <u8> (size), value});
+        }
+
+        std::vector <u8> finish ()
+        {
+            bytes.insert (bytes.end(), {'E', 'O', 'F'});
+            return bytes;
+        }
+    };
+
+    // prg 16 -> 32 KB, the new upper half filled by the patch. chr moves up by 16 KB in the file
+    void grow_prg ()
+    {
+        const auto source = nrom_128 ();
+
+        IPS ips;
+        ips.record (4, {2});
+        ips.fill (16 + 16384, 16384, 0xEA);
+        ips.record (16 + 32768, {0x55});
+
+        const auto rom = ROM_Stream::decode (source, "grow_prg.nes", ips.finish ());
+
+        check (rom.prg.size() == 32768, "prg grew to 32 KB");
+        check (rom.prg[0] == source[16] && rom.prg[16383] == source[16 + 16383], "old prg kept");
+        check (rom.prg[16384] == 0xEA && rom.prg[32767] == 0xEA, "new prg filled");
+
+        // the source's chr bytes now sit where the patch put new prg, chr is whatever the patch wrote
+        check (rom.chr.size() == 8192, "chr size kept");
+        check (rom.chr[0] == 0x55 && rom.chr[1] == 0, "chr past the source is patch or zero");
+    }
+
+    // chr 8 -> 16 KB, the new bank filled by the patch
+    void grow_chr ()
+    {
+        const auto source = nrom_128 ();
+
+        IPS ips;
+        ips.record (5, {2});
+        ips.fill (16 + 16384 + 8192, 8192, 0x33);
+
+        const auto rom = ROM_Stream::decode (source, "grow_chr.nes", ips.finish ());
+
+        check (rom.chr.size() == 16384, "chr grew to 16 KB");
+        check (rom.chr[8191] == source[16 + 16384 + 8191], "old chr kept");
+        check (rom.chr[8192] == 0x33 && rom.chr[16383] == 0x33, "new chr filled");
+    }
+
+    // chr 8 KB -> none, the source's chr is dropped
+    void shrink_chr ()
+    {
+        const auto source = nrom_128 ();
+
+        IPS ips;
+        ips.record (5, {0});
+
+        const auto rom = ROM_Stream::decode (source, "shrink_chr.nes", ips.finish ());
+
+        check (rom.prg.size() == 16384 && rom.chr.empty(), "chr dropped");
+        check (rom.prg[100] == source[116], "prg kept");
+    }
+
+    void truncated_source ()
+    {
+        auto source = nrom_128 ();
+        source.resize (source.size() - 1);
+
+        bool threw = false;
+        try
+        {
+            ROM_Stream::decode (source, "truncated.nes", IPS {}.finish ());
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+
+        check (threw, "a source shorter than its header throws");
+    }
+}
+
+int main ()
+{
+    grow_prg ();
+    grow_chr ();
+    shrink_chr ();
+    truncated_source ();
+
+    return Test::report ("rom_stream");
+}
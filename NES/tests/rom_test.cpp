@@ -0,0 +1,73 @@
+#include "rom.h"
+#include "check.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+
+NES_ROM::load header checks. the files are written to the temp directory and
+removed again.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    std::string write_rom (const char* name, const u8 prg_banks, const u8 chr_banks)
+    {
+        std::vector <u8> file {'N', 'E', 'S', 0x1A, prg_banks, chr_banks, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        file.resize (file.size () + prg_banks * 16384 + chr_banks * 8192, 0xEA);
+
+        const std::string path = (std::filesystem::temp_directory_path () / name).string ();
+        std::ofstream (path, std::ios::binary).write (reinterpret_cast <const char*> (file.data ()), static_cast <std::streamsize> (file.size ()));
+        return path;
+    }
+
+    void no_prg ()
+    {
+        const std::string path = write_rom ("rom_test_no_prg.nes", 0, 1);
+        bool threw = false;
+
+        try
+        {
+            NES_ROM rom {path.c_str ()};
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+
+        check (threw, "a header with 0 prg banks throws");
+        std::filesystem::remove (path);
+    }
+
+    void chr_ram ()
+    {
+        const std::string path = write_rom ("rom_test_chr_ram.nes", 1, 0);
+        bool threw = false;
+
+        try
+        {
+            NES_ROM rom {path.c_str ()};
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+
+        check (!threw, "a header with 0 chr banks loads with chr ram");
+        std::filesystem::remove (path);
+    }
+}
+
+int main ()
+{
+    no_prg ();
+    chr_ram ();
+
+    return Test::report ("rom");
+}
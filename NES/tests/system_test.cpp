@@ -0,0 +1,247 @@
+#include "system.h"
+#include "check.h"
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+
+System's MMC3 irq (count_clocks, get_clock_dot, schedule_mapper_irq) against a
+reference that clocks a plain MMC3 counter once per A12 rise, scanline by
+scanline. the rom sets up PPUCTRL, the latch and rendering after a delay, and
+possibly moves the sprite / background tables again later, then runs into a
+sled of NOPs. the irq handler hands back the pc it interrupted, which says to
+the instruction when the irq was taken, and that has to be the first
+instruction boundary at or after the cycle the reference's rise falls in (or
+the one after CLI, for irqs that come during the setup).
+
+the files are written to the temp directory and removed again.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    constexpr u64 dots_per_line  = 341;
+    constexpr u64 dots_per_frame = dots_per_line * 262;
+
+    constexpr u16 sled_begin = 0x8000;
+    constexpr u16 sled_end   = 0xDFFD; // JMP back to the start after it
+
+    struct Setup
+    {
+        u8 ctrl;
+        u8 latch;
+        u8 delay;       // DEY loops before rendering is turned on, 1 - 255
+        u8 late_ctrl;   // written delay_late loops after that, if delay_late isn't 0
+        u8 delay_late;
+    };
+
+    // dot within the line A12 rises on with rendering on, 0 if it never does
+    u64 a12_dot (const u8 ctrl)
+    {
+        return ctrl & 0x28 ? 260 : ctrl & 0x10 ? 324 : 0;
+    }
+
+    // the cycles the reset code below takes up to each write it makes to the ppu
+    u64 mask_cycle (const Setup& setup)
+    {
+        // SEI CLD LDX TXS, LDA STA ($4017), LDA STA ($2000), LDA STA STA STA (mmc3), LDY, the DEY / BNE loop, LDA
+        return 36 + (5 * setup.delay - 1) + 2;
+    }
+
+    u64 late_cycle (const Setup& setup)
+    {
+        // STA $2001, LDY, the loop, LDA
+        return mask_cycle (setup) + 4 + 2 + (5 * setup.delay_late - 1) + 2;
+    }
+
+    u64 sled_cycle (const Setup& setup)
+    {
+        // the last STA, CLI, JMP
+        return (setup.delay_late ? late_cycle (setup) : mask_cycle (setup)) + 4 + 2 + 3;
+    }
+
+    std::vector <u8> program (const Setup& setup)
+    {
+        std::vector <u8> code
+        {
+            0x78, 0xD8, 0xA2, 0xFF, 0x9A,           // SEI, CLD, LDX #$FF, TXS
+            0xA9, 0x40, 0x8D, 0x17, 0x40,           // LDA #$40, STA $4017, no apu frame irq
+            0xA9, setup.ctrl, 0x8D, 0x00, 0x20,     // LDA #ctrl, STA $2000
+            0xA9, setup.latch, 0x8D, 0x00, 0xC0,    // LDA #latch, STA $C000
+            0x8D, 0x01, 0xC0, 0x8D, 0x01, 0xE0,     // STA $C001 (reload), STA $E001 (enable)
+            0xA0, setup.delay, 0x88, 0xD0, 0xFD,    // LDY #delay, DEY, BNE
+            0xA9, 0x18, 0x8D, 0x01, 0x20,           // LDA #$18, STA $2001
+        };
+
+        if (setup.delay_late)
+        {
+            const std::array <u8, 10> late {0xA0, setup.delay_late, 0x88, 0xD0, 0xFD, 0xA9, setup.late_ctrl, 0x8D, 0x00, 0x20};
+            code.insert (code.end (), late.begin (), late.end ());
+        }
+
+        const std::array <u8, 4> run {0x58, 0x4C, 0x00, 0x80}; // CLI, JMP $8000
+        code.insert (code.end (), run.begin (), run.end ());
+        return code;
+    }
+
+    // 32 KB prg in the power on banks: the sled in $8000 - $DFFF, reset code at $E000, irq handler at $E100
+    std::string write_rom (const Setup& setup)
+    {
+        std::vector <u8> prg (0x8000, 0xEA);
+
+        const u16 jmp = sled_end - sled_begin;
+        prg[jmp] = 0x4C;
+        prg[jmp + 1] = 0x00;
+        prg[jmp + 2] = 0x80;
+
+        const std::vector <u8> reset = program (setup);
+        std::copy (reset.begin (), reset.end (), prg.begin () + 0x6000);
+
+        // TSX, LDY $0103,X (pc high), LDA $0102,X (pc low), TAX, LDA #$AA, JMP *
+        const std::array <u8, 13> handler {0xBA, 0xBC, 0x03, 0x01, 0xBD, 0x02, 0x01, 0xAA, 0xA9, 0xAA, 0x4C, 0x0A, 0xE1};
+        std::copy (handler.begin (), handler.end (), prg.begin () + 0x6100);
+
+        const std::array <u8, 6> vectors {0x00, 0xE1, 0x00, 0xE0, 0x00, 0xE1};
+        std::copy (vectors.begin (), vectors.end (), prg.end () - 6);
+
+        std::vector <u8> file {'N', 'E', 'S', 0x1A, 2, 1, 0x40, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        file.insert (file.end (), prg.begin (), prg.end ());
+        file.resize (file.size () + 8192);
+
+        const std::string path = (std::filesystem::temp_directory_path () / "system_test.nes").string ();
+        std::ofstream (path, std::ios::binary).write (reinterpret_cast <const char*> (file.data ()), static_cast <std::streamsize> (file.size ()));
+        return path;
+    }
+
+    // the reference, one clock per A12 rise
+    struct MMC3_Counter
+    {
+        u8   latch;
+        u8   counter = 0;
+        bool reload = true;
+
+        bool clock ()
+        {
+            if (counter == 0 || reload)
+            {
+                counter = latch;
+                reload = false;
+            }
+            else
+                --counter;
+
+            return counter == 0;
+        }
+    };
+
+    // dot of the rise that raises the irq, 0 if none does within frames
+    u64 reference_irq_dot (const Setup& setup, const u64 frames)
+    {
+        MMC3_Counter counter {setup.latch};
+
+        // rendering goes on at the mask write, the late ctrl write takes over after its own dot
+        const u64 on = mask_cycle (setup) * 3;
+        const u64 late = setup.delay_late ? late_cycle (setup) * 3 : ~u64 {0};
+
+        for (u64 frame = 0; frame < frames; ++frame)
+        {
+            for (u64 line = 0; line < 262; ++line)
+            {
+                if (line >= 240 && line != 261)
+                    continue;
+
+                const u64 base = frame * dots_per_frame + line * dots_per_line;
+
+                // a change of tables between the two rise dots can clock a line twice, like the system does
+                for (const u8 ctrl : {setup.ctrl, setup.late_ctrl})
+                {
+                    const u64 a12 = a12_dot (ctrl);
+                    const u64 dot = base + a12;
+                    const bool active = ctrl == setup.ctrl ? dot <= late : setup.delay_late && dot > late;
+
+                    if (a12 == 0 || !active || dot <= on)
+                        continue;
+
+                    if (counter.clock ())
+                        return dot;
+
+                    if (setup.ctrl == setup.late_ctrl)
+                        break;
+                }
+            }
+        }
+        return 0;
+    }
+
+    bool irq_timing (const Setup& setup)
+    {
+        static constexpr u64 frames = 3;
+
+        const std::string path = write_rom (setup);
+        NES_ROM rom {path.c_str ()};
+        auto system = NES_System::create (rom);
+        std::filesystem::remove (path);
+
+        std::vector <i16> samples (4096);
+        for (u64 frame = 0; frame < frames && system->get_cpu ().get_AC () != 0xAA; ++frame)
+            system->run_frame (samples);
+
+        const CPU::MOS6502& cpu = system->get_cpu ();
+        const bool taken = cpu.get_AC () == 0xAA;
+
+        const u64 dot = reference_irq_dot (setup, frames);
+        const u64 sled = sled_cycle (setup);
+
+        if (dot == 0)
+            return !taken;
+
+        // the first boundary at or after the cycle the rise falls in. before CLI the irq waits,
+        // so one that comes during the setup is taken right after it, on the JMP into the sled
+        const u64 cycle = (dot + 2) / 3;
+        const u16 jmp = static_cast <u16> (0xE000 + program (setup).size () - 3);
+
+        u16 expected = jmp;
+        if (cycle > sled - 3)
+            expected = static_cast <u16> (sled_begin + (cycle > sled ? (cycle - sled + 1) / 2 : 0));
+
+        if (expected > sled_end && expected != jmp)
+        {
+            std::fprintf (stderr, "ctrl %02X latch %u delay %u: the irq comes after the sled\n", setup.ctrl, setup.latch, setup.delay);
+            return false;
+        }
+
+        const u16 pc = static_cast <u16> (cpu.get_X () | (cpu.get_Y () << 8));
+        return taken && pc == expected;
+    }
+}
+
+int main ()
+{
+    bool on_time = true;
+
+    // sprites from $1000, background from $1000, 8x16 sprites, nothing from $1000
+    for (const u8 ctrl : {0x08, 0x10, 0x20, 0x00})
+        for (const u8 latch : {0, 1, 2, 7, 100, 239, 240, 241, 255})
+            for (const u8 delay : {1, 23, 60, 137, 200})
+                on_time &= irq_timing ({ctrl, latch, delay, ctrl, 0});
+
+    check (on_time, "the irq is taken on the instruction after the reference's rise");
+
+    // the tables move after rendering went on, the rise dot changes under a running counter
+    bool moved = true;
+    for (const auto& [from, to] : {std::pair <u8, u8> {0x08, 0x10}, {0x10, 0x08}, {0x10, 0x00}, {0x00, 0x20}})
+        for (const u8 latch : {0, 3, 50, 180})
+            for (const u8 delay_late : {1, 17, 40, 90, 255})
+                moved &= irq_timing ({from, latch, 9, to, delay_late});
+
+    check (moved, "the irq follows a PPUCTRL change after rendering went on");
+
+    return Test::report ("system");
+}
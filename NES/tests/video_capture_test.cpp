@@ -0,0 +1,119 @@
+#include "video_capture.h"
+#include "check.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+
+Video_Capture's stream formats. the files are written to the temp directory
+and removed again. the sizes have to come out exact, and a y4m capture through
+O_DIRECT (more than the 4 MB buffer, so it flushes in the middle and ends on a
+partial block) has to be the same bytes as a buffered one.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    constexpr std::size_t frame_size = PPU::screen_width * PPU::screen_height * 3;
+    constexpr std::string_view y4m_header = "YUV4MPEG2 W256 H240 F39375000:655171 Ip A8:7 C444\n";
+    constexpr std::string_view frame_header = "FRAME\n";
+
+    std::vector <std::unique_ptr <PPU::Frame>> random_frames (const int n, const u32 seed)
+    {
+        std::mt19937 random {seed};
+        std::vector <std::unique_ptr <PPU::Frame>> frames;
+
+        for (int i = 0; i < n; ++i)
+        {
+            auto frame = std::make_unique <PPU::Frame> ();
+            for (auto& pixel : frame->pixels)
+                pixel = static_cast <u8> (random () % PPU::Palette::color_n);
+            for (auto& emphasis : frame->emphasis)
+                emphasis = static_cast <u8> (random () % PPU::Palette::emphasis_n);
+            frames.push_back (std::move (frame));
+        }
+        return frames;
+    }
+
+    std::vector <u8> capture (const std::string& name, const PPU::Video_Capture::Format format, const bool direct_io, const std::vector <std::unique_ptr <PPU::Frame>>& frames)
+    {
+        const PPU::Palette palette;
+        const std::string path = (std::filesystem::temp_directory_path () / name).string ();
+        bool written = true;
+
+        {
+            PPU::Video_Capture capture {path, format, palette, PPU::Video_Capture::Policy::BLOCK, direct_io};
+            for (const auto& frame : frames)
+                written &= capture.submit (*frame);
+        }
+
+        check (written, "a blocking capture takes every frame");
+
+        std::ifstream file {path, std::ios::binary};
+        std::vector <u8> bytes {std::istreambuf_iterator <char> {file}, {}};
+        file.close ();
+        std::filesystem::remove (path);
+        return bytes;
+    }
+
+    void raw_rgb ()
+    {
+        const PPU::Palette palette;
+        const auto frames = random_frames (3, 1);
+        const std::vector <u8> bytes = capture ("video_capture_test.rgb", PPU::Video_Capture::Format::RAW_RGB, false, frames);
+
+        check (bytes.size () == frames.size () * frame_size, "raw rgb is 3 bytes a pixel, frames back to back");
+
+        bool same = bytes.size () == frames.size () * frame_size;
+        for (std::size_t f = 0; f < frames.size () && same; ++f)
+        {
+            for (int y = 0; y < PPU::screen_height; ++y)
+            {
+                for (int x = 0; x < PPU::screen_width; ++x)
+                {
+                    const u32 color = palette.get_color (frames[f]->get_row (y)[x], frames[f]->emphasis[y]);
+                    const u8* rgb = &bytes[f * frame_size + (static_cast <std::size_t> (y) * PPU::screen_width + x) * 3];
+                    same &= rgb[0] == (color & 0xFF) && rgb[1] == ((color >> 8) & 0xFF) && rgb[2] == ((color >> 16) & 0xFF);
+                }
+            }
+        }
+        check (same, "raw rgb pixels are the palette's colors");
+    }
+
+    void y4m ()
+    {
+        // 25 frames are past the 4 MB buffer, and the total isn't a multiple of 4096
+        const auto frames = random_frames (25, 2);
+        const std::size_t size = y4m_header.size () + frames.size () * (frame_header.size () + frame_size);
+
+        const std::vector <u8> buffered = capture ("video_capture_test.y4m", PPU::Video_Capture::Format::Y4M, false, frames);
+        const std::vector <u8> direct = capture ("video_capture_test_direct.y4m", PPU::Video_Capture::Format::Y4M, true, frames);
+
+        check (buffered.size () == size, "y4m is the header plus a FRAME line and 3 planes per frame");
+        check (size % 4096 != 0, "the y4m capture ends on a partial block");
+
+        bool framed = buffered.size () == size && std::memcmp (buffered.data (), y4m_header.data (), y4m_header.size ()) == 0;
+        for (std::size_t f = 0; f < frames.size () && framed; ++f)
+            framed &= std::memcmp (&buffered[y4m_header.size () + f * (frame_header.size () + frame_size)], frame_header.data (), frame_header.size ()) == 0;
+        check (framed, "every y4m frame starts with its FRAME line");
+
+        check (direct == buffered, "a direct i/o capture writes the same bytes, the last partial block included");
+    }
+}
+
+int main ()
+{
+    raw_rgb ();
+    y4m ();
+
+    return Test::report ("video_capture");
+}
@@ -0,0 +1,88 @@
+#include "video_filter.h"
+#include "check.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+/*
+
+Video_Filter's Scale2x (the sse2 path wherever the build has it) against the
+four rules written out per pixel. random frames from a few indices so the
+equal neighbour cases actually come up, random emphasis per row, banded
+over several threads and into a padded pitch.
+
+*/
+
+namespace
+{
+    using Test::check;
+
+    // the rules at a pixel, edges repeat the border pixel
+    u8 scale_2x (const PPU::Frame& frame, const int x, const int y, const int quadrant)
+    {
+        const auto at = [&frame] (const int px, const int py)
+        {
+            return frame.get_row (std::clamp (py, 0, PPU::screen_height - 1))[std::clamp (px, 0, PPU::screen_width - 1)];
+        };
+
+        const u8 B = at (x, y - 1), D = at (x - 1, y), E = at (x, y), F = at (x + 1, y), H = at (x, y + 1);
+
+        switch (quadrant)
+        {
+            case 0:  return D == B && B != F && D != H ? D : E;
+            case 1:  return B == F && B != D && F != H ? F : E;
+            case 2:  return D == H && D != B && H != F ? D : E;
+            default: return H == F && D != H && B != F ? F : E;
+        }
+    }
+
+    void scale2x (const int colors, const u32 seed)
+    {
+        std::mt19937 random {seed};
+        const PPU::Palette palette;
+        PPU::Video_Filter filter {palette, PPU::Video_Filter::Mode::SCALE2X, 2, 3};
+
+        check (filter.get_width () == PPU::screen_width * 2 && filter.get_height () == PPU::screen_height * 2, "scale2x doubles both sides");
+
+        const std::size_t pitch = filter.get_width () * sizeof(u32) + 64;
+        std::vector <u32> out (pitch / sizeof(u32) * filter.get_height ());
+
+        auto frame = std::make_unique <PPU::Frame> ();
+        bool same = true;
+
+        for (int n = 0; n < 4 && same; ++n)
+        {
+            for (auto& pixel : frame->pixels)
+                pixel = static_cast <u8> (random () % colors);
+            for (auto& emphasis : frame->emphasis)
+                emphasis = static_cast <u8> (random () % PPU::Palette::emphasis_n);
+
+            filter.apply (*frame, out.data (), pitch);
+
+            for (int y = 0; y < PPU::screen_height; ++y)
+            {
+                for (int x = 0; x < PPU::screen_width; ++x)
+                {
+                    for (int quadrant = 0; quadrant < 4; ++quadrant)
+                    {
+                        const std::size_t row = static_cast <std::size_t> (y * 2 + quadrant / 2);
+                        const u32 got = out[row * pitch / sizeof(u32) + x * 2 + quadrant % 2];
+                        same &= got == palette.get_color (scale_2x (*frame, x, y, quadrant), frame->emphasis[y]);
+                    }
+                }
+            }
+        }
+
+        check (same, "scale2x matches the per pixel rules");
+    }
+}
+
+int main ()
+{
+    scale2x (2, 1);
+    scale2x (3, 2);
+    scale2x (PPU::Palette::color_n, 3);
+
+    return Test::report ("video_filter");
+}
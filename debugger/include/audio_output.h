@@ -0,0 +1,79 @@
+#ifndef AUDIO_OUTPUT_H
+#define AUDIO_OUTPUT_H
+
+#include "spsc_ring.h"
+#include "utility.h"
+#include <atomic>
+#include <memory>
+#include <span>
+
+/*
+
+SDL audio device fed from a lock-free ring
+
+the emulation loop pushes every frame's samples, the SDL audio thread pops them
+in its callback. no mutex anywhere, the callback can't be held up by the loop.
+
+dynamic rate control
+
+the video loop runs at 60.0988 Hz off its own clock and the sound card runs off
+another, so a fixed resampling ratio slowly fills or drains the ring no matter
+what. get_rate_ratio () looks at how far the ring is from half full and returns
+a factor within +-0.5% for the resampler's output rate: producing a little less
+when the ring is too full and a little more when it runs low. the apu itself
+stays at its fixed rate, so anything recorded from it keeps its nominal rate. a 0.5% pitch change is
+not audible, and the ring settles around the target latency.
+
+https://github.com/libretro/docs/blob/master/archive/ratecontrol.pdf
+
+*/
+
+namespace Debugger
+{
+    class Audio_Output
+    {
+    public:
+
+        static constexpr std::size_t ring_size = 1 << 14; // mono samples
+        static constexpr double max_rate_delta = 0.005;
+
+        // opens the default device, is_open () says if it worked
+        Audio_Output (const int sample_rate = 48000, const int latency_ms = 50);
+        ~Audio_Output ();
+
+        Audio_Output (const Audio_Output&) = delete;
+        Audio_Output& operator= (const Audio_Output&) = delete;
+
+        bool is_open () const;
+
+        // what the device actually runs at
+        int get_sample_rate () const;
+
+        // emulation thread, samples that don't fit are dropped (uncapped runs)
+        void push (std::span <const i16> samples);
+
+        // multiply the output sample rate by this before producing the next frame
+        double get_rate_ratio () const;
+
+        std::size_t get_fill () const;
+        std::size_t get_target_fill () const;
+        u64 get_underruns () const;
+
+    private:
+
+        u32 device;
+        int sample_rate;
+        std::size_t target_fill;
+
+        std::unique_ptr <SPSC_Ring <i16, ring_size>> ring;
+
+        // only touched by the audio thread
+        i16 last_sample;
+
+        std::atomic <u64> underruns;
+
+        static void callback (void* user_data, u8* stream, int length);
+    };
+}
+
+#endif
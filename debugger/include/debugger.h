@@ -3,7 +3,24 @@
 
 #include "MOS6502.h"
 #include "window.h"
+#include "frame_skip.h"
+#include "chr_cache.h"
+#include "palette.h"
+#include "apu.h"
+#include "resampler.h"
+#include "audio_capture.h"
+#include "audio_output.h"
+#include "frame_pacer.h"
+#include "disassembly.h"
+#include "flow_analyzer.h"
+#include "rom.h"
+#include "rom_watcher.h"
+#include "system.h"
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
 
 namespace CPU {class MOS6502;}
 
@@ -12,23 +29,39 @@ namespace Debugger
 {
     struct NES_Data
     {
-        NES_Data (std::vector<std::uint8_t>& prg, std::vector<std::uint8_t>& chr, CPU::MOS6502& _cpu)
-        : prg_memory {prg}
+        NES_Data (NES_ROM& _rom, std::span<std::uint8_t> prg, std::span<std::uint8_t> chr, PPU::CHR_Cache& _chr_cache, NES_System& _system)
+        : rom {_rom}
+        , prg_memory {prg}
         , chr_memory {chr}
-        , cpu {_cpu}
+        , chr_cache {_chr_cache}
+        , system {_system}
+        , cpu {_system.get_cpu ()}
+        , apu {_system.get_apu ()}
         {}
 
         NES_Data (NES_Data& other)
-        : prg_memory {other.prg_memory}
+        : rom {other.rom}
+        , prg_memory {other.prg_memory}
         , chr_memory {other.chr_memory}
+        , chr_cache {other.chr_cache}
+        , system {other.system}
         , cpu {other.cpu}
+        , apu {other.apu}
         {}
 
         static constexpr u16 address_offset = 0x8000;
 
-        std::vector<std::uint8_t>& prg_memory;
-        std::vector<std::uint8_t>& chr_memory;
+        NES_ROM& rom;
+
+        // writable copies, the hex editors patch them. a reload updates them in place
+        std::span<std::uint8_t> prg_memory;
+        std::span<std::uint8_t> chr_memory;
+        PPU::CHR_Cache& chr_cache;
+
+        // runs the frames, cpu and apu are its own
+        NES_System& system;
         CPU::MOS6502& cpu;
+        APU::RP2A03& apu;
 
     };
 
@@ -42,6 +75,44 @@ namespace Debugger
     private:
         Window window;
         NES_Data data;
+
+        PPU::Palette palette;
+        PPU::Frame_Skip frame_skip;
+        bool uncapped;
+
+        // the apu always renders at this rate, the resampler takes it to whatever the device opened at
+        // plus the rate control's correction
+        static constexpr int apu_rate = 48000;
+
+        Audio_Output audio;
+        APU::Resampler resampler;
+        Frame_Pacer pacer;
+        std::vector <i16> samples;
+        std::vector <i16> resampled;
+
+        // mix (and stems) as the apu made them, before the resampler
+        std::unique_ptr <APU::Audio_Capture> audio_capture;
+        bool capture_stems;
+
+        // null if inotify isn't available, the rom then just doesn't reload
+        std::unique_ptr <ROM_Watcher> watcher;
+        std::string reload_status;
+
+        // the Code window, kept up to date through the prg editor's writes and rom reloads
+        Disassembly disassembly;
+        bool follow_pc;
+        char code_lookup[5];
+        std::size_t last_pc_line;
+
+        // code / data marks for the disassembly, worked out off the gui thread
+        Flow_Analyzer analyzer;
+        u64 analysis_generation;
+
+        void code_window ();
+        void speed_controls ();
+        void reload_rom ();
+        void run_frame ();
+        void toggle_audio_capture ();
     };
 
 }
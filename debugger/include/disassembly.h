@@ -0,0 +1,82 @@
+#ifndef DISASSEMBLY_H
+#define DISASSEMBLY_H
+
+#include "flow_analyzer.h"
+#include "utility.h"
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/*
+
+disassembly of prg, kept as an index instead of being redone every frame
+
+    offsets   line -> prg offset of its first byte, ascending, so the line
+              holding an offset is a binary search away
+    text      line -> its text, line_width bytes a line in one arena (nul
+              terminated), so the window only hands ImGui pointers. a line is
+              formatted the first time it is asked for, sweeping only has to
+              find where lines start
+
+until a Flow_Analyzer result comes in (set_code_map ()) it is a linear sweep,
+every byte is taken for an opcode. with one, only bytes marked OPCODE start
+instructions, the rest becomes .db lines of up to 4 bytes, so data tables
+no longer throw the code after them out of step.
+
+lines are labelled $8000 + offset when all of prg fits in $8000 - $FFFF,
+with the plain prg offset (5 digits) when it has to be banked.
+
+invalidate () takes the bytes that changed (hex editor, rom reload) and
+sweeps again only from the instruction that held the first of them until the
+sweep lands back on an old line start past the last one, the lines in between
+are spliced in. an edit usually touches one or two lines. a new code map is
+applied the same way, over the runs of bytes whose mark changed.
+
+*/
+
+class Disassembly
+{
+public:
+
+    static constexpr std::size_t line_width = 32;
+    static constexpr std::size_t none = ~std::size_t {0};
+
+    explicit Disassembly (std::span <const u8> prg);
+
+    std::size_t size () const;
+
+    u32 get_offset (const std::size_t line) const;
+    u8 get_opcode (const std::size_t line) const;
+    bool is_code (const std::size_t line) const;
+    std::string_view get_text (const std::size_t line) const;
+
+    // the line holding the byte at offset, none past the end of prg
+    std::size_t find_line (const u32 offset) const;
+
+    // prg bytes [begin, end) were written
+    void invalidate (const std::size_t begin, const std::size_t end);
+
+    // from Flow_Analyzer::get_marks (), null goes back to the linear sweep
+    void set_code_map (std::shared_ptr <const Flow_Analyzer::Marks> marks);
+
+private:
+
+    std::span <const u8> prg;
+    bool offset_labels;
+    std::shared_ptr <const Flow_Analyzer::Marks> marks;
+
+    std::vector <u32>  offsets;
+    mutable std::vector <char> text;  // a line starting with nul isn't formatted yet
+
+    // bytes the line starting at offset covers
+    u32 line_size (const u32 offset) const;
+    bool is_opcode (const u32 offset) const;
+
+    // one line, at most line_width - 1 characters
+    void format (const u32 offset, char* line) const;
+    void sweep ();
+};
+
+#endif
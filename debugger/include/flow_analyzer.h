@@ -0,0 +1,102 @@
+#ifndef FLOW_ANALYZER_H
+#define FLOW_ANALYZER_H
+
+#include "utility.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+/*
+
+recursive descent over prg on a worker thread, tells code from data
+
+starting at the nmi / reset / irq vectors ($FFFA - $FFFF) it follows the flow
+the way the cpu would: fall through, branches (both ways), JSR (target and
+return), JMP absolute. RTS / RTI / BRK / JMP indirect end a path, an illegal
+opcode or an instruction overlapping code found earlier ends it without
+marking anything. whatever is never reached stays data.
+
+cpu addresses become prg offsets through a bank context, the prg offsets of
+the four 8 KB windows at the time. the debugger hands in the context it sees
+every frame, every new one is analyzed too and the marks of all of them are
+merged, so a banked rom fills in as the game maps its banks. the pc can be
+added as an extra entry, which catches code only reached through jump tables
+or JMP indirect.
+
+requests (new prg, new context or entry) copy what they need under a lock and
+wake the worker, one that arrives mid analysis restarts it. a finished
+analysis is published as a whole, get_marks () hands out a shared pointer to
+the latest one and get_generation () tells when there is a new one without
+taking the lock.
+
+*/
+
+class Flow_Analyzer
+{
+public:
+
+    enum Mark : u8
+    {
+        DATA,     // never reached
+        OPCODE,   // first byte of an instruction
+        OPERAND,
+    };
+
+    using Marks = std::vector <u8>;        // one per prg byte
+    using Banks = std::array <u32, 4>;     // prg offset at $8000 $A000 $C000 $E000
+
+    struct Context
+    {
+        Banks banks;
+        std::vector <u16> entries;  // beyond the vectors
+    };
+
+    static constexpr std::size_t max_contexts = 64;
+    static constexpr std::size_t max_entries  = 256;
+
+    // runs on the calling thread, false if restart was set before it got through
+    static bool analyze (std::span <const u8> prg, std::span <const Context> contexts, Marks& marks, const std::atomic <bool>& restart);
+
+    Flow_Analyzer ();
+    ~Flow_Analyzer ();
+
+    Flow_Analyzer (const Flow_Analyzer&) = delete;
+    Flow_Analyzer& operator= (const Flow_Analyzer&) = delete;
+
+    // copies prg, analyzes everything again
+    void set_prg (std::span <const u8> prg);
+
+    // entry is a cpu address, anything below $8000 only adds the context
+    void add_entry (const Banks& banks, const u16 entry);
+
+    // bumped with every published analysis
+    u64 get_generation () const;
+    std::shared_ptr <const Marks> get_marks () const;
+
+private:
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+
+    std::shared_ptr <const std::vector <u8>> prg;
+    std::vector <Context> contexts;
+    std::shared_ptr <const Marks> marks;
+
+    bool pending;
+    bool running;
+    std::atomic <bool> restart;
+    std::atomic <u64> generation;
+
+    // last, starts once everything above is set up
+    std::thread worker;
+
+    void run ();
+    void request ();
+};
+
+#endif
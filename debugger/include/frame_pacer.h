@@ -0,0 +1,48 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <chrono>
+
+/*
+
+paces the main loop to the NES frame rate without vsync
+
+the display refresh is rarely exactly 60.0988 Hz, so letting SDL_GL_SwapWindow
+block either drops or doubles frames every few seconds and leaves the loop
+stuck whenever the driver ignores the swap interval. wait () sleeps until a bit
+before the next frame deadline and spins the rest of the way. the spin margin
+follows how late the os actually wakes us up: it grows right away after a late
+wakeup and shrinks slowly after on-time ones, so a quiet system spends almost
+nothing spinning.
+
+*/
+
+namespace Debugger
+{
+    class Frame_Pacer
+    {
+    public:
+
+        static constexpr double ntsc_rate = 60.0988;
+
+        Frame_Pacer (const double fps = ntsc_rate);
+
+        // blocks until the start of the next frame
+        void wait ();
+
+        // start counting from now, after a pause or when coming back from uncapped
+        void reset ();
+
+        std::chrono::nanoseconds get_spin_margin () const;
+
+    private:
+
+        using clock = std::chrono::steady_clock;
+
+        clock::duration   period;
+        clock::time_point deadline;
+        clock::duration   spin_margin;
+    };
+}
+
+#endif
@@ -5,11 +5,23 @@
 
 #include <span>
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
 
-struct ImGuiInputTextCallbackData;
+struct ImVec2;
+
+/*
+
+the grid is drawn straight into the window's draw list: one AddText per byte
+pointing into a table of preformatted "00" - "FF" glyph pairs, one per row
+for the address and one for the ascii column. there are no widgets per byte,
+only the rows in view are drawn, and the mouse is mapped to a cell by
+arithmetic on its position. the one InputText left is the cell being edited,
+enter writes it and moves on to the next byte.
+
+*/
 
 
 class Hex_Editor
@@ -24,7 +36,9 @@ public:
                 void * const buffer);
 
     void present (void);
-    static int input_callback (ImGuiInputTextCallbackData* data);
+
+    // called with the address of every byte edited through the window
+    void set_write_callback (std::function <void (std::size_t)> callback);
 
 private:
 
@@ -45,13 +59,6 @@ private:
         int address_padding;
     };
 
-    struct User_Data
-    {
-        bool set;
-        bool selected;
-        char buffer[3];
-    };
-
 
     Sizes       sizes;
     std::string name;
@@ -62,14 +69,28 @@ private:
     bool is_showing;
 
     std::uint8_t selected_value;
-    std::uint8_t selected_index;
+    std::size_t selected_index;
+
+    // the cell with the InputText, none if nothing is being edited
+    static constexpr std::size_t none = ~std::size_t {0};
+    std::size_t editing;
+    bool edit_focus;
+    char edit_buffer[3];
 
     std::vector <char> lookup_buffer;
 
+    std::function <void (std::size_t)> write_callback;
+
 
     void calc (void);
     void draw_column_labels (void);
 
+    // x of a byte column relative to the row start, there is a gap after the 8th
+    float byte_x (const std::size_t col) const;
+    // cell under a point relative to the first row, none if it isn't on a byte
+    std::size_t hit_test (const ImVec2& point, const std::size_t row_n) const;
+    void select (const std::size_t index);
+
 };
 
 #endif
\ No newline at end of file
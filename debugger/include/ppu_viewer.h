@@ -0,0 +1,87 @@
+#ifndef PPU_VIEWER_H
+#define PPU_VIEWER_H
+
+#include "chr_cache.h"
+#include "palette.h"
+#include "utility.h"
+#include <array>
+#include <string>
+#include <vector>
+
+/*
+
+ppu state viewers for the debugger
+
+both keep their image in a gl texture that ImGui just draws as one quad. the
+pattern viewer remembers the generation of every tile it uploaded and only
+pushes the tiles whose generation moved (chr ram writes, hex editor edits)
+with glTexSubImage2D, so it can stay open while the game runs at full speed.
+
+textures are created on the first present (), the gl context has to exist by
+then, and are deleted in the destructor.
+
+*/
+
+class Pattern_Viewer
+{
+public:
+
+    Pattern_Viewer (const char* window_name, PPU::CHR_Cache& cache, const PPU::Palette& palette);
+    ~Pattern_Viewer ();
+
+    Pattern_Viewer (const Pattern_Viewer&) = delete;
+    Pattern_Viewer& operator= (const Pattern_Viewer&) = delete;
+
+    void present (void);
+
+private:
+
+    // 16 x 16 tiles is one 4 KB pattern table
+    static constexpr int tiles_per_row = 16;
+
+    std::string name;
+    PPU::CHR_Cache& cache;
+    const PPU::Palette& palette;
+
+    int width;
+    int height;
+    int zoom;
+
+    unsigned int texture;
+
+    std::vector <u32> seen;   // generation of each tile when it was last uploaded
+    std::vector <u32> pixels; // whole image, only used when everything goes up at once
+    bool stale;
+
+    // system palette index for tile pixel values 0 - 3
+    std::array <u8, 4> colors;
+
+    void upload (void);
+    void draw_tooltip (void);
+};
+
+class Palette_Viewer
+{
+public:
+
+    explicit Palette_Viewer (const PPU::Palette& palette);
+    ~Palette_Viewer ();
+
+    Palette_Viewer (const Palette_Viewer&) = delete;
+    Palette_Viewer& operator= (const Palette_Viewer&) = delete;
+
+    void present (void);
+
+private:
+
+    const PPU::Palette& palette;
+
+    unsigned int texture;
+
+    int  emphasis;
+    bool stale;
+
+    void upload (void);
+};
+
+#endif
@@ -19,6 +19,9 @@ namespace Debugger
         void poll(std::function<void(SDL_Event&)> callback);
         bool is_running() const;
         void update() const;
+
+        // off lets the loop run uncapped
+        void set_vsync (const bool enabled);
         
         SDL_Window* get_window () const;
         void* get_gl_context () const;
@@ -0,0 +1,101 @@
+#include "audio_output.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <iostream>
+
+Debugger::Audio_Output::Audio_Output (const int _sample_rate, const int latency_ms)
+: device {0}
+, sample_rate {_sample_rate}
+, target_fill {0}
+, ring {std::make_unique <SPSC_Ring <i16, ring_size>> ()}
+, last_sample {0}
+, underruns {0}
+{
+    SDL_AudioSpec want {};
+    SDL_AudioSpec have {};
+
+    want.freq     = _sample_rate;
+    want.format   = AUDIO_S16SYS;
+    want.channels = 1;
+    want.samples  = 512;
+    want.callback = &Audio_Output::callback;
+    want.userdata = this;
+
+    device = SDL_OpenAudioDevice (nullptr, 0, &want, &have, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+    if (device == 0)
+    {
+        std::clog << "audio: " << SDL_GetError() << std::endl;
+        return;
+    }
+
+    sample_rate = have.freq;
+
+    // half the latency sits in the ring, the device buffer holds the rest
+    target_fill = std::min <std::size_t> (static_cast <std::size_t> (sample_rate) * latency_ms / 1000, ring_size / 2);
+
+    SDL_PauseAudioDevice (device, 0);
+}
+
+Debugger::Audio_Output::~Audio_Output ()
+{
+    if (device)
+        SDL_CloseAudioDevice (device);
+}
+
+bool Debugger::Audio_Output::is_open () const
+{
+    return device != 0;
+}
+
+int Debugger::Audio_Output::get_sample_rate () const
+{
+    return sample_rate;
+}
+
+void Debugger::Audio_Output::push (std::span <const i16> samples)
+{
+    if (device)
+        ring->push (samples);
+}
+
+double Debugger::Audio_Output::get_rate_ratio () const
+{
+    if (!device || target_fill == 0)
+        return 1.0;
+
+    const double fill  = static_cast <double> (ring->size());
+    const double error = std::clamp ((fill - target_fill) / target_fill, -1.0, 1.0);
+    return 1.0 - max_rate_delta * error;
+}
+
+std::size_t Debugger::Audio_Output::get_fill () const
+{
+    return ring->size();
+}
+
+std::size_t Debugger::Audio_Output::get_target_fill () const
+{
+    return target_fill;
+}
+
+u64 Debugger::Audio_Output::get_underruns () const
+{
+    return underruns.load (std::memory_order_relaxed);
+}
+
+void Debugger::Audio_Output::callback (void* user_data, u8* stream, int length)
+{
+    auto& self = *static_cast <Audio_Output*> (user_data);
+    const std::span <i16> out {reinterpret_cast <i16*> (stream), static_cast <std::size_t> (length) / sizeof(i16)};
+
+    const std::size_t n = self.ring->pop (out);
+    if (n > 0)
+        self.last_sample = out[n - 1];
+
+    // ran dry, hold the last level instead of dropping to 0 so it doesn't click
+    if (n < out.size())
+    {
+        std::fill (out.begin() + n, out.end(), self.last_sample);
+        self.underruns.fetch_add (1, std::memory_order_relaxed);
+    }
+}
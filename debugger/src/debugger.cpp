@@ -1,7 +1,13 @@
 #include "debugger.h"
 #include "MOS6502.h"
 #include "hex_editor.h"
+#include "ppu_viewer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <iostream>
+#include <string>
 
 #include "imgui.h"
 #include "imgui_impl_sdl2.h"
@@ -55,11 +61,10 @@ namespace
         ImGui::End();
     }
 
-    [[maybe_unused]]
-    void ins_info_button (u8 instruction, u16 index, const CPU::MOS6502& cpu) 
+    void ins_info_button (u8 instruction, int index, const CPU::MOS6502& cpu)
     {
         const auto& ins = cpu.get_instruction(instruction);
-        ImGui::SameLine(ImGui::CalcTextSize("F").x * 27);
+        ImGui::SameLine(ImGui::CalcTextSize("F").x * Disassembly::line_width);
         ImGui::PushID(index);
         ImGui::Button(ins.mnemonic);
         if(ImGui::IsItemHovered(ImGuiHoveredFlags_ForTooltip))
@@ -71,96 +76,40 @@ namespace
         }
         ImGui::PopID();
     }
-
-    void decompiler (const Debugger::NES_Data& data)
-    {
-        std::uint16_t index = 0;
-        const auto read = [&data](auto index){ return data.prg_memory[index]; };
-        ImGui::Begin ("Code");
-        
-        while (index < data.prg_memory.size())
-        {
-            const auto& ins_info = data.cpu.get_instruction(data.prg_memory[index]);
-            
-            switch (ins_info.mode)
-            {
-                case CPU::_6502::Mode::ABS:
-                    ImGui::Text ("%04X: %02X %02X %02X %s $%04X", data.address_offset + index, read(index), read(index+1), read(index+2), ins_info.mnemonic, (read(index+2) << 8) | read(index+1));
-                    ins_info_button (read(index), index, data.cpu);
-                    index += 3;
-                break;
-                case CPU::_6502::Mode::ABX:
-                    ImGui::Text ("%04X: %02X %02X %02X %s $%04X, X", data.address_offset + index, read(index), read(index+1), read(index+2), ins_info.mnemonic, (read(index+2) << 8) | read(index+1));
-                    ins_info_button (read(index), index, data.cpu);
-                    index += 3;
-                break;
-                case CPU::_6502::Mode::ABY:
-                    ImGui::Text ("%04X: %02X %02X %02X %s", data.address_offset + index, read(index), read(index+1), read(index+2), ins_info.mnemonic);
-                    ins_info_button (read(index), index, data.cpu);
-                    index += 3;
-                break;
-                case CPU::_6502::Mode::IMM:
-                    ImGui::Text ("%04X: %02X %02X %6s #$%02X", data.address_offset + index, read(index), read(index+1), ins_info.mnemonic, read(index+1));
-                    ins_info_button (read(index), index, data.cpu);
-                    index += 2;
-                break;
-                case CPU::_6502::Mode::ACC:
-                case CPU::_6502::Mode::IMP:
-                    ImGui::Text ("%04X: %02X %9s",data.address_offset +  index, read(index), ins_info.mnemonic);
-                    ins_info_button (read(index), index, data.cpu);
-                    index += 1;
-                break;
-                case CPU::_6502::Mode::IND:
-                    ImGui::Text ("%04X: %02X %02X %02X %s", data.address_offset + index, read(index), read(index+1), read(index+2), ins_info.mnemonic);
-                    ins_info_button (read(index), index, data.cpu);
-                    index += 3;
-                break;
-                case CPU::_6502::Mode::XIZ:
-                    ImGui::Text ("%04X: %02X %02X %6s $%02X", data.address_offset + index, read(index), read(index+1), ins_info.mnemonic, read(index+1));
-                    ins_info_button (read(index), index, data.cpu);
-                    index+= 2;
-                break;
-                case CPU::_6502::Mode::YIZ:
-                    ImGui::Text ("%04X: %02X %02X %6s $%02X", data.address_offset + index, read(index), read(index+1), ins_info.mnemonic, read(index+1));
-                    ins_info_button (read(index), index, data.cpu);
-                    index += 2;
-                break;
-                case CPU::_6502::Mode::REL:
-                    if (std::strcmp(ins_info.mnemonic, "CPX"))
-                    {
-                        std::uint16_t result = read (index+1);
-                        if (result & 0x80) result |= 0xFF00;
-                        std::uint16_t addr = index+2 + result;
-                        ImGui::Text ("%04X: %02X %02X %6s $%04X", data.address_offset + index, read(index), read(index+1), ins_info.mnemonic, addr); 
-                        ins_info_button (read(index), index, data.cpu);
-                        index += 2;
-                    }
-                break;
-                case CPU::_6502::Mode::ZPG:
-                    ImGui::Text ("%04X: %02X %02X %6s %02X", data.address_offset + index, read(index), read(index+1), ins_info.mnemonic, read(index+1));
-                    ins_info_button (read(index), index, data.cpu);
-                    index += 2;
-                break;
-                case CPU::_6502::Mode::ZPX:
-                    ImGui::Text ("%04X: %02X %02X %6s", data.address_offset + index, read(index), read(index+1), ins_info.mnemonic);
-                    ins_info_button (read(index), index, data.cpu);
-                    index += 2;
-                break;
-                case CPU::_6502::Mode::ZPY:
-                    ImGui::Text ("%04X: %02X %02X %6s", data.address_offset + index, read(index), read(index+1), ins_info.mnemonic);
-                    ins_info_button (read(index), index, data.cpu);
-                    index += 2;
-                break;
-            }
-        }
-        ImGui::End();
-    }
 }
 
 Debugger::GUI::GUI (const char* title, const int width, const int height, NES_Data data)
 : window {title, width, height}
 , data {data}
+, palette {}
+, frame_skip {}
+, uncapped {false}
+, audio {apu_rate}
+, resampler {apu_rate, audio.get_sample_rate ()}
+, pacer {}
+, samples (4096)
+, resampled (resampler.max_output (samples.size()))
+, audio_capture {}
+, capture_stems {false}
+, watcher {}
+, disassembly {data.prg_memory}
+, follow_pc {true}
+, code_lookup {}
+, last_pc_line {Disassembly::none}
+, analyzer {}
+, analysis_generation {0}
 {
+    analyzer.set_prg (data.prg_memory);
+
+    try
+    {
+        watcher = std::make_unique <ROM_Watcher> (data.rom.get_path ());
+    }
+    catch (const std::exception& e)
+    {
+        std::clog << e.what() << std::endl;
+    }
+
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -181,11 +130,27 @@ void Debugger::GUI::run ()
     ImGui_ImplSDL2_InitForOpenGL(window.get_window (), window.get_gl_context ());
     ImGui_ImplOpenGL3_Init(window.get_glsl_version ().c_str());
 
+    // the pacer keeps time, swap must not block on the display refresh
+    window.set_vsync (false);
+    pacer.reset ();
+
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     Hex_Editor prg_memory {"prg memory", data.prg_memory.size(), 0, data.prg_memory.size(), sizeof(std::uint8_t), data.prg_memory.data()};
     Hex_Editor chr_memory {"chr memory", data.chr_memory.size(), 0, data.chr_memory.size(), sizeof(std::uint8_t), data.chr_memory.data()};
 
+    prg_memory.set_write_callback ([this] (const std::size_t address)
+    {
+        disassembly.invalidate (address, address + 1);
+        analyzer.set_prg (data.prg_memory);
+    });
+
+    // edits go straight into chr memory, tell the cache so the tile gets decoded and uploaded again
+    chr_memory.set_write_callback ([this] (const std::size_t address) { data.chr_cache.invalidate (address); });
+
+    Pattern_Viewer pattern_tables {"Pattern Tables", data.chr_cache, palette};
+    Palette_Viewer palette_viewer {palette};
+
     while (window.is_running ())
     {
         window.poll ([&] (auto& event) {
@@ -198,6 +163,19 @@ void Debugger::GUI::run ()
             continue;
         }
 
+        if (!uncapped)
+            pacer.wait ();
+
+        // between frames, nothing is half way through reading rom
+        if (watcher && watcher->poll ())
+            reload_rom ();
+
+        run_frame ();
+
+        // only every n-th frame gets drawn and swapped, the rest run as fast as they can
+        if (!frame_skip.begin_frame ())
+            continue;
+
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplSDL2_NewFrame();
@@ -206,6 +184,8 @@ void Debugger::GUI::run ()
         
         prg_memory.present();
         chr_memory.present();
+        pattern_tables.present();
+        palette_viewer.present();
 
         ImGui::Begin("Test");
         const std::uint8_t SR = data.cpu.get_SR();
@@ -219,8 +199,9 @@ void Debugger::GUI::run ()
         ImGui::Text("N: %d", static_cast <int> (SR >> 7) & 1);
         ImGui::End();
         print_instruction_set(data.cpu);
+        speed_controls();
 
-        decompiler(data);
+        code_window();
 
         // Rendering
         ImGui::Render();
@@ -232,3 +213,204 @@ void Debugger::GUI::run ()
 
     }
 }
+
+void Debugger::GUI::code_window ()
+{
+    ImGui::Begin ("Code");
+
+    ImGui::Checkbox ("Follow PC", &follow_pc);
+    ImGui::SameLine ();
+    ImGui::SetNextItemWidth (ImGui::CalcTextSize ("FFFF").x + ImGui::GetStyle ().FramePadding.x * 2);
+    const bool jump = ImGui::InputText ("Go to", code_lookup, sizeof(code_lookup), ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_EnterReturnsTrue);
+
+    // cpu addresses go through the current banking, prg is only mapped from $8000 on
+    const Mapper& mapper = data.rom.get_mapper ();
+    const auto line_of = [&] (const long address)
+    {
+        return address >= 0x8000 && address <= 0xFFFF ? disassembly.find_line (mapper.prg_offset (static_cast <u16> (address))) : Disassembly::none;
+    };
+
+    // the analyzer follows the banking the game has now, the pc is one more way into the code
+    const Flow_Analyzer::Banks banks {mapper.prg_offset (0x8000), mapper.prg_offset (0xA000), mapper.prg_offset (0xC000), mapper.prg_offset (0xE000)};
+    analyzer.add_entry (banks, data.cpu.get_PC ());
+
+    if (analyzer.get_generation () != analysis_generation)
+    {
+        analysis_generation = analyzer.get_generation ();
+        disassembly.set_code_map (analyzer.get_marks ());
+    }
+
+    const std::size_t pc_line = line_of (data.cpu.get_PC ());
+
+    std::size_t scroll_to = Disassembly::none;
+    if (jump)
+        scroll_to = line_of (std::strtol (code_lookup, nullptr, 16));
+    else if (follow_pc && pc_line != last_pc_line)
+        scroll_to = pc_line;
+
+    last_pc_line = pc_line;
+
+    ImGui::BeginChild ("lines");
+
+    // the info buttons make a line frame height
+    const float line_height = ImGui::GetFrameHeightWithSpacing ();
+    if (scroll_to != Disassembly::none)
+        ImGui::SetScrollY (scroll_to * line_height - ImGui::GetWindowHeight () / 2);
+
+    // only the lines in view are submitted, the text is already formatted
+    ImGuiListClipper clipper;
+    clipper.Begin (static_cast <int> (disassembly.size ()), line_height);
+
+    while (clipper.Step ())
+    {
+        for (int line = clipper.DisplayStart; line < clipper.DisplayEnd; ++line)
+        {
+            if (static_cast <std::size_t> (line) == pc_line)
+            {
+                const ImVec2 min = ImGui::GetCursorScreenPos ();
+                ImGui::GetWindowDrawList ()->AddRectFilled (min, {min.x + ImGui::GetContentRegionAvail ().x, min.y + line_height}, ImGui::GetColorU32 (ImGuiCol_TextSelectedBg));
+            }
+
+            const std::string_view text = disassembly.get_text (line);
+            ImGui::TextUnformatted (text.data (), text.data () + text.size ());
+            if (disassembly.is_code (line))
+                ins_info_button (disassembly.get_opcode (line), line, data.cpu);
+        }
+    }
+
+    ImGui::EndChild ();
+    ImGui::End ();
+}
+
+void Debugger::GUI::speed_controls ()
+{
+    ImGui::Begin ("Speed");
+
+    // independent of frame skip, uncapped only turns the pacer off
+    if (ImGui::Checkbox ("Uncapped", &uncapped) && !uncapped)
+        pacer.reset ();
+
+    int present_every = frame_skip.get_present_every ();
+    if (ImGui::SliderInt ("Present every", &present_every, 1, 16))
+        frame_skip.set_present_every (present_every);
+
+    ImGui::Text ("Frames: %llu", static_cast <unsigned long long> (frame_skip.get_frame_count ()));
+    ImGui::Text ("Spin: %.2f ms", pacer.get_spin_margin ().count () / 1e6);
+
+    if (audio.is_open ())
+    {
+        ImGui::Text ("Audio: %zu / %zu samples, ratio %.4f", audio.get_fill (), audio.get_target_fill (), audio.get_rate_ratio ());
+        ImGui::Text ("Underruns: %llu", static_cast <unsigned long long> (audio.get_underruns ()));
+    }
+    else
+        ImGui::Text ("Audio: no device");
+
+    if (!reload_status.empty ())
+        ImGui::TextUnformatted (reload_status.c_str ());
+
+    ImGui::BeginDisabled (audio_capture != nullptr);
+    ImGui::Checkbox ("Stems", &capture_stems);
+    ImGui::EndDisabled ();
+    ImGui::SameLine ();
+
+    if (ImGui::Button (audio_capture ? "Stop recording" : "Record audio"))
+        toggle_audio_capture ();
+
+    if (audio_capture)
+    {
+        ImGui::Text ("Recorded: %.1f s", audio_capture->get_samples_written () / (capture_stems ? 6.0 : 1.0) / apu_rate);
+        if (audio_capture->get_blocks_dropped () || audio_capture->has_failed ())
+            ImGui::Text ("Dropped: %llu blocks%s", static_cast <unsigned long long> (audio_capture->get_blocks_dropped ()), audio_capture->has_failed () ? ", write failed" : "");
+    }
+
+    ImGui::End ();
+}
+
+void Debugger::GUI::run_frame ()
+{
+    const std::size_t n = data.system.run_frame (samples);
+
+    // still at apu_rate here, the capture's header says so
+    if (audio_capture)
+    {
+        audio_capture->submit (APU::Audio_Capture::Track::MIX, {samples.data(), n});
+        audio_capture->submit_stems (data.apu);
+    }
+
+    // the ratio keeps the device's buffer at its target fill, the resampler takes it out of the apu's stream
+    resampler.set_rates (apu_rate, static_cast <int> (std::lround (audio.get_sample_rate () * audio.get_rate_ratio ())));
+
+    resampled.resize (std::max (resampled.size(), resampler.max_output (n)));
+    const std::size_t m = resampler.process ({samples.data(), n}, resampled);
+    audio.push ({resampled.data(), m});
+}
+
+void Debugger::GUI::reload_rom ()
+{
+    NES_ROM::Reload changes {};
+
+    try
+    {
+        changes = data.rom.reload ();
+    }
+    catch (const std::exception& e)
+    {
+        // usually caught mid build, the next write triggers another try
+        reload_status = e.what ();
+        return;
+    }
+
+    if (changes.header_changed)
+    {
+        reload_status = "Reload: header changed, restart to load it";
+        return;
+    }
+
+    if (std::find (changes.prg.begin(), changes.prg.end(), true) != changes.prg.end())
+        analyzer.set_prg (data.prg_memory);
+
+    // runs of changed chunks, one resweep each
+    for (std::size_t i = 0; i < changes.prg.size(); )
+    {
+        if (!changes.prg[i])
+        {
+            ++i;
+            continue;
+        }
+
+        std::size_t end = i;
+        while (end < changes.prg.size() && changes.prg[end])
+            ++end;
+
+        disassembly.invalidate (i * NES_ROM::Reload::chunk, end * NES_ROM::Reload::chunk);
+        i = end;
+    }
+
+    const auto count = [] (const std::vector <bool>& chunks) { return std::count (chunks.begin(), chunks.end(), true); };
+
+    // the hex editors read the buffers the reload wrote into, the pattern viewer
+    // picks the invalidated tiles up by their generation
+    reload_status = "Reload: " + std::to_string (count (changes.prg)) + " prg / "
+                  + std::to_string (count (changes.chr)) + " chr KB changed";
+}
+
+void Debugger::GUI::toggle_audio_capture ()
+{
+    if (audio_capture)
+    {
+        // joins the writer, which patches the wav headers
+        audio_capture.reset ();
+        data.apu.enable_stems (false);
+        return;
+    }
+
+    try
+    {
+        audio_capture = std::make_unique <APU::Audio_Capture> ("capture.wav", apu_rate, APU::Wav_File::Format::WAV, capture_stems);
+        data.apu.enable_stems (capture_stems);
+    }
+    catch (const std::exception& e)
+    {
+        std::clog << e.what() << std::endl;
+    }
+}
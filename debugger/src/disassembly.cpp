@@ -0,0 +1,262 @@
+#include "disassembly.h"
+#include "MOS6502.h"
+#include "mos6502_instructions.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+    u32 operand_bytes (const CPU::_6502::Mode mode)
+    {
+        using Mode = CPU::_6502::Mode;
+
+        switch (mode)
+        {
+            case Mode::ACC:
+            case Mode::IMP:
+                return 0;
+            case Mode::ABS:
+            case Mode::ABX:
+            case Mode::ABY:
+            case Mode::IND:
+                return 2;
+            default:
+                return 1;
+        }
+    }
+}
+
+Disassembly::Disassembly (std::span <const u8> _prg)
+: prg {_prg}
+, offset_labels {_prg.size() > 0x8000}
+, marks {}
+{
+    sweep();
+}
+
+void Disassembly::sweep ()
+{
+    offsets.clear();
+
+    // roughly 2.5 bytes a line
+    offsets.reserve (prg.size() / 2);
+
+    for (u32 offset = 0; offset < prg.size(); offset += line_size (offset))
+        offsets.push_back (offset);
+
+    text.assign (offsets.size() * line_width, '\0');
+}
+
+std::size_t Disassembly::size () const
+{
+    return offsets.size();
+}
+
+u32 Disassembly::get_offset (const std::size_t line) const
+{
+    return offsets[line];
+}
+
+u8 Disassembly::get_opcode (const std::size_t line) const
+{
+    return prg[offsets[line]];
+}
+
+bool Disassembly::is_code (const std::size_t line) const
+{
+    return is_opcode (offsets[line]) && offsets[line] + line_size (offsets[line]) <= prg.size()
+        && CPU::MOS6502::get_instruction (prg[offsets[line]]).instruction != CPU::_6502::Opcode::XXX;
+}
+
+std::string_view Disassembly::get_text (const std::size_t line) const
+{
+    char* begin = text.data() + line * line_width;
+    if (*begin == '\0')
+        format (offsets[line], begin);
+
+    return {begin, std::strlen (begin)};
+}
+
+std::size_t Disassembly::find_line (const u32 offset) const
+{
+    if (offset >= prg.size() || offsets.empty())
+        return none;
+
+    // last line starting at or before offset
+    const auto it = std::upper_bound (offsets.begin(), offsets.end(), offset);
+    return static_cast <std::size_t> (std::distance (offsets.begin(), it)) - 1;
+}
+
+void Disassembly::invalidate (const std::size_t begin, std::size_t end)
+{
+    end = std::min (end, prg.size());
+    if (begin >= end)
+        return;
+
+    // the instruction holding begin may have changed size, everything after it can shift
+    const std::size_t first = find_line (static_cast <u32> (begin));
+    std::size_t old = first;
+    u32 offset = offsets[first];
+
+    std::vector <u32> new_offsets;
+
+    while (offset < prg.size())
+    {
+        while (old < offsets.size() && offsets[old] < offset)
+            ++old;
+
+        // back in step with the old sweep, nothing from here on changed
+        if (offset >= end && old < offsets.size() && offsets[old] == offset)
+            break;
+
+        new_offsets.push_back (offset);
+        offset += line_size (offset);
+    }
+
+    while (old < offsets.size() && offsets[old] < offset)
+        ++old;
+
+    // old lines [first, old) are replaced
+    const auto replace = [] (auto& lines, const std::size_t from, const std::size_t to, auto& with)
+    {
+        const std::size_t common = std::min (to - from, with.size());
+        std::copy_n (with.begin(), common, lines.begin() + from);
+
+        if (with.size() > common)
+            lines.insert (lines.begin() + from + common, with.begin() + common, with.end());
+        else
+            lines.erase (lines.begin() + from + common, lines.begin() + to);
+    };
+
+    // the new lines are formatted when they are drawn
+    const std::vector <char> new_text (new_offsets.size() * line_width, '\0');
+
+    replace (offsets, first, old, new_offsets);
+    replace (text, first * line_width, old * line_width, new_text);
+}
+
+void Disassembly::set_code_map (std::shared_ptr <const Flow_Analyzer::Marks> _marks)
+{
+    if (_marks && _marks->size() != prg.size())
+        return;
+
+    const auto previous = std::move (marks);
+    marks = std::move (_marks);
+
+    // from or back to the linear sweep, everything moves
+    if (!previous || !marks)
+    {
+        sweep();
+        return;
+    }
+
+    // a data line looks up to 3 bytes ahead for the next opcode, a change reaches back that far
+    const auto& a = *previous;
+    const auto& b = *marks;
+
+    for (std::size_t i = 0; i < b.size(); )
+    {
+        if (a[i] == b[i])
+        {
+            ++i;
+            continue;
+        }
+
+        std::size_t end = i;
+        while (end < b.size() && a[end] != b[end])
+            ++end;
+
+        invalidate (i >= 3 ? i - 3 : 0, end);
+        i = end;
+    }
+}
+
+bool Disassembly::is_opcode (const u32 offset) const
+{
+    return !marks || (*marks)[offset] == Flow_Analyzer::OPCODE;
+}
+
+u32 Disassembly::line_size (const u32 offset) const
+{
+    if (!is_opcode (offset))
+    {
+        // data, up to 4 bytes or the next opcode
+        u32 size = 1;
+        while (size < 4 && offset + size < prg.size() && !is_opcode (offset + size))
+            ++size;
+        return size;
+    }
+
+    const u32 size = 1 + operand_bytes (CPU::MOS6502::get_instruction (prg[offset]).mode);
+
+    // the last instruction of prg can be cut off
+    return offset + size > prg.size() ? 1 : size;
+}
+
+void Disassembly::format (const u32 offset, char* line) const
+{
+    using Mode = CPU::_6502::Mode;
+
+    const auto& ins = CPU::MOS6502::get_instruction (prg[offset]);
+    const u32 length = line_size (offset);
+
+    char label[8];
+    if (offset_labels)
+        std::snprintf (label, sizeof(label), "%05X", offset);
+    else
+        std::snprintf (label, sizeof(label), "%04X", 0x8000 + offset);
+
+    // data, or an instruction cut off at the end
+    if (!is_opcode (offset) || length != 1 + operand_bytes (ins.mode))
+    {
+        int n = std::snprintf (line, line_width, "%s: .db $%02X", label, prg[offset]);
+        for (u32 i = 1; i < length; ++i)
+            n += std::snprintf (line + n, line_width - n, ",$%02X", prg[offset + i]);
+        return;
+    }
+
+    const u8 lo = length > 1 ? prg[offset + 1] : 0;
+    const u8 hi = length > 2 ? prg[offset + 2] : 0;
+    const unsigned absolute = (hi << 8) | lo;
+
+    char bytes[10];
+    if (length == 1)
+        std::snprintf (bytes, sizeof(bytes), "%02X      ", prg[offset]);
+    else if (length == 2)
+        std::snprintf (bytes, sizeof(bytes), "%02X %02X   ", prg[offset], lo);
+    else
+        std::snprintf (bytes, sizeof(bytes), "%02X %02X %02X", prg[offset], lo, hi);
+
+    char operand[12] {};
+    switch (ins.mode)
+    {
+        case Mode::ACC: std::snprintf (operand, sizeof(operand), "A"); break;
+        case Mode::IMP: break;
+        case Mode::IMM: std::snprintf (operand, sizeof(operand), "#$%02X", lo); break;
+        case Mode::ZPG: std::snprintf (operand, sizeof(operand), "$%02X", lo); break;
+        case Mode::ZPX: std::snprintf (operand, sizeof(operand), "$%02X,X", lo); break;
+        case Mode::ZPY: std::snprintf (operand, sizeof(operand), "$%02X,Y", lo); break;
+        case Mode::XIZ: std::snprintf (operand, sizeof(operand), "($%02X,X)", lo); break;
+        case Mode::YIZ: std::snprintf (operand, sizeof(operand), "($%02X),Y", lo); break;
+        case Mode::ABS: std::snprintf (operand, sizeof(operand), "$%04X", absolute); break;
+        case Mode::ABX: std::snprintf (operand, sizeof(operand), "$%04X,X", absolute); break;
+        case Mode::ABY: std::snprintf (operand, sizeof(operand), "$%04X,Y", absolute); break;
+        case Mode::IND: std::snprintf (operand, sizeof(operand), "($%04X)", absolute); break;
+        case Mode::REL:
+        {
+            // branch target in the same labelling as the lines, relative if it leaves prg
+            const long target = static_cast <long> (offset) + 2 + static_cast <std::int8_t> (lo);
+            if (target < 0 || target >= static_cast <long> (prg.size()))
+                std::snprintf (operand, sizeof(operand), "*%+d", 2 + static_cast <std::int8_t> (lo));
+            else if (offset_labels)
+                std::snprintf (operand, sizeof(operand), "$%05lX", static_cast <unsigned long> (target));
+            else
+                std::snprintf (operand, sizeof(operand), "$%04lX", static_cast <unsigned long> (0x8000 + target));
+            break;
+        }
+    }
+
+    std::snprintf (line, line_width, "%s: %s  %s %s", label, bytes, ins.mnemonic, operand);
+}
@@ -0,0 +1,250 @@
+#include "flow_analyzer.h"
+#include "MOS6502.h"
+#include "mos6502_instructions.h"
+#include <algorithm>
+
+namespace
+{
+    u32 instruction_size (const CPU::_6502::Mode mode)
+    {
+        using Mode = CPU::_6502::Mode;
+
+        switch (mode)
+        {
+            case Mode::ACC:
+            case Mode::IMP:
+                return 1;
+            case Mode::ABS:
+            case Mode::ABX:
+            case Mode::ABY:
+            case Mode::IND:
+                return 3;
+            default:
+                return 2;
+        }
+    }
+}
+
+bool Flow_Analyzer::analyze (std::span <const u8> prg, std::span <const Context> contexts, Marks& marks, const std::atomic <bool>& restart)
+{
+    using Opcode = CPU::_6502::Opcode;
+
+    marks.assign (prg.size(), DATA);
+
+    std::vector <u16> work;
+
+    for (const auto& context : contexts)
+    {
+        // prg offset of a cpu address, past the end for anything that isn't prg
+        const auto offset_of = [&] (const u32 address) -> u32
+        {
+            if (address < 0x8000 || address > 0xFFFF)
+                return static_cast <u32> (prg.size());
+
+            const u32 offset = context.banks[(address >> 13) & 0x03] + (address & 0x1FFF);
+            return std::min (offset, static_cast <u32> (prg.size()));
+        };
+
+        work.clear();
+
+        for (const u32 vector : {0xFFFAu, 0xFFFCu, 0xFFFEu})
+        {
+            const u32 lo = offset_of (vector);
+            const u32 hi = offset_of (vector + 1);
+            if (lo < prg.size() && hi < prg.size())
+                work.push_back (static_cast <u16> (prg[lo] | (prg[hi] << 8)));
+        }
+
+        work.insert (work.end(), context.entries.begin(), context.entries.end());
+
+        while (!work.empty())
+        {
+            u32 address = work.back();
+            work.pop_back();
+
+            // one straight line run, branches and calls queue their targets
+            for (;;)
+            {
+                if (restart.load (std::memory_order_relaxed))
+                    return false;
+
+                const u32 offset = offset_of (address);
+                if (offset >= prg.size() || marks[offset] != DATA)
+                    break;
+
+                const auto& ins = CPU::MOS6502::get_instruction (prg[offset]);
+                if (ins.instruction == Opcode::XXX)
+                    break;
+
+                const u32 size = instruction_size (ins.mode);
+
+                // every byte has to be in prg and not claimed by other code
+                u32 operand[2] {};
+                bool fits = true;
+                for (u32 i = 1; i < size; ++i)
+                {
+                    operand[i - 1] = offset_of (address + i);
+                    fits = fits && operand[i - 1] < prg.size() && marks[operand[i - 1]] == DATA;
+                }
+                if (!fits)
+                    break;
+
+                marks[offset] = OPCODE;
+                for (u32 i = 1; i < size; ++i)
+                    marks[operand[i - 1]] = OPERAND;
+
+                const u16 target = size == 3 ? static_cast <u16> (prg[operand[0]] | (prg[operand[1]] << 8)) : 0;
+
+                if (ins.instruction == Opcode::RTS || ins.instruction == Opcode::RTI || ins.instruction == Opcode::BRK)
+                    break;
+
+                if (ins.instruction == Opcode::JMP)
+                {
+                    // the indirect pointer is usually in ram, nothing to follow
+                    if (ins.mode != CPU::_6502::Mode::ABS)
+                        break;
+
+                    address = target;
+                    continue;
+                }
+
+                if (ins.instruction == Opcode::JSR)
+                    work.push_back (target);
+
+                if (ins.mode == CPU::_6502::Mode::REL)
+                    work.push_back (static_cast <u16> (address + 2 + static_cast <std::int8_t> (prg[operand[0]])));
+
+                address += size;
+            }
+        }
+    }
+
+    return true;
+}
+
+Flow_Analyzer::Flow_Analyzer ()
+: pending {false}
+, running {true}
+, restart {false}
+, generation {0}
+, worker {[this] { run (); }}
+{}
+
+Flow_Analyzer::~Flow_Analyzer ()
+{
+    {
+        const std::lock_guard lock {mutex};
+        running = false;
+        restart = true;
+    }
+
+    wake.notify_one();
+    worker.join();
+}
+
+void Flow_Analyzer::set_prg (std::span <const u8> _prg)
+{
+    auto copy = std::make_shared <const std::vector <u8>> (_prg.begin(), _prg.end());
+
+    {
+        const std::lock_guard lock {mutex};
+        prg = std::move (copy);
+        request();
+    }
+
+    wake.notify_one();
+}
+
+void Flow_Analyzer::add_entry (const Banks& banks, const u16 entry)
+{
+    {
+        const std::lock_guard lock {mutex};
+
+        auto context = std::find_if (contexts.begin(), contexts.end(), [&] (const Context& c) { return c.banks == banks; });
+        bool changed = false;
+
+        if (context == contexts.end())
+        {
+            // the oldest ones go first, the game has probably moved on from them
+            if (contexts.size() >= max_contexts)
+                contexts.erase (contexts.begin());
+
+            contexts.push_back ({banks, {}});
+            context = contexts.end() - 1;
+            changed = true;
+        }
+
+        if (entry >= 0x8000)
+        {
+            const u32 offset = banks[(entry >> 13) & 0x03] + (entry & 0x1FFF);
+            const bool known = marks && offset < marks->size() && (*marks)[offset] == OPCODE;
+
+            if (!known && context->entries.size() < max_entries
+                && std::find (context->entries.begin(), context->entries.end(), entry) == context->entries.end())
+            {
+                context->entries.push_back (entry);
+                changed = true;
+            }
+        }
+
+        if (!changed)
+            return;
+
+        request();
+    }
+
+    wake.notify_one();
+}
+
+u64 Flow_Analyzer::get_generation () const
+{
+    return generation.load (std::memory_order_acquire);
+}
+
+std::shared_ptr <const Flow_Analyzer::Marks> Flow_Analyzer::get_marks () const
+{
+    const std::lock_guard lock {mutex};
+    return marks;
+}
+
+// with the lock held
+void Flow_Analyzer::request ()
+{
+    pending = true;
+    restart.store (true, std::memory_order_relaxed);
+}
+
+void Flow_Analyzer::run ()
+{
+    std::unique_lock lock {mutex};
+
+    for (;;)
+    {
+        wake.wait (lock, [this] { return pending || !running; });
+        if (!running)
+            return;
+
+        pending = false;
+        restart.store (false, std::memory_order_relaxed);
+
+        const auto snapshot = prg;
+        const auto snapshot_contexts = contexts;
+
+        // nothing to start from until the debugger hands in a context
+        if (!snapshot || snapshot_contexts.empty())
+            continue;
+
+        lock.unlock();
+
+        auto result = std::make_shared <Marks> ();
+        const bool complete = analyze (*snapshot, snapshot_contexts, *result, restart);
+
+        lock.lock();
+
+        if (complete)
+        {
+            marks = std::move (result);
+            generation.fetch_add (1, std::memory_order_release);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#include "frame_pacer.h"
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    constexpr std::chrono::steady_clock::duration min_margin = 200us;
+    constexpr std::chrono::steady_clock::duration max_margin = 4ms;
+}
+
+Debugger::Frame_Pacer::Frame_Pacer (const double fps)
+: period {std::chrono::duration_cast <clock::duration> (std::chrono::duration <double> (1.0 / fps))}
+, deadline {clock::now ()}
+, spin_margin {1ms}
+{}
+
+void Debugger::Frame_Pacer::wait ()
+{
+    deadline += period;
+    auto now = clock::now ();
+
+    // more than a frame behind (breakpoint, window drag), don't try to catch up
+    if (now > deadline + period)
+    {
+        deadline = now;
+        return;
+    }
+
+    const auto wake = deadline - spin_margin;
+    if (now < wake)
+    {
+        std::this_thread::sleep_until (wake);
+        now = clock::now ();
+
+        const auto late = now - wake;
+        if (late > spin_margin)
+            spin_margin = std::min (late + late / 4, max_margin);
+        else
+            spin_margin = std::max (spin_margin - spin_margin / 64, min_margin);
+    }
+
+    while (clock::now () < deadline)
+        std::this_thread::yield ();
+}
+
+void Debugger::Frame_Pacer::reset ()
+{
+    deadline = clock::now ();
+}
+
+std::chrono::nanoseconds Debugger::Frame_Pacer::get_spin_margin () const
+{
+    return std::chrono::duration_cast <std::chrono::nanoseconds> (spin_margin);
+}
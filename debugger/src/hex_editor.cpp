@@ -1,7 +1,27 @@
 #include "hex_editor.h"
 #include "imgui.h"
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <format>
+#include <utility>
+
+namespace
+{
+    // "00" - "FF" back to back, a byte's two glyphs start at 2 * value
+    constexpr auto hex_glyphs = []
+    {
+        constexpr char digits[] = "0123456789ABCDEF";
+        std::array <char, 512> glyphs {};
+
+        for (int i = 0; i < 256; ++i)
+        {
+            glyphs[i * 2]     = digits[i >> 4];
+            glyphs[i * 2 + 1] = digits[i & 15];
+        }
+        return glyphs;
+    } ();
+}
 
 
 Hex_Editor::Hex_Editor (const char* window_name, const std::size_t total_mem_size, const std::size_t begin, const std::size_t end, const std::size_t type_size,  void * const buffer)
@@ -17,11 +37,15 @@ Hex_Editor::Hex_Editor (const char* window_name, const std::size_t total_mem_siz
     for (auto i = total_mem_size - 1; i > 0; i >>= 4)
         ++sizes.address_padding;
 
-    lookup_buffer = std::vector <char> (sizes.address_padding);
+    lookup_buffer = std::vector <char> (sizes.address_padding + 1);
 
     this->sizes.row_width = 16;
     this->sizes.scroll_bar_width = 20.f;
     selected_value = 0;
+    selected_index = 0;
+    lookup = false;
+    editing = none;
+    edit_focus = false;
 }
 
 // this took a looooooong time of messing around with to figure out
@@ -55,19 +79,53 @@ void Hex_Editor::draw_column_labels ()
     ImGui::Separator();
 }
 
+float Hex_Editor::byte_x (const std::size_t col) const
+{
+    float x = (sizes.address_text_width + sizes.glyph_width) + (sizes.byte_text_width + sizes.glyph_width) * col;
+    if (col >= 8)
+        x += sizes.glyph_width;
+    return x;
+}
+
+std::size_t Hex_Editor::hit_test (const ImVec2& point, const std::size_t row_n) const
+{
+    const float line_height = ImGui::GetTextLineHeightWithSpacing();
+    const float stride = sizes.byte_text_width + sizes.glyph_width;
+
+    if (point.y < 0 || point.y >= row_n * line_height)
+        return none;
+
+    // undo the gap after the 8th column, the gap itself belongs to no cell
+    float x = point.x - byte_x (0);
+    if (x >= stride * 8)
+    {
+        x -= sizes.glyph_width;
+        if (x < stride * 8)
+            return none;
+    }
+
+    if (x < 0 || x >= stride * sizes.row_width || std::fmod (x, stride) >= sizes.byte_text_width)
+        return none;
+
+    const std::size_t index = static_cast <std::size_t> (point.y / line_height) * sizes.row_width + static_cast <std::size_t> (x / stride);
+    return index < view.size() ? index : none;
+}
+
+void Hex_Editor::select (const std::size_t index)
+{
+    selected_index = index;
+    selected_value = view[index];
+}
+
 void Hex_Editor::present (void)
 {
-    static constexpr ImGuiInputTextFlags input_text_flags = ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_AutoSelectAll | ImGuiInputTextFlags_CallbackAlways;
     static constexpr ImGuiWindowFlags window_flags = ImGuiWindowFlags_AlwaysAutoResize;
 
     static constexpr ImVec4 scrollbar_backGroundColor {0.2f, 0.2f, 0.2f, 1.0f};
     static constexpr ImVec4 scrollbar_grabber         {0.4f, 0.4f, 0.4f, 1.0f};
     static constexpr ImVec4 scrollbar_grabberHover    {0.6f, 0.6f, 0.6f, 1.0f};
     static constexpr ImVec4 scrollbar_grabberActive   {0.8f, 0.0f, 0.0f, 1.0f};
-    static constexpr ImVec4 white                     {1,1,1,1};
 
-    [[maybe_unused]] static float scrollY = 0.0f;
-    
     calc();
 
     // ImGui::SetNextWindowSize({this->sizes.min_window_width, 0});
@@ -80,69 +138,143 @@ void Hex_Editor::present (void)
     ImGui::PushStyleVar(ImGuiStyleVar_ScrollbarRounding, 0);
     ImGui::PushStyleVar(ImGuiStyleVar_ScrollbarSize, this->sizes.scroll_bar_width);
     ImGui::BeginChild ("list",{0, ImGui::GetTextLineHeightWithSpacing() * 16});
-    ImGuiListClipper clipper;
 
-    clipper.Begin(this->view.size() / this->sizes.row_width, ImGui::GetTextLineHeightWithSpacing());
+    const float line_height = ImGui::GetTextLineHeightWithSpacing();
+    const std::size_t row_width = this->sizes.row_width;
+    const std::size_t row_n = (this->view.size() + row_width - 1) / row_width;
+
     if (lookup)
     {
         int val = std::strtol (lookup_buffer.data(), nullptr, 16);
-        ImGui::SetScrollY((std::floor(val / this->sizes.row_width)) * ImGui::GetTextLineHeightWithSpacing());
+        ImGui::SetScrollY((std::floor(val / this->sizes.row_width)) * line_height);
         lookup = false;
     }
 
-    while (clipper.Step())
+    // row 0's top left, already scrolled
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const float ascii_x = byte_x (row_width - 1) + this->sizes.byte_text_width + this->sizes.glyph_width * 2;
+
+    // only the rows in view
+    const std::size_t first = static_cast <std::size_t> (std::max (0.f, ImGui::GetScrollY() / line_height));
+    const std::size_t last  = std::min (row_n, first + static_cast <std::size_t> (ImGui::GetWindowHeight() / line_height) + 2);
+
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    const ImU32 text_color     = IM_COL32_WHITE;
+    const ImU32 zero_color     = ImGui::GetColorU32 (ImGuiCol_TextDisabled);
+    const ImU32 selected_color = ImGui::GetColorU32 (ImGuiCol_TextSelectedBg);
+    const ImU32 hovered_color  = ImGui::GetColorU32 (ImGuiCol_FrameBgHovered);
+
+    const auto cell_min = [&] (const std::size_t index)
+    {
+        return ImVec2 {origin.x + byte_x (index % row_width), origin.y + (index / row_width) * line_height};
+    };
+
+    const auto highlight = [&] (const std::size_t index, const ImU32 color)
+    {
+        const ImVec2 min = cell_min (index);
+        draw_list->AddRectFilled (min, {min.x + this->sizes.byte_text_width, min.y + this->sizes.glyph_height}, color);
+    };
+
+    std::size_t hovered = none;
+    if (ImGui::IsWindowHovered())
     {
-        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+        const ImVec2 mouse = ImGui::GetMousePos();
+        hovered = hit_test ({mouse.x - origin.x, mouse.y - origin.y}, row_n);
+
+        if (hovered != none && ImGui::IsMouseClicked (ImGuiMouseButton_Left) && hovered != editing)
+        {
+            select (hovered);
+            editing = hovered;
+            edit_focus = true;
+            std::copy_n (&hex_glyphs[this->view[hovered] * 2], 2, edit_buffer);
+            edit_buffer[2] = '\0';
+        }
+    }
+
+    // the bytes can change under the window (the emulator, a rom reload)
+    if (selected_index < this->view.size())
+        selected_value = this->view[selected_index];
+
+    if (selected_index < this->view.size() && selected_index / row_width >= first && selected_index / row_width < last)
+        highlight (selected_index, selected_color);
+    if (hovered != none && hovered != selected_index)
+        highlight (hovered, hovered_color);
+
+    char address[sizeof(std::size_t) * 2 + 1];
+    char ascii[64];
+
+    for (std::size_t row = first; row < last; ++row)
+    {
+        const float y = origin.y + row * line_height;
+        const std::size_t begin = row * row_width;
+        const std::size_t end = std::min (begin + row_width, this->view.size());
+
+        std::size_t value = begin + offset;
+        for (int i = this->sizes.address_padding - 1; i >= 0; --i, value >>= 4)
+            address[i] = hex_glyphs[(value & 15) * 2 + 1];
+        address[this->sizes.address_padding] = ':';
+        draw_list->AddText ({origin.x, y}, text_color, address, address + this->sizes.address_padding + 1);
+
+        for (std::size_t index = begin; index < end; ++index)
+        {
+            const std::uint8_t byte = this->view[index];
+            ascii[index - begin] = byte >= 32 && byte < 127 ? static_cast <char> (byte) : '.';
+
+            // the cell being edited is the InputText's
+            if (index == editing)
+                continue;
+
+            const char* glyphs = &hex_glyphs[byte * 2];
+            draw_list->AddText ({origin.x + byte_x (index - begin), y}, byte == 0x00 ? zero_color : text_color, glyphs, glyphs + 2);
+        }
+
+        draw_list->AddText ({origin.x + ascii_x, y}, text_color, ascii, ascii + (end - begin));
+    }
+
+    // the scroll range
+    ImGui::Dummy ({ascii_x + this->sizes.ascii_col_width, row_n * line_height});
+
+    if (editing != none)
+    {
+        static constexpr ImGuiInputTextFlags edit_flags = ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CharsHexadecimal | ImGuiInputTextFlags_AutoSelectAll;
+
+        ImGui::SetCursorScreenPos (cell_min (editing));
+        ImGui::SetNextItemWidth (this->sizes.byte_text_width);
+        if (edit_focus)
         {
-            ImGui::Text ("%.*zX:", this->sizes.address_padding, (row * this->sizes.row_width) + offset);
-            for (std::size_t col = 0; col < 16; col++)
+            ImGui::SetKeyboardFocusHere ();
+            edit_focus = false;
+        }
+
+        ImGui::PushStyleVar (ImGuiStyleVar_FramePadding, {0, 0});
+        ImGui::PushStyleColor (ImGuiCol_FrameBg, ImVec4 (0, 0, 0, 0));
+
+        if (ImGui::InputText ("##edit", edit_buffer, sizeof(edit_buffer), edit_flags))
+        {
+            if (edit_buffer[0])
             {
-                std::size_t index = row * this->sizes.row_width + col;
-                float byte_pos_x = (this->sizes.address_text_width + this->sizes.glyph_width) + (this->sizes.byte_text_width +  this->sizes.glyph_width) * col;
-                if (col >= 8)
-                    byte_pos_x += this->sizes.glyph_width;
-
-                ImGui::PushID(index);
-                auto value = this->view[index];
-                ImGui::SameLine(byte_pos_x);
-                ImGui::SetNextItemWidth(this->sizes.byte_text_width);
-                ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, {0,0});
-                ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0,0,0,0));
-
-                User_Data user_data{};
-                snprintf(user_data.buffer, sizeof(user_data.buffer), "%02X", value);
-                ImGui::PushStyleColor(ImGuiCol_Text, this->view[index] == 0x00 ? ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled) : white);
-                if(ImGui::InputText("##input", user_data.buffer, sizeof(user_data.buffer), input_text_flags, Hex_Editor::input_callback, &user_data))
-                {
-                    auto value = std::strtol(user_data.buffer, NULL, 16);
-                    this->view[row * this->sizes.row_width + col] = value;
-                }
-                if(user_data.set)
-                {
-                    selected_value = this->view[index];
-                    selected_index = index;
-                    ImGui::PopStyleColor();
-                }
-                ImGui::PopStyleColor();
-                ImGui::PopStyleVar();
-                ImGui::PopStyleColor();
-                ImGui::PopID();
+                this->view[editing] = static_cast <std::uint8_t> (std::strtol (edit_buffer, nullptr, 16));
+                if (write_callback)
+                    write_callback (editing + offset);
             }
 
-            ImGui::SameLine(0, this->sizes.glyph_width*2);
-            
-            for (std::size_t i = 0; i < (std::size_t)this->sizes.row_width; i++)
+            // on to the next byte, like typing into a hex editor should
+            if (editing + 1 < this->view.size())
             {
-                char value = this->view[row * this->sizes.row_width + i];
-                if (value >= 32)
-                    ImGui::Text ("%c", value);
-                else
-                    ImGui::Text (".");
-                ImGui::SameLine(0,0);
+                ++editing;
+                select (editing);
+                edit_focus = true;
+                std::copy_n (&hex_glyphs[this->view[editing] * 2], 2, edit_buffer);
             }
-            ImGui::NewLine();
-            scrollY = ImGui::GetScrollY();
+            else
+                editing = none;
         }
+        // escape, tab or a click somewhere else
+        else if (!edit_focus && ImGui::IsItemDeactivated ())
+            editing = none;
+
+        ImGui::PopStyleColor ();
+        ImGui::PopStyleVar ();
     }
 
     ImGui::EndChild();
@@ -177,19 +309,7 @@ void Hex_Editor::present (void)
     ImGui::End();
 }
 
-int Hex_Editor::input_callback(ImGuiInputTextCallbackData* data)
+void Hex_Editor::set_write_callback (std::function <void (std::size_t)> callback)
 {
-    User_Data* user_data = (User_Data*)data->UserData;
-    user_data->set = ImGui::IsItemActive();
-    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(255, 255, 255, 255));
-
-    if (data->SelectionStart == 0 && data->SelectionEnd == data->BufTextLen)
-    {
-        data->DeleteChars(0, data->BufTextLen);
-        data->InsertChars(0, user_data->buffer);
-        data->SelectionStart = 0;
-        data->SelectionEnd = 2;
-        data->CursorPos = 0;
-    }
-    return 0;
-}
\ No newline at end of file
+    write_callback = std::move (callback);
+}
@@ -0,0 +1,223 @@
+#include "ppu_viewer.h"
+#include "imgui.h"
+#include <cstdint>
+
+#if defined(IMGUI_IMPL_OPENGL_ES2)
+#include <SDL_opengles2.h>
+#else
+#include <SDL_opengl.h>
+#endif
+
+namespace
+{
+    GLuint create_texture (const int width, const int height)
+    {
+        GLuint texture = 0;
+        glGenTextures (1, &texture);
+        glBindTexture (GL_TEXTURE_2D, texture);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        return texture;
+    }
+
+    ImTextureID to_imgui (const GLuint texture)
+    {
+        return (ImTextureID)(std::intptr_t) texture;
+    }
+}
+
+Pattern_Viewer::Pattern_Viewer (const char* window_name, PPU::CHR_Cache& _cache, const PPU::Palette& _palette)
+: name {window_name}
+, cache {_cache}
+, palette {_palette}
+, width {tiles_per_row * 8}
+, height {static_cast <int> ((cache.size() + tiles_per_row - 1) / tiles_per_row) * 8}
+, zoom {2}
+, texture {0}
+, seen (cache.size())
+, pixels (static_cast <std::size_t> (width * height))
+, stale {true}
+, colors {0x0F, 0x00, 0x10, 0x30}
+{}
+
+Pattern_Viewer::~Pattern_Viewer ()
+{
+    if (texture)
+        glDeleteTextures (1, &texture);
+}
+
+void Pattern_Viewer::upload (void)
+{
+    std::array <u32, 4> rgba;
+    for (std::size_t i = 0; i < rgba.size(); ++i)
+        rgba[i] = palette.get_color (colors[i]);
+
+    glBindTexture (GL_TEXTURE_2D, texture);
+    glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+
+    // colors changed or first upload, build the whole image and send it in one call
+    if (stale)
+    {
+        for (std::size_t index = 0; index < cache.size(); ++index)
+        {
+            seen[index] = cache.get_generation (index);
+            const auto& tile = cache.get_tile (index);
+            const std::size_t x = index % tiles_per_row * 8;
+            const std::size_t y = index / tiles_per_row * 8;
+
+            for (std::size_t row = 0; row < 8; ++row)
+                for (std::size_t col = 0; col < 8; ++col)
+                    pixels[(y + row) * width + x + col] = rgba[tile[row * 8 + col]];
+        }
+        glTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        stale = false;
+        return;
+    }
+
+    std::array <u32, 64> tile_pixels;
+
+    for (std::size_t index = 0; index < cache.size(); ++index)
+    {
+        const u32 generation = cache.get_generation (index);
+        if (seen[index] == generation)
+            continue;
+
+        seen[index] = generation;
+        const auto& tile = cache.get_tile (index);
+        for (std::size_t i = 0; i < tile.size(); ++i)
+            tile_pixels[i] = rgba[tile[i]];
+
+        const int x = static_cast <int> (index % tiles_per_row) * 8;
+        const int y = static_cast <int> (index / tiles_per_row) * 8;
+        glTexSubImage2D (GL_TEXTURE_2D, 0, x, y, 8, 8, GL_RGBA, GL_UNSIGNED_BYTE, tile_pixels.data());
+    }
+}
+
+void Pattern_Viewer::draw_tooltip (void)
+{
+    const ImVec2 min   = ImGui::GetItemRectMin();
+    const ImVec2 mouse = ImGui::GetMousePos();
+    const int tile_x = static_cast <int> ((mouse.x - min.x) / (8 * zoom));
+    const int tile_y = static_cast <int> ((mouse.y - min.y) / (8 * zoom));
+    const std::size_t index = static_cast <std::size_t> (tile_y * tiles_per_row + tile_x);
+
+    if (tile_x < 0 || tile_x >= tiles_per_row || tile_y < 0 || index >= cache.size())
+        return;
+
+    const float u = static_cast <float> (tile_x * 8) / width;
+    const float v = static_cast <float> (tile_y * 8) / height;
+
+    ImGui::BeginTooltip();
+    ImGui::Text ("tile %02zX (table %zu)", index % 256, index / 256);
+    ImGui::Text ("chr  %05zX", index * PPU::CHR_Cache::tile_bytes);
+    ImGui::Image (to_imgui (texture), {64, 64}, {u, v}, {u + 8.f / width, v + 8.f / height});
+    ImGui::EndTooltip();
+}
+
+void Pattern_Viewer::present (void)
+{
+    ImGui::Begin (name.c_str());
+
+    if (cache.size() == 0)
+    {
+        ImGui::Text ("no chr memory");
+        ImGui::End();
+        return;
+    }
+
+    if (!texture)
+        texture = create_texture (width, height);
+
+    ImGui::SetNextItemWidth (100);
+    ImGui::SliderInt ("zoom", &zoom, 1, 4);
+
+    for (std::size_t i = 0; i < colors.size(); ++i)
+    {
+        ImGui::SameLine();
+        ImGui::PushID (static_cast <int> (i));
+        ImGui::SetNextItemWidth (ImGui::CalcTextSize ("FF").x + ImGui::GetStyle().FramePadding.x * 2);
+        if (ImGui::InputScalar ("##color", ImGuiDataType_U8, &colors[i], nullptr, nullptr, "%02X", ImGuiInputTextFlags_CharsHexadecimal))
+        {
+            colors[i] &= 0x3F;
+            stale = true;
+        }
+        ImGui::PopID();
+    }
+
+    upload();
+
+    ImGui::BeginChild ("tiles");
+    ImGui::Image (to_imgui (texture), {static_cast <float> (width * zoom), static_cast <float> (height * zoom)});
+    if (ImGui::IsItemHovered())
+        draw_tooltip();
+    ImGui::EndChild();
+
+    ImGui::End();
+}
+
+Palette_Viewer::Palette_Viewer (const PPU::Palette& _palette)
+: palette {_palette}
+, texture {0}
+, emphasis {0}
+, stale {true}
+{}
+
+Palette_Viewer::~Palette_Viewer ()
+{
+    if (texture)
+        glDeleteTextures (1, &texture);
+}
+
+void Palette_Viewer::upload (void)
+{
+    std::array <u32, PPU::Palette::color_n> colors;
+    for (int i = 0; i < PPU::Palette::color_n; ++i)
+        colors[i] = palette.get_color (static_cast <u8> (i), static_cast <u8> (emphasis));
+
+    glBindTexture (GL_TEXTURE_2D, texture);
+    glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, 16, 4, GL_RGBA, GL_UNSIGNED_BYTE, colors.data());
+    stale = false;
+}
+
+void Palette_Viewer::present (void)
+{
+    static constexpr float swatch = 24.f;
+
+    ImGui::Begin ("Palette");
+
+    if (!texture)
+        texture = create_texture (16, 4);
+
+    ImGui::SetNextItemWidth (100);
+    if (ImGui::SliderInt ("emphasis", &emphasis, 0, PPU::Palette::emphasis_n - 1))
+        stale = true;
+
+    if (stale)
+        upload();
+
+    ImGui::Image (to_imgui (texture), {16 * swatch, 4 * swatch});
+    if (ImGui::IsItemHovered())
+    {
+        const ImVec2 min   = ImGui::GetItemRectMin();
+        const ImVec2 mouse = ImGui::GetMousePos();
+        const int x = static_cast <int> ((mouse.x - min.x) / swatch);
+        const int y = static_cast <int> ((mouse.y - min.y) / swatch);
+
+        if (x >= 0 && x < 16 && y >= 0 && y < 4)
+        {
+            const u8  index = static_cast <u8> (y * 16 + x);
+            const u32 color = palette.get_color (index, static_cast <u8> (emphasis));
+            const u8* rgb   = reinterpret_cast <const u8*> (&color);
+
+            ImGui::BeginTooltip();
+            ImGui::Text ("%02X  #%02X%02X%02X", index, rgb[0], rgb[1], rgb[2]);
+            ImGui::EndTooltip();
+        }
+    }
+
+    ImGui::End();
+}
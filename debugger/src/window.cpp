@@ -125,6 +125,12 @@ void Debugger::Window::update() const
 
 }
 
+void Debugger::Window::set_vsync (const bool enabled)
+{
+    if (SDL_GL_SetSwapInterval (enabled ? 1 : 0) < 0)
+        std::clog << "vsync: " << SDL_GetError() << std::endl;
+}
+
 SDL_Window* Debugger::Window::get_window () const
 {
     return window;
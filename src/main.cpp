@@ -1,15 +1,19 @@
 
 #include "debugger.h"
 #include "rom.h"
-#include "MOS6502.h"
+#include "system.h"
 
 int main()
 {
     NES_ROM rom{"/home/anthony/Workspace/cpp/6502/roms/Super_mario_brothers.nes"};
 
-    CPU::MOS6502 cpu {nullptr, nullptr};
+    // the debugger patches rom, take the private copies before anything holds bank pointers into the mapping
+    auto prg = rom.get_writable_prg();
+    auto chr = rom.get_writable_chr();
 
-    Debugger::NES_Data data {rom.get_prg_memory(), rom.get_chr_memory(), cpu};
+    auto system = NES_System::create(rom);
+
+    Debugger::NES_Data data {rom, prg, chr, rom.get_chr_cache(), *system};
 
     Debugger::GUI debugger {"Test", 1920, 1080, data};
 
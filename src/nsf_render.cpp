@@ -0,0 +1,240 @@
+#include "nsf.h"
+#include "audio_capture.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <syncstream>
+#include <thread>
+#include <vector>
+
+/*
+
+renders every track of the given NSF files to .wav (or raw pcm) without a
+window or an audio device. each track is an independent job, worker threads
+take them in turn, so a full soundtrack renders in about the time of its
+longest track divided by how fast one core runs the cpu and apu.
+
+    NSF_Render [-s seconds] [-r rate] [-j threads] [-f wav|raw] [-o dir] [-q seconds] [-t] file.nsf ...
+
+-t also writes every apu channel to its own file (name_01_pulse1.wav, ...)
+-q stops a track early after that many seconds of silence (0 never stops)
+-r goes up to 192000
+
+*/
+
+namespace
+{
+    struct Options
+    {
+        double seconds = 150.0;
+        int sample_rate = 48000;
+        unsigned threads = std::max (1u, std::thread::hardware_concurrency ());
+        APU::Wav_File::Format format = APU::Wav_File::Format::WAV;
+        std::filesystem::path out_dir = ".";
+        double silence_seconds = 3.0;
+        bool stems = false;
+        std::vector <std::string> files;
+    };
+
+    struct Job
+    {
+        std::shared_ptr <const NSF::File> file;
+        int track;
+    };
+
+    // a frame at this rate (about 3200 samples) fits the apu's 4096 sample buffer and render ()'s
+    constexpr int max_sample_rate = 192000;
+
+    [[noreturn]] void usage ()
+    {
+        std::cerr << "usage: NSF_Render [-s seconds] [-r rate] [-j threads] [-f wav|raw] [-o dir] [-q seconds] [-t] file.nsf ...\n";
+        std::exit (1);
+    }
+
+    // the whole value has to be a number, anything else is a usage error
+    int to_int (const std::string& value)
+    {
+        try
+        {
+            std::size_t used = 0;
+            const int number = std::stoi (value, &used);
+            if (used == value.size())
+                return number;
+        }
+        catch (const std::exception&)
+        {}
+        usage ();
+    }
+
+    double to_double (const std::string& value)
+    {
+        try
+        {
+            std::size_t used = 0;
+            const double number = std::stod (value, &used);
+            if (used == value.size())
+                return number;
+        }
+        catch (const std::exception&)
+        {}
+        usage ();
+    }
+
+    Options parse_options (int argc, char** argv)
+    {
+        Options options;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+
+            if (arg == "-t")
+                options.stems = true;
+            else if (arg.size() == 2 && arg[0] == '-')
+            {
+                if (i + 1 >= argc)
+                    usage ();
+
+                const std::string value = argv[++i];
+
+                switch (arg[1])
+                {
+                    case 's': options.seconds = to_double (value); break;
+                    case 'r': options.sample_rate = to_int (value); break;
+                    case 'j': options.threads = std::max (1, to_int (value)); break;
+                    case 'o': options.out_dir = value; break;
+                    case 'q': options.silence_seconds = to_double (value); break;
+                    case 'f':
+                        if (value == "wav")
+                            options.format = APU::Wav_File::Format::WAV;
+                        else if (value == "raw")
+                            options.format = APU::Wav_File::Format::RAW;
+                        else
+                            usage ();
+                    break;
+                    default: usage ();
+                }
+            }
+            else
+                options.files.push_back (arg);
+        }
+
+        if (options.files.empty() || options.seconds <= 0 || options.sample_rate <= 0 || options.sample_rate > max_sample_rate)
+            usage ();
+
+        return options;
+    }
+
+    // returns the seconds of audio written, the capture finishes its files when it goes out of scope
+    double render (const Job& job, const Options& options)
+    {
+        const std::string extension = options.format == APU::Wav_File::Format::WAV ? "wav" : "raw";
+        const auto stem = std::filesystem::path {job.file->path}.stem().string();
+        const auto path = options.out_dir / std::format ("{}_{:02}.{}", stem, job.track + 1, extension);
+
+        NSF::Player player {job.file, static_cast <double> (options.sample_rate)};
+        player.start_track (job.track);
+        player.get_apu ().enable_stems (options.stems);
+
+        // BLOCK, a regression render has to be complete
+        APU::Audio_Capture capture {path.string(), options.sample_rate, options.format, options.stems};
+
+        const u64 total   = static_cast <u64> (options.seconds * options.sample_rate);
+        const u64 silence = static_cast <u64> (options.silence_seconds * options.sample_rate);
+
+        std::array <i16, 4096> buffer;
+        u64 written = 0;
+        u64 quiet = 0;
+        bool heard = false;
+
+        while (written < total)
+        {
+            // whole frames only, so the stems stay the same length as the mix
+            const std::size_t n = player.run_frame (buffer);
+            const std::span <const i16> samples {buffer.data(), n};
+
+            capture.submit (APU::Audio_Capture::Track::MIX, samples);
+            if (options.stems)
+                capture.submit_stems (player.get_apu ());
+            written += n;
+
+            // tracks often start with a moment of silence, only cut once something has played
+            const bool loud = std::any_of (samples.begin(), samples.end(), [] (const i16 sample) { return sample > 64 || sample < -64; });
+            heard = heard || loud;
+            quiet = loud ? 0 : quiet + n;
+
+            if (heard && silence && quiet >= silence)
+                break;
+        }
+
+        std::osyncstream {std::cout} << path.string() << "  " << job.file->name << " #" << job.track + 1 << "\n";
+
+        return static_cast <double> (written) / options.sample_rate;
+    }
+}
+
+int main (int argc, char** argv)
+{
+    const Options options = parse_options (argc, argv);
+
+    std::vector <Job> jobs;
+
+    for (const auto& path : options.files)
+    {
+        try
+        {
+            const auto file = std::make_shared <const NSF::File> (path);
+
+            for (int track = 0; track < file->track_n; ++track)
+                jobs.push_back ({file, track});
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << "\n";
+        }
+    }
+
+    std::filesystem::create_directories (options.out_dir);
+
+    std::atomic <std::size_t> next_job {0};
+    std::atomic <u64> audio_ms {0};
+    std::atomic <int> failed {0};
+
+    const auto start = std::chrono::steady_clock::now ();
+
+    {
+        std::vector <std::jthread> workers;
+
+        for (unsigned i = 0; i < std::min <std::size_t> (options.threads, jobs.size()); ++i)
+        {
+            workers.emplace_back ([&]
+            {
+                for (std::size_t index = next_job++; index < jobs.size(); index = next_job++)
+                {
+                    try
+                    {
+                        audio_ms += static_cast <u64> (render (jobs[index], options) * 1000.0);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        std::osyncstream {std::cerr} << e.what() << "\n";
+                        ++failed;
+                    }
+                }
+            });
+        }
+    }
+
+    const double wall = std::chrono::duration <double> (std::chrono::steady_clock::now () - start).count();
+    const double audio = audio_ms / 1000.0;
+
+    std::cout << std::format ("{} tracks, {:.1f} s of audio in {:.2f} s ({:.0f}x real time)\n", jobs.size(), audio, wall, wall > 0 ? audio / wall : 0.0);
+
+    return failed ? 1 : 0;
+}
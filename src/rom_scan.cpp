@@ -0,0 +1,92 @@
+#include "rom_library.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+
+updates a rom library index and optionally lists it
+
+    ROM_Scan [-i index] [-j threads] [-l] directory ...
+
+the index defaults to roms.idx in the working directory. -l prints one line
+per rom: crc32, sha1, mapper.submapper, format, prg / chr KB, path
+
+*/
+
+namespace
+{
+    void usage ()
+    {
+        std::cerr << "usage: ROM_Scan [-i index] [-j threads] [-l] directory ...\n";
+        std::exit (1);
+    }
+}
+
+int main (int argc, char** argv)
+{
+    std::string index = "roms.idx";
+    unsigned threads = 0;
+    bool list = false;
+    std::vector <std::string> directories;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "-l")
+            list = true;
+        else if ((arg == "-i" || arg == "-j") && i + 1 < argc)
+        {
+            if (arg == "-i")
+                index = argv[++i];
+            else
+                threads = static_cast <unsigned> (std::stoi (argv[++i]));
+        }
+        else if (!arg.empty() && arg[0] == '-')
+            usage ();
+        else
+            directories.push_back (arg);
+    }
+
+    if (directories.empty())
+        usage ();
+
+    const auto start = std::chrono::steady_clock::now ();
+
+    ROM_Library library {index};
+
+    const auto total = library.scan (directories, threads);
+
+    try
+    {
+        library.save ();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    const double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now () - start).count();
+
+    if (list)
+    {
+        static constexpr const char* format_names[] {"invalid", "ines", "nes2"};
+
+        for (const auto& entry : library.get_entries ())
+        {
+            std::printf ("%08X  %s  %3u.%-2u  %-7s  %4u / %4u  %s\n",
+                entry.crc32, Hash::to_hex (entry.sha1).c_str(), entry.mapper, entry.submapper,
+                format_names[static_cast <int> (entry.format)], entry.prg_size / 1024, entry.chr_size / 1024, entry.path.c_str());
+        }
+    }
+
+    std::printf ("%zu roms, %zu hashed (%.1f MB), %zu from the index, %zu unreadable, %.2f s\n",
+        total.files, total.hashed, total.bytes_hashed / 1e6, total.reused, total.failed, seconds);
+
+    return total.failed ? 1 : 0;
+}